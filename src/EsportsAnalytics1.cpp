@@ -1,6 +1,4 @@
 #include "EsportsAnalytics1.hpp"
-#include <fstream>
-#include <sstream>
 #include <iostream>
 #include <cstring>    // for std::strcmp
 
@@ -25,61 +23,37 @@ namespace EsportsAnalytics {
     RecentMatches recentMatchOutcomes;
 
 
-    // loadAllMatchOutcomes: read every line from 'filename' (match.csv)
-    // skip header, parse 12 comma-separated fields per line,
-    // convert scores to ints, then store in allMatches array
+    // loadAllMatchOutcomes: stream 'filename' (match.csv) one row at a time,
+    // skipping the header, and store up to MAX_TOTAL_MATCHES rows in allMatches
     int loadAllMatchOutcomes(const char* filename) {
-        std::ifstream inFile(filename);
-        if (!inFile.is_open()) {
+        flushWriteAheadLog(); // this reads the file directly, so apply queued toolkit writes first
+        CsvReader reader;
+        if (reader.openPath(filename) != 0) {
             std::cerr << "ERROR: Cannot open " << filename << "\n";
             return -1;
         }
 
-        // skip header row
-        std::string line;
-        if (!std::getline(inFile, line)) {
-            std::cerr << "ERROR: " << filename << " appears empty.\n";
-            return -1;
-        }
-
         int idx = 0;
-        while (idx < MAX_TOTAL_MATCHES && std::getline(inFile, line)) {
-            std::stringstream ss(line);
-            std::string tokens[12];
-
-            // split line into exactly 12 tokens
-            for (int i = 0; i < 12; ++i) {
-                if (!std::getline(ss, tokens[i], ',')) {
-                    tokens[i].clear();
-                }
-            }
-
-            // convert the two score fields to integers
-            int t1s = std::stoi(tokens[8]);
-            int t2s = std::stoi(tokens[9]);
-
-            // construct a MatchOutcome with deep-copied strings
-            MatchOutcome mo(
-                tokens[0].c_str(),  // match_id
-                tokens[1].c_str(),  // scheduled_date
-                tokens[2].c_str(),  // scheduled_time
-                tokens[3].c_str(),  // actual_start_time
-                tokens[4].c_str(),  // actual_end_time
-                tokens[5].c_str(),  // team1_id
-                tokens[6].c_str(),  // team2_id
-                tokens[7].c_str(),  // winner_team_id
-                t1s,                // team1_score
-                t2s,                // team2_score
-                tokens[10].c_str(), // match_status
-                tokens[11].c_str()  // match_level
+        while (idx < MAX_TOTAL_MATCHES && reader.next()) {
+            // columns are looked up by header name, so their order in the file does not matter
+            allMatches[idx] = MatchOutcome(
+                cellText(reader, Matches::MatchId),
+                cellText(reader, Matches::ScheduledDate),
+                cellText(reader, Matches::ScheduledTime),
+                cellText(reader, Matches::ActualStartTime),
+                cellText(reader, Matches::ActualEndTime),
+                cellText(reader, Matches::Team1Id),
+                cellText(reader, Matches::Team2Id),
+                cellText(reader, Matches::WinnerTeamId),
+                cellInt(reader, Matches::Team1Score),
+                cellInt(reader, Matches::Team2Score),
+                cellText(reader, Matches::MatchStatus),
+                cellText(reader, Matches::MatchLevel)
             );
-
-            allMatches[idx] = mo;  // store in global array
             ++idx;
         }
 
         totalMatchesLoaded = idx;
-        inFile.close();
         return totalMatchesLoaded;
     }
 
@@ -94,7 +68,7 @@ namespace EsportsAnalytics {
                 << "[" << (i+1) << "] "
                 << "id="   << (m.match_id          ? m.match_id          : "") << "  "
                 << "date=" << (m.scheduled_date    ? m.scheduled_date    : "") << "  "
-                << "time=" << (m.scheduled_time    ? m.scheduled_time    : "") << "  "
+                << "time=" << m.scheduled_time << "  "
                 << "teams="<< (m.team1_id          ? m.team1_id          : "") << "(" << m.team1_score << ") vs "
                           << (m.team2_id          ? m.team2_id          : "") << "(" << m.team2_score << ")  "
                 << "winner=" << (m.winner_team_id  ? m.winner_team_id   : "") << "  "
@@ -149,7 +123,7 @@ namespace EsportsAnalytics {
                 << "[" << (i+1) << "] "
                 << "id="   << (m.match_id          ? m.match_id          : "") << "  "
                 << "date=" << (m.scheduled_date    ? m.scheduled_date    : "") << "  "
-                << "time=" << (m.scheduled_time    ? m.scheduled_time    : "") << "  "
+                << "time=" << m.scheduled_time << "  "
                 << "teams="<< (m.team1_id          ? m.team1_id          : "") << "(" << m.team1_score << ") vs "
                           << (m.team2_id          ? m.team2_id          : "") << "(" << m.team2_score << ")  "
                 << "winner=" << (m.winner_team_id  ? m.winner_team_id   : "") << "  "
@@ -160,60 +134,33 @@ namespace EsportsAnalytics {
     }
 
 
-    // loadAllGameStats: read every line from 'filename' (player_match_stats.csv)
-    // skip header, parse 8 comma-separated fields, convert numbers, store in allGameStats[]
+    // loadAllGameStats: stream 'filename' (player_match_stats.csv) one row at a
+    // time through a fixed-size buffer, so even a multi-season export is read in
+    // constant memory; up to MAX_TOTAL_STATS rows are kept in allGameStats[]
     int loadAllGameStats(const char* filename) {
-        std::ifstream inFile(filename);
-        if (!inFile.is_open()) {
+        flushWriteAheadLog(); // this reads the file directly, so apply queued toolkit writes first
+        CsvReader reader;
+        if (reader.openPath(filename) != 0) {
             std::cerr << "ERROR: Cannot open " << filename << "\n";
             return -1;
         }
 
-        // skip header row
-        std::string line;
-        if (!std::getline(inFile, line)) {
-            std::cerr << "ERROR: " << filename << " appears empty.\n";
-            return -1;
-        }
-
         int idx = 0;
-        while (idx < MAX_TOTAL_STATS && std::getline(inFile, line)) {
-            std::stringstream ss(line);
-            std::string tokens[8];
-
-            // split into exactly 8 fields:
-            // match_id, in-game-name, hero_played, kills, deaths, assists, gpm, xpm
-            for (int i = 0; i < 8; ++i) {
-                if (!std::getline(ss, tokens[i], ',')) {
-                    tokens[i].clear();
-                }
-            }
-
-            // convert numeric fields
-            int kills   = std::stoi(tokens[3]);
-            int deaths  = std::stoi(tokens[4]);
-            int assists = std::stoi(tokens[5]);
-            int gpm     = std::stoi(tokens[6]);
-            int xpm     = std::stoi(tokens[7]);
-
-            // construct a GameStat with deep-copied strings
-            GameStat gs(
-                tokens[0].c_str(),  // match_id
-                tokens[1].c_str(),  // in-game-name
-                tokens[2].c_str(),  // hero_played
-                kills,
-                deaths,
-                assists,
-                gpm,
-                xpm
+        while (idx < MAX_TOTAL_STATS && reader.next()) {
+            allGameStats[idx] = GameStat(
+                cellText(reader, GameStats::MatchId),
+                cellText(reader, GameStats::InGameName),
+                cellText(reader, GameStats::HeroPlayed),
+                cellInt(reader, GameStats::Kills),
+                cellInt(reader, GameStats::Deaths),
+                cellInt(reader, GameStats::Assists),
+                cellInt(reader, GameStats::Gpm),
+                cellInt(reader, GameStats::Xpm)
             );
-
-            allGameStats[idx] = gs;  // store in global array
             ++idx;
         }
 
         totalGameStatsLoaded = idx;
-        inFile.close();
         return totalGameStatsLoaded;
     }
 
@@ -226,16 +173,18 @@ namespace EsportsAnalytics {
             return;
         }
 
+        // the loaded names and ids are interned, so lookups below compare pointers;
+        // a name that was never interned cannot match any loaded stat
+        const char* wantedName = StringPool::instance().find(playerName);
         bool foundAny = false;
-        for (int i = 0; i < totalGameStatsLoaded; ++i) {
+        for (int i = 0; i < totalGameStatsLoaded && wantedName; ++i) {
             const GameStat &gs = allGameStats[i];
-            if (gs.InGameName && std::strcmp(gs.InGameName, playerName) == 0) {
+            if (gs.InGameName == wantedName) {
                 // found a matching stat; now find match details by match_id
                 const char* mid = gs.match_id;
                 const MatchOutcome* moPtr = nullptr;
                 for (int j = 0; j < totalMatchesLoaded; ++j) {
-                    if (allMatches[j].match_id &&
-                        std::strcmp(allMatches[j].match_id, mid) == 0)
+                    if (allMatches[j].match_id == mid)
                     {
                         moPtr = &allMatches[j];
                         break;
@@ -384,7 +333,7 @@ namespace EsportsAnalytics {
     // loads match.csv, shows all matches, prompts how many to log,
     // then builds the loggedStack via logRecentMatches()
     void logNewMatchOutcome() {
-        int loaded = loadAllMatchOutcomes("../data/match.csv");
+        int loaded = loadAllMatchOutcomes(DataStore::instance().pathOf("match.csv").string().c_str());
         if (loaded < 0) {
             displaySystemMessage("failed to load match.csv", 2);
             return;
@@ -412,7 +361,7 @@ namespace EsportsAnalytics {
     // viewFullMatchOutcomes: option 3 in submenu
     // reloads match.csv and prints all matches in file order
     void viewFullMatchOutcomes() {
-        int loaded = loadAllMatchOutcomes("../data/match.csv");
+        int loaded = loadAllMatchOutcomes(DataStore::instance().pathOf("match.csv").string().c_str());
         if (loaded < 0) {
             displaySystemMessage("failed to load match.csv", 2);
             return;
@@ -428,12 +377,12 @@ namespace EsportsAnalytics {
     // first loads both match.csv and gameStat.csv,
     // then presents a small sub-menu: 4A = lookup by name, 4B = sort by metric
     void analyzePlayerPerformance() {
-        int loadedMatches = loadAllMatchOutcomes("../data/match.csv");
+        int loadedMatches = loadAllMatchOutcomes(DataStore::instance().pathOf("match.csv").string().c_str());
         if (loadedMatches < 0) {
             displaySystemMessage("failed to load match.csv", 2);
             return;
         }
-        int loadedStats = loadAllGameStats("../data/gameStat.csv");
+        int loadedStats = loadAllGameStats(DataStore::instance().pathOf("gameStat.csv").string().c_str());
         if (loadedStats < 0) {
             displaySystemMessage("failed to load gameStat.csv", 2);
             return;
@@ -2,6 +2,7 @@
 #define ESPORTS_ANALYTICS_HPP
 
 #include "File_exe.hpp"
+#include "EsportsTables.hpp"
 using namespace CsvToolkit;
 
 #include <cstring>
@@ -18,33 +19,32 @@ namespace EsportsAnalytics {
     //     return dst;
     // }
 
-    // struct to hold one line from match.csv
+    // struct to hold one line from match.csv; ids, statuses and levels are
+    // interned (see StringPool), so copies share them and nothing needs
+    // freeing; times vary too much to pool and are owned std::strings
     // fields correspond to each column:
     //   match_id, scheduled_date, scheduled_time,
     //   actual_start_time, actual_end_time,
     //   team1_id, team2_id, winner_team_id,
     //   team1_score, team2_score, match_status, match_level
     struct MatchOutcome {
-        char* match_id;           // unique id for this match
-        char* scheduled_date;     // date when match was scheduled
-        char* scheduled_time;     // time when match was scheduled
-        char* actual_start_time;  // time match actually started
-        char* actual_end_time;    // time match ended
-        char* team1_id;           // identifier for team1
-        char* team2_id;           // identifier for team2
-        char* winner_team_id;     // id of the winning team
-        int   team1_score;        // score of team1
-        int   team2_score;        // score of team2
-        char* match_status;       // e.g. "Completed", "Cancelled"
-        char* match_level;        // e.g. "Group Stage", "Quarterfinal"
+        const char* match_id;           // unique id for this match
+        const char* scheduled_date;     // date when match was scheduled
+        std::string scheduled_time;     // time when match was scheduled
+        std::string actual_start_time;  // time match actually started
+        std::string actual_end_time;    // time match ended
+        const char* team1_id;           // identifier for team1
+        const char* team2_id;           // identifier for team2
+        const char* winner_team_id;     // id of the winning team
+        int         team1_score;        // score of team1
+        int         team2_score;        // score of team2
+        const char* match_status;       // e.g. "Completed", "Cancelled"
+        const char* match_level;        // e.g. "Group Stage", "Quarterfinal"
 
         // default constructor: initialize pointers to nullptr, ints to zero
         MatchOutcome()
             : match_id(nullptr),
               scheduled_date(nullptr),
-              scheduled_time(nullptr),
-              actual_start_time(nullptr),
-              actual_end_time(nullptr),
               team1_id(nullptr),
               team2_id(nullptr),
               winner_team_id(nullptr),
@@ -54,7 +54,7 @@ namespace EsportsAnalytics {
               match_level(nullptr)
         {}
 
-        // parameterized constructor: deep-copy each string and set scores
+        // parameterized constructor: intern ids and statuses, copy times, set scores
         MatchOutcome(const char* mid,
                      const char* schDate,
                      const char* schTime,
@@ -67,94 +67,35 @@ namespace EsportsAnalytics {
                      int         t2s,
                      const char* mStatus,
                      const char* mLevel)
-            : match_id(duplicateString(mid)),
-              scheduled_date(duplicateString(schDate)),
-              scheduled_time(duplicateString(schTime)),
-              actual_start_time(duplicateString(asTime)),
-              actual_end_time(duplicateString(aeTime)),
-              team1_id(duplicateString(t1id)),
-              team2_id(duplicateString(t2id)),
-              winner_team_id(duplicateString(wtid)),
+            : match_id(internString(mid)),
+              scheduled_date(internString(schDate)),
+              scheduled_time(schTime ? schTime : ""),
+              actual_start_time(asTime ? asTime : ""),
+              actual_end_time(aeTime ? aeTime : ""),
+              team1_id(internString(t1id)),
+              team2_id(internString(t2id)),
+              winner_team_id(internString(wtid)),
               team1_score(t1s),
               team2_score(t2s),
-              match_status(duplicateString(mStatus)),
-              match_level(duplicateString(mLevel))
+              match_status(internString(mStatus)),
+              match_level(internString(mLevel))
         {}
-
-        // copy constructor: deep-copy all fields from another object
-        MatchOutcome(const MatchOutcome& other) {
-            match_id           = duplicateString(other.match_id);
-            scheduled_date     = duplicateString(other.scheduled_date);
-            scheduled_time     = duplicateString(other.scheduled_time);
-            actual_start_time  = duplicateString(other.actual_start_time);
-            actual_end_time    = duplicateString(other.actual_end_time);
-            team1_id           = duplicateString(other.team1_id);
-            team2_id           = duplicateString(other.team2_id);
-            winner_team_id     = duplicateString(other.winner_team_id);
-            team1_score        = other.team1_score;
-            team2_score        = other.team2_score;
-            match_status       = duplicateString(other.match_status);
-            match_level        = duplicateString(other.match_level);
-        }
-
-        // assignment operator: free existing memory, then deep-copy
-        MatchOutcome& operator=(const MatchOutcome& other) {
-            if (this == &other) return *this;
-            delete[] match_id;
-            delete[] scheduled_date;
-            delete[] scheduled_time;
-            delete[] actual_start_time;
-            delete[] actual_end_time;
-            delete[] team1_id;
-            delete[] team2_id;
-            delete[] winner_team_id;
-            delete[] match_status;
-            delete[] match_level;
-
-            match_id           = duplicateString(other.match_id);
-            scheduled_date     = duplicateString(other.scheduled_date);
-            scheduled_time     = duplicateString(other.scheduled_time);
-            actual_start_time  = duplicateString(other.actual_start_time);
-            actual_end_time    = duplicateString(other.actual_end_time);
-            team1_id           = duplicateString(other.team1_id);
-            team2_id           = duplicateString(other.team2_id);
-            winner_team_id     = duplicateString(other.winner_team_id);
-            team1_score        = other.team1_score;
-            team2_score        = other.team2_score;
-            match_status       = duplicateString(other.match_status);
-            match_level        = duplicateString(other.match_level);
-
-            return *this;
-        }
-
-        // destructor: free any allocated strings
-        ~MatchOutcome() {
-            delete[] match_id;
-            delete[] scheduled_date;
-            delete[] scheduled_time;
-            delete[] actual_start_time;
-            delete[] actual_end_time;
-            delete[] team1_id;
-            delete[] team2_id;
-            delete[] winner_team_id;
-            delete[] match_status;
-            delete[] match_level;
-        }
     };
 
 
-    // struct to hold one line from player_match_stats.csv (gameStat.csv)
+    // struct to hold one line from player_match_stats.csv (gameStat.csv);
+    // strings are interned like MatchOutcome's
     // fields correspond to columns:
     //   match_id, in-game-name, hero_played, kills, deaths, assists, gpm, xpm
     struct GameStat {
-        char* match_id;     // id of the match this stat belongs to
-        char* InGameName;   // player's identifier (nickname)
-        char* hero_played;  // name of hero or character used
-        int   kills;        // number of kills in this match
-        int   deaths;       // number of deaths in this match
-        int   assists;      // number of assists in this match
-        int   gpm;          // gold-per-minute stat
-        int   xpm;          // xp-per-minute stat
+        const char* match_id;           // id of the match this stat belongs to
+        const char* InGameName;         // player's identifier (nickname)
+        const char* hero_played;        // name of hero or character used
+        int         kills;              // number of kills in this match
+        int         deaths;             // number of deaths in this match
+        int         assists;            // number of assists in this match
+        int         gpm;                // gold-per-minute stat
+        int         xpm;                // xp-per-minute stat
 
         // default constructor: pointers to nullptr, ints to zero
         GameStat()
@@ -168,7 +109,7 @@ namespace EsportsAnalytics {
               xpm(0)
         {}
 
-        // parameterized constructor: deep-copy strings, set numeric fields
+        // parameterized constructor: intern strings, set numeric fields
         GameStat(const char* mid,
                  const char* igname,
                  const char* hero,
@@ -177,52 +118,15 @@ namespace EsportsAnalytics {
                  int         a,
                  int         gp,
                  int         xp)
-            : match_id(duplicateString(mid)),
-              InGameName(duplicateString(igname)),
-              hero_played(duplicateString(hero)),
+            : match_id(internString(mid)),
+              InGameName(internString(igname)),
+              hero_played(internString(hero)),
               kills(k),
               deaths(d),
               assists(a),
               gpm(gp),
               xpm(xp)
         {}
-
-        // copy constructor: deep-copy all fields
-        GameStat(const GameStat& other) {
-            match_id    = duplicateString(other.match_id);
-            InGameName  = duplicateString(other.InGameName);
-            hero_played = duplicateString(other.hero_played);
-            kills       = other.kills;
-            deaths      = other.deaths;
-            assists     = other.assists;
-            gpm         = other.gpm;
-            xpm         = other.xpm;
-        }
-
-        // assignment operator: free old, then deep-copy
-        GameStat& operator=(const GameStat& other) {
-            if (this == &other) return *this;
-            delete[] match_id;
-            delete[] InGameName;
-            delete[] hero_played;
-
-            match_id    = duplicateString(other.match_id);
-            InGameName  = duplicateString(other.InGameName);
-            hero_played = duplicateString(other.hero_played);
-            kills       = other.kills;
-            deaths      = other.deaths;
-            assists     = other.assists;
-            gpm         = other.gpm;
-            xpm         = other.xpm;
-            return *this;
-        }
-
-        // destructor: free any allocated strings
-        ~GameStat() {
-            delete[] match_id;
-            delete[] InGameName;
-            delete[] hero_played;
-        }
     };
 
 
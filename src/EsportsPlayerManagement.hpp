@@ -1,4 +1,5 @@
 #include "File_exe.hpp"
+#include "EsportsTables.hpp"
 
 using namespace std;
 using namespace CsvToolkit;
@@ -20,7 +21,7 @@ char** TeamRegistration() {
     // Auto-generate TeamID
     int maxTeamNum = 0;
     for (int i = 0; i < TeamList.y; ++i) {
-        std::string tid(TeamList.data[i][0]);
+        std::string tid(cellText(TeamList, i, Teams::TeamID));
         if (tid.length() > 1 && tid[0] == 'T') {
             int num = std::stoi(tid.substr(1));
             if (num > maxTeamNum) maxTeamNum = num;
@@ -72,7 +73,7 @@ char** PlayerRegistration(const char* teamID, const char* university, const char
 if (maxID == -1) {
         dataContainer2D playerList = getData(Players_CSV_FILE);
     for (int i = 0; i < playerList.y; ++i) {
-            std::string pid(playerList.data[i][0]);  // e.g., "P098"
+            std::string pid(cellText(playerList, i, Players::PlayerID));  // e.g., "P098"
         if (pid.length() > 1 && pid[0] == 'P') {
             int num = std::stoi(pid.substr(1));
             if (num > maxID) maxID = num;
@@ -206,14 +207,9 @@ void WholeRegistration() {
 
 void ViewPriorityList(){
 
-    const dataContainer2D WildCardList = Search1FieldValue(Teams_CSV_FILE, "TeamType"," Wildcard");
-    dataContainer2D SortedWCList = sortByTwoFields(WildCardList, "RegisterDate","RegisterTime", true);
-
-    dataContainer2D StandardList = Search1FieldValue(Teams_CSV_FILE, "TeamType", "Standard");
-    dataContainer2D SortedSTList = sortByTwoFields(StandardList, "RegisterDate","RegisterTime", true);
-
-    dataContainer2D EarlyBirdList = Search1FieldValue(Teams_CSV_FILE, "TeamType", "EarlyBird");
-    dataContainer2D SortedEBList = sortByTwoFields(EarlyBirdList, "RegisterDate","RegisterTime", true);
+    TableView SortedWCList = sortByTwoFieldsView(Search1FieldValueView(Teams_CSV_FILE, "TeamType"," Wildcard"), "RegisterDate","RegisterTime", true);
+    TableView SortedSTList = sortByTwoFieldsView(Search1FieldValueView(Teams_CSV_FILE, "TeamType", "Standard"), "RegisterDate","RegisterTime", true);
+    TableView SortedEBList = sortByTwoFieldsView(Search1FieldValueView(Teams_CSV_FILE, "TeamType", "EarlyBird"), "RegisterDate","RegisterTime", true);
 
     displayTabulatedData(SortedWCList);
     displayTabulatedData(SortedEBList);
@@ -242,24 +238,24 @@ void PromoteWaitingTeams() {
     int remainingSpots = TEAM_LIMIT - countEB;
     int promoted = 0;
 
+    // Team and player rows change together, so they are written in one transaction
+    Transaction promotion;
+    const char* teamStatusField = Teams::TeamStatus.name;
+    const char* registered = "Registered";
+    const char* eligibilityField = Players::EligibilityStatus.name;
+    const char* eligible = "Eligible";
+
     for (int i = 0; i < sortedStandard.y && promoted < remainingSpots; ++i) {
-        const char* teamID = sortedStandard.data[i][0];
+        const char* teamID = cellText(sortedStandard, i, Teams::TeamID);
 
         // Promote Standard team
-        dataContainer1D teamRow = queryKey(Teams_CSV_FILE, teamID);
-        if (!teamRow.error) {
-            teamRow.data[8] = duplicateString("Registered");  // TeamStatus
-            updateDataByUniqueKey(Teams_CSV_FILE, teamID, 0, teamRow.fields_count, const_cast<const char**>(teamRow.data));
-        }
-        deleteDataContainer1D(teamRow);
+        if (promotion.updateFieldsByKey(Teams_CSV_FILE, teamID, 1, &teamStatusField, &registered) != 0) continue;
 
         // Promote players of the team
-        dataContainer2D players = Search1FieldValue(Players_CSV_FILE, "TeamID", teamID);
-        for (int j = 0; j < players.y; ++j) {
-            players.data[j][10] = duplicateString("Eligible"); // EligibilityStatus
-            updateDataByUniqueKey(Players_CSV_FILE, players.data[j][0], 0, players.x, const_cast<const char**>(players.data[j]));
+        TableView players = Search1FieldValueView(Players_CSV_FILE, "TeamID", teamID);
+        for (int j = 0; j < players.y(); ++j) {
+            promotion.updateFieldsByKey(Players_CSV_FILE, cellText(players, j, Players::PlayerID), 1, &eligibilityField, &eligible);
         }
-        deleteDataContainer2D(players);
 
         promoted++;
     }
@@ -268,7 +264,11 @@ void PromoteWaitingTeams() {
     deleteDataContainer2D(registeredEB);
 
     if (promoted > 0) {
-        std::cout << promoted << " Standard team(s) promoted to Registered to fill quota.\n";
+        if (promotion.commit() == 0) {
+            std::cout << promoted << " Standard team(s) promoted to Registered to fill quota.\n";
+        } else {
+            std::cerr << "Error: Could not save the promoted teams.\n";
+        }
     }
 }
 
@@ -304,29 +304,16 @@ void Withdrawal() {
         }
 
         // Step 2: Update all players in the team to Withdrawn
-
-        if (team.error || team.y == 0) {
+        deleteDataContainer2D(team);
+        dataContainer2D teamPlayers = Search1FieldValue(Players_CSV_FILE, "TeamID", teamID);
+        if (teamPlayers.error || teamPlayers.y == 0) {
             std::cerr << "No players found for this team.\n";
         } else {
-            int eligibilityCol = -1;
-            for (int i = 0; i < team.x; ++i) {
-                if (strcmp(team.fields[i], "EligibilityStatus") == 0) {
-                    eligibilityCol = i;
-                    break;
-                }
+            for (int i = 0; i < teamPlayers.y; ++i) {
+                updateFieldByKey(Players_CSV_FILE, cellText(teamPlayers, i, Players::PlayerID), Players::EligibilityStatus.name, "Withdrawn");
             }
-
-            if (eligibilityCol == -1) {
-                std::cerr << "EligibilityStatus column not found in player.csv.\n";
-            } else {
-                for (int i = 0; i < team.y; ++i) {
-                    const char* playerID = team.data[i][0];  // assuming PlayerID is column 0
-                    updateFieldByKey(Players_CSV_FILE, playerID, "EligibilityStatus", "Withdrawn");
-                }
-            }
-
-            deleteDataContainer2D(team);
         }
+        deleteDataContainer2D(teamPlayers);
         PromoteWaitingTeams();
         displaySystemMessage("Team and players withdrawn successfully.", 2);
         RegistrationPlayerManagement();    
@@ -348,17 +335,17 @@ void TeamCheckIn() {
     displaySystemMessage("Team Check-In", 3);
 
     // Step 1: Get all Registered teams that are not Withdrawn
-    dataContainer2D eligibleTeams = Search1FieldValue(Teams_CSV_FILE, "TeamStatus", "Registered");
+    TableView eligibleTeams = Search1FieldValueView(Teams_CSV_FILE, "TeamStatus", "Registered");
 
-    if (eligibleTeams.y == 0) {
+    if (eligibleTeams.y() == 0) {
         std::cout << "No teams are available for check-in.\n";
-        deleteDataContainer2D(eligibleTeams);
         std::cout << "Press Enter to return to menu..."; std::cin.ignore(); std::cin.get();
         return;
     }
 
     // Step 2: Display eligible teams
     displayTabulatedData(eligibleTeams);
+    eligibleTeams = TableView(); // Only needed for display; don't pin the cached teams table
 
     // Step 3: Prompt for team ID
     char* teamID = getString("Enter Team ID to check-in: ");
@@ -368,7 +355,6 @@ void TeamCheckIn() {
     
     if (teamPlayers.y == 0) {
         std::cerr << "No players found for this team.\n";
-        deleteDataContainer2D(eligibleTeams);
         deleteDataContainer2D(teamPlayers);
         delete[] teamID;
         std::cout << "Press Enter to return to menu..."; std::cin.ignore(); std::cin.get();
@@ -378,9 +364,18 @@ void TeamCheckIn() {
     displayTabulatedData(teamPlayers);
 
     // Step 5: Prompt to check-in each player
+    int statusCol = Players::PlayerStatus.in(teamPlayers);
+    int checkedInTimeCol = Players::CheckedInTime.in(teamPlayers);
+    if (!PlayersTable::schema.covers(teamPlayers)) {
+        std::cerr << "player.csv does not have the expected columns.\n";
+        deleteDataContainer2D(teamPlayers);
+        delete[] teamID;
+        std::cout << "Press Enter to return to menu..."; std::cin.ignore(); std::cin.get();
+        return;
+    }
     for (int i = 0; i < teamPlayers.y; ++i) {
-        if (strcmp(teamPlayers.data[i][9], "Pending") == 0) {
-            std::cout << "Player " << teamPlayers.data[i][1] << " (" << teamPlayers.data[i][0] << ") - Check in now? (1=Yes, 2=Absent, 0=Skip): ";
+        if (strcmp(teamPlayers.data[i][statusCol], "Pending") == 0) {
+            std::cout << "Player " << cellText(teamPlayers, i, Players::PlayerName) << " (" << cellText(teamPlayers, i, Players::PlayerID) << ") - Check in now? (1=Yes, 2=Absent, 0=Skip): ";
             int choice = getInt("");
             if (choice == 1) {
                 // Format: YYYY-MM-DD HH:MM
@@ -388,16 +383,16 @@ void TeamCheckIn() {
                 tm* local = localtime(&now);
                 char formattedTime[17];
                 strftime(formattedTime, sizeof(formattedTime), "%Y-%m-%d %H:%M", local);
-                teamPlayers.data[i][9] = duplicateString("CheckedIn");
-                teamPlayers.data[i][11] = duplicateString(formattedTime);
+                setCellValue(teamPlayers, i, statusCol, "CheckedIn");
+                setCellValue(teamPlayers, i, checkedInTimeCol, formattedTime);
             } else if (choice == 2) {
-                teamPlayers.data[i][9] = duplicateString("Absent");
-                teamPlayers.data[i][11] = duplicateString("NULL");
+                setCellValue(teamPlayers, i, statusCol, "Absent");
+                setCellValue(teamPlayers, i, checkedInTimeCol, "NULL");
             } else {
                 std::cout << "Skipped.\n";
             }
 
-            updateDataByUniqueKey("player.csv", teamPlayers.data[i][0], 0, teamPlayers.x, const_cast<const char**>(teamPlayers.data[i]));
+            updateDataByUniqueKey(Players_CSV_FILE, cellText(teamPlayers, i, Players::PlayerID), Players::PlayerID.in(teamPlayers), teamPlayers.x, const_cast<const char**>(teamPlayers.data[i]));
         }
     }
 
@@ -405,7 +400,7 @@ void TeamCheckIn() {
     dataContainer2D updatedPlayers = Search1FieldValue(Players_CSV_FILE, "TeamID", teamID);
     bool allChecked = true;
     for (int i = 0; i < updatedPlayers.y; ++i) {
-        if (strcmp(updatedPlayers.data[i][9], "Pending") == 0) {
+        if (strcmp(cellText(updatedPlayers, i, Players::PlayerStatus), "Pending") == 0) {
             allChecked = false;
             break;
         }
@@ -414,16 +409,16 @@ void TeamCheckIn() {
     // Step 7: If all players are checked in or absent, mark team as CheckedIn
     if (allChecked) {
         dataContainer1D teamRow = queryKey(Teams_CSV_FILE, teamID);
-        if (!teamRow.error) {
-            teamRow.data[10] = duplicateString("CheckedIn");
+        if (!teamRow.error && Teams::CheckInStatus.in(teamRow) >= 0 && Teams::CheckedInTime.in(teamRow) >= 0) {
+            setCellValue(teamRow, Teams::CheckInStatus.in(teamRow), "CheckedIn");
             // Set CheckedInTime
             time_t now = time(0);
             tm* local = localtime(&now);
             char checkInTime[9];
             strftime(checkInTime, sizeof(checkInTime), "%H:%M:%S", local);
-            teamRow.data[9] = duplicateString(checkInTime);
+            setCellValue(teamRow, Teams::CheckedInTime.in(teamRow), checkInTime);
 
-            updateDataByUniqueKey(Teams_CSV_FILE, teamID, 0, teamRow.fields_count, const_cast<const char**>(teamRow.data));
+            updateDataByUniqueKey(Teams_CSV_FILE, teamID, Teams::TeamID.in(teamRow), teamRow.fields_count, const_cast<const char**>(teamRow.data));
         }
         deleteDataContainer1D(teamRow);
         std::cout << "Team successfully checked in.\n";
@@ -433,7 +428,6 @@ void TeamCheckIn() {
 
     // Cleanup
     delete[] teamID;
-    deleteDataContainer2D(eligibleTeams);
     deleteDataContainer2D(teamPlayers);
     deleteDataContainer2D(updatedPlayers);
 
@@ -471,8 +465,8 @@ void ViewEligibleTeam() {
         eligible.data = new char**[allTeams.y];
 
         for (int i = 0; i < allTeams.y; ++i) {
-            if (strcmp(allTeams.data[i][4], type) == 0 && 
-                strcmp(allTeams.data[i][10], "CheckedIn") == 0) {  // CheckedIn required for all
+            if (strcmp(cellText(allTeams, i, Teams::TeamType), type) == 0 && 
+                strcmp(cellText(allTeams, i, Teams::CheckInStatus), "CheckedIn") == 0) {  // CheckedIn required for all
 
                 if (strcmp(type, "WildCard") == 0) {
                     // WildCard: Only CheckInStatus matters
@@ -482,7 +476,7 @@ void ViewEligibleTeam() {
                     eligible.y++;
                 } else {
                     // EarlyBird / Standard: Require Registered + CheckedIn
-                    if (strcmp(allTeams.data[i][8], "Registered") == 0) {
+                    if (strcmp(cellText(allTeams, i, Teams::TeamStatus), "Registered") == 0) {
                         eligible.data[eligible.y] = new char*[eligible.x];
                         for (int j = 0; j < eligible.x; ++j)
                             eligible.data[eligible.y][j] = duplicateString(allTeams.data[i][j]);
@@ -517,6 +511,12 @@ void ViewEligibleTeam() {
 
 void RegistrationPlayerManagement(){
     using namespace CsvToolkit;
+    // Columns this module filters on; the table cache keeps indexes for them.
+    declareSecondaryIndex(Players_CSV_FILE, "TeamID");
+    declareSecondaryIndex(Teams_CSV_FILE, "TeamID");
+    declareSecondaryIndex(Teams_CSV_FILE, "TeamType");
+    declareSecondaryIndex(Teams_CSV_FILE, "TeamStatus");
+    declareCompositeIndex(Teams_CSV_FILE, "TeamType", "TeamStatus");
     CsvToolkit::clearTerminal();
     std::cout << "\n--- Menu ---\n";
     std::cout << "1. Registration\n";
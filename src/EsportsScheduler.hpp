@@ -7,8 +7,10 @@
 #include <iomanip>   // For output formatting
 #include <cstdio>    // For sprintf
 #include <cstring>   // For strcmp, strlen etc.
+#include <unordered_map> // For per-team point totals
 
 #include "File_exe.hpp" // Your CsvToolkit library
+#include "EsportsTables.hpp"
 
 using namespace CsvToolkit; // Use the CsvToolkit namespace for CSV operations
 
@@ -41,68 +43,36 @@ namespace EsportsScheduler {
 
     // --- Data Structures ---
 
+    // Ids, names, statuses and levels in these structs are interned (see
+    // StringPool): copies share them and nothing is freed, so the implicit copy
+    // and destructor are enough. Times take too many values to pool for good,
+    // so they are owned std::strings; "HH:MM" fits std::string's inline buffer,
+    // so copying them does not allocate either.
     struct PlayerStatInfo {
-        char* inGameName;
+        const char* inGameName;
 
         PlayerStatInfo(const char* ign = nullptr) {
-            inGameName = duplicateString(ign);
-        }
-        PlayerStatInfo(const PlayerStatInfo& other) {
-            inGameName = duplicateString(other.inGameName);
-        }
-        PlayerStatInfo& operator=(const PlayerStatInfo& other) {
-            if (this == &other) return *this;
-            delete[] inGameName;
-            inGameName = duplicateString(other.inGameName);
-            return *this;
-        }
-        ~PlayerStatInfo() {
-            delete[] inGameName;
+            inGameName = internString(ign);
         }
     };
 
     struct Team {
-        char* team_id;
-        char* team_name;
-        char* university;
+        const char* team_id;
+        const char* team_name;
+        const char* university;
         //char* country;
         int ranking_point;
-        char* team_status; // e.g., "Upper Bracket", "Lower Bracket", "Disqualified"
+        const char* team_status; // e.g., "Upper Bracket", "Lower Bracket", "Disqualified"
 
         Team() : team_id(nullptr), team_name(nullptr), university(nullptr), ranking_point(0), team_status(nullptr) {}
 
         Team(const char* id, const char* name, const char* uni, int rank, const char* status = "Pending") {
-            team_id = duplicateString(id);
-            team_name = duplicateString(name);
-            university = duplicateString(uni);
-            //country = duplicateString(ctry);
+            team_id = internString(id);
+            team_name = internString(name);
+            university = internString(uni);
+            //country = internString(ctry);
             ranking_point = rank;
-            team_status = duplicateString(status);
-        }
-
-        Team(const Team& other) {
-            team_id = duplicateString(other.team_id);
-            team_name = duplicateString(other.team_name);
-            university = duplicateString(other.university);
-            //country = duplicateString(other.country);
-            ranking_point = other.ranking_point;
-            team_status = duplicateString(other.team_status);
-        }
-
-        Team& operator=(const Team& other) {
-            if (this == &other) return *this;
-            delete[] team_id; delete[] team_name; delete[] university; delete[] team_status;
-            team_id = duplicateString(other.team_id);
-            team_name = duplicateString(other.team_name);
-            university = duplicateString(other.university);
-            //country = duplicateString(other.country);
-            ranking_point = other.ranking_point;
-            team_status = duplicateString(other.team_status);
-            return *this;
-        }
-
-        ~Team() {
-            delete[] team_id; delete[] team_name; delete[] university; delete[] team_status;
+            team_status = internString(status);
         }
     };
 
@@ -111,88 +81,40 @@ namespace EsportsScheduler {
     }
 
     struct Match {
-        char* match_id;
-        char* scheduled_date;
-        char* scheduled_time;
+        const char* match_id;
+        const char* scheduled_date;
+        std::string scheduled_time;
         // char* match_round_number; // REMOVE THIS LINE
-        char* actual_start_time;
-        char* actual_end_time;
-        char* team1_id;
-        char* team2_id;
-        char* winner_team_id;
+        std::string actual_start_time;
+        std::string actual_end_time;
+        const char* team1_id;
+        const char* team2_id;
+        const char* winner_team_id;
         int team1_score;
         int team2_score;
-        char* match_status;
-        char* match_level;
+        const char* match_status;
+        const char* match_level;
 
         // Default constructor
-        Match() : match_id(nullptr), scheduled_date(nullptr), scheduled_time(nullptr), /* match_round_number removed */
-                actual_start_time(nullptr), actual_end_time(nullptr), team1_id(nullptr), team2_id(nullptr),
+        Match() : match_id(nullptr), scheduled_date(nullptr), /* match_round_number removed */
+                team1_id(nullptr), team2_id(nullptr),
                 winner_team_id(nullptr), team1_score(0), team2_score(0), match_status(nullptr), match_level(nullptr) {}
 
         // Parameterized constructor (remove 'round' parameter)
         Match(const char* mid, const char* s_date, const char* s_time, /* const char* round REMOVED */
             const char* t1_id, const char* t2_id, const char* status, const char* level) {
-            match_id = duplicateString(mid);
-            scheduled_date = duplicateString(s_date);
-            scheduled_time = duplicateString(s_time);
-            // match_round_number = duplicateString(round); // REMOVE THIS LINE
-            actual_start_time = duplicateString(""); // Init empty
-            actual_end_time = duplicateString("");   // Init empty
-            team1_id = duplicateString(t1_id);
-            team2_id = duplicateString(t2_id);
-            winner_team_id = duplicateString(""); // Init empty
+            match_id = internString(mid);
+            scheduled_date = internString(s_date);
+            scheduled_time = s_time ? s_time : "";
+            // match_round_number = internString(round); // REMOVE THIS LINE
+            // actual_start_time and actual_end_time start empty
+            team1_id = internString(t1_id);
+            team2_id = internString(t2_id);
+            winner_team_id = internString(""); // Init empty
             team1_score = 0;
             team2_score = 0;
-            match_status = duplicateString(status);
-            match_level = duplicateString(level);
-        }
-        
-        // Copy Constructor (remove match_round_number)
-        Match(const Match& other){
-            match_id = duplicateString(other.match_id);
-            scheduled_date = duplicateString(other.scheduled_date);
-            scheduled_time = duplicateString(other.scheduled_time);
-            // match_round_number removed
-            actual_start_time = duplicateString(other.actual_start_time);
-            actual_end_time = duplicateString(other.actual_end_time);
-            team1_id = duplicateString(other.team1_id);
-            team2_id = duplicateString(other.team2_id);
-            winner_team_id = duplicateString(other.winner_team_id);
-            team1_score = other.team1_score;
-            team2_score = other.team2_score;
-            match_status = duplicateString(other.match_status);
-            match_level = duplicateString(other.match_level);
-        }
-
-        // Assignment Operator (remove match_round_number)
-        Match& operator=(const Match& other) {
-            if (this == &other) return *this;
-            delete[] match_id; delete[] scheduled_date; delete[] scheduled_time; /* delete[] match_round_number; REMOVED */
-            delete[] actual_start_time; delete[] actual_end_time; delete[] team1_id; delete[] team2_id;
-            delete[] winner_team_id; delete[] match_status; delete[] match_level;
-
-            match_id = duplicateString(other.match_id);
-            scheduled_date = duplicateString(other.scheduled_date);
-            scheduled_time = duplicateString(other.scheduled_time);
-            // match_round_number removed
-            actual_start_time = duplicateString(other.actual_start_time);
-            actual_end_time = duplicateString(other.actual_end_time);
-            team1_id = duplicateString(other.team1_id);
-            team2_id = duplicateString(other.team2_id);
-            winner_team_id = duplicateString(other.winner_team_id);
-            team1_score = other.team1_score;
-            team2_score = other.team2_score;
-            match_status = duplicateString(other.match_status);
-            match_level = duplicateString(other.match_level);
-            return *this;
-        }
-
-        // Destructor (remove match_round_number)
-        ~Match() {
-            delete[] match_id; delete[] scheduled_date; delete[] scheduled_time; /* delete[] match_round_number; REMOVED */
-            delete[] actual_start_time; delete[] actual_end_time; delete[] team1_id; delete[] team2_id;
-            delete[] winner_team_id; delete[] match_status; delete[] match_level;
+            match_status = internString(status);
+            match_level = internString(level);
         }
 
         // getAsCsvRow method (adjust for 12 fields and new order)
@@ -205,9 +127,9 @@ namespace EsportsScheduler {
 
             rowBuffer[0] = match_id ? match_id : "";
             rowBuffer[1] = scheduled_date ? scheduled_date : "";
-            rowBuffer[2] = scheduled_time ? scheduled_time : "";
-            rowBuffer[3] = actual_start_time ? actual_start_time : "";   // Moved up, was index 4
-            rowBuffer[4] = actual_end_time ? actual_end_time : "";     // Moved up, was index 5
+            rowBuffer[2] = scheduled_time.c_str();
+            rowBuffer[3] = actual_start_time.c_str();                  // Moved up, was index 4
+            rowBuffer[4] = actual_end_time.c_str();                    // Moved up, was index 5
             rowBuffer[5] = team1_id ? team1_id : "";                   // Moved up, was index 6
             rowBuffer[6] = team2_id ? team2_id : "";                   // Moved up, was index 7
             rowBuffer[7] = winner_team_id ? winner_team_id : "";       // Moved up, was index 8
@@ -308,32 +230,38 @@ namespace EsportsScheduler {
     };
 
     struct BracketEntry {
-        char* team_id;
-        char* position;
-        char* bracket_status;
+        const char* team_id;
+        const char* position;
+        const char* bracket_status;
         int sort_priority;
 
         BracketEntry(const char* tid = nullptr, const char* pos = nullptr, const char* br_status = nullptr) 
             : sort_priority(999) { // Default for unknown statuses, will appear last
-            team_id = duplicateString(tid);
-            position = duplicateString(pos);
-            bracket_status = duplicateString(br_status);
+            team_id = internString(tid);
+            position = internString(pos);
+            bracket_status = internString(br_status);
             setSortPriority();
         }
         
         BracketEntry(char** rowData, int numCols, int teamIdColIdx, int posColIdx, int bracketColIdx)
             : sort_priority(999) {
-            team_id = (teamIdColIdx != -1 && rowData[teamIdColIdx]) ? duplicateString(rowData[teamIdColIdx]) : duplicateString("");
-            position = (posColIdx != -1 && rowData[posColIdx]) ? duplicateString(rowData[posColIdx]) : duplicateString("");
-            bracket_status = (bracketColIdx != -1 && rowData[bracketColIdx]) ? duplicateString(rowData[bracketColIdx]) : duplicateString("");
+            team_id = internString((teamIdColIdx != -1 && rowData[teamIdColIdx]) ? rowData[teamIdColIdx] : "");
+            position = internString((posColIdx != -1 && rowData[posColIdx]) ? rowData[posColIdx] : "");
+            bracket_status = internString((bracketColIdx != -1 && rowData[bracketColIdx]) ? rowData[bracketColIdx] : "");
             setSortPriority();
         }
 
         void setSortPriority() {
+            // Interned once, so the status checks below are pointer compares
+            static const char* const UPPER_BRACKET = internString("upper_bracket");
+            static const char* const LOWER_BRACKET = internString("lower_bracket");
+            static const char* const FINISHED_PLACING = internString("finished_placing");
+            static const char* const ELIMINATED = internString("eliminated");
+            static const char* const DISQUALIFIED = internString("disqualified");
             sort_priority = 999; // Default: last
 
             if (bracket_status) {
-                if (strcmp(bracket_status, "upper_bracket") == 0) {
+                if (bracket_status == UPPER_BRACKET) {
                     sort_priority = 10; // Active UB teams
                     // Sub-prioritize within UB if needed, e.g., based on position string
                     if (position && strstr(position, "Winner") != nullptr) sort_priority += 1; // e.g. UB-R1-Winner
@@ -342,7 +270,7 @@ namespace EsportsScheduler {
                     else if (position && (strstr(position, "Slot") != nullptr || strstr(position, "-M") !=nullptr )) sort_priority +=3; // in a specific match
                     else sort_priority +=5; // Generic UB status
 
-                } else if (strcmp(bracket_status, "lower_bracket") == 0) {
+                } else if (bracket_status == LOWER_BRACKET) {
                     sort_priority = 20; // Active LB teams
                     if (position && strstr(position, "Winner") != nullptr) sort_priority += 1;
                     else if (position && strstr(position, "Finalist") != nullptr) sort_priority += 0; 
@@ -351,7 +279,7 @@ namespace EsportsScheduler {
                     else if (position && (strstr(position, "Slot") != nullptr || strstr(position, "-M") !=nullptr )) sort_priority +=4;
                     else sort_priority +=5;
 
-                } else if (strcmp(bracket_status, "finished_placing") == 0) {
+                } else if (bracket_status == FINISHED_PLACING) {
                     sort_priority = 30; // Base for placed teams
                     if (position) {
                         if (strcmp(position, "Champion") == 0) sort_priority = 31; // Champion highest among placed
@@ -360,43 +288,18 @@ namespace EsportsScheduler {
                         else if (strcmp(position, "3rd Runner Up") == 0) sort_priority = 34;
                         else sort_priority = 39; // Other placings
                     }
-                } else if (strcmp(bracket_status, "eliminated") == 0) {
+                } else if (bracket_status == ELIMINATED) {
                     sort_priority = 100; // Base for eliminated teams
                     if (position) { // Sub-sort eliminated types
                         if (strcmp(position, "Eliminated-LB-R1") == 0) sort_priority = 101;
                         else if (strcmp(position, "Eliminated") == 0) sort_priority = 102; // Generic
                         else sort_priority = 105; // Other eliminated types
                     }
-                } else if (strcmp(bracket_status, "disqualified") == 0) {
+                } else if (bracket_status == DISQUALIFIED) {
                     sort_priority = 200;
                 }
             }
         }
-
-        // Copy Constructor
-        BracketEntry(const BracketEntry& other) {
-            team_id = duplicateString(other.team_id);
-            position = duplicateString(other.position);
-            bracket_status = duplicateString(other.bracket_status);
-            sort_priority = other.sort_priority;
-        }
-
-        // Assignment Operator
-        BracketEntry& operator=(const BracketEntry& other) {
-            if (this == &other) return *this;
-            delete[] team_id; delete[] position; delete[] bracket_status;
-            team_id = duplicateString(other.team_id);
-            position = duplicateString(other.position);
-            bracket_status = duplicateString(other.bracket_status);
-            sort_priority = other.sort_priority;
-            return *this;
-        }
-        
-        ~BracketEntry() {
-            delete[] team_id;
-            delete[] position;
-            delete[] bracket_status;
-        }
     };
 
     bool compareBracketEntries(const BracketEntry& a, const BracketEntry& b) {
@@ -498,25 +401,24 @@ namespace EsportsScheduler {
         return teamPlayers;
     }
 
-    void generateAndSaveGameStats(const Match& completedMatch) {
+    // The stat rows are staged in 'results' and written when the caller commits it.
+    void generateAndSaveGameStats(const Match& completedMatch, Transaction& results) {
         std::cout << "\nGenerating game stats for Match ID: " << completedMatch.match_id << "..." << std::endl;
 
-        dataContainer2D allPlayerData = getData(PLAYER_CSV);
-        if (allPlayerData.error || allPlayerData.y == 0) {
-            std::cerr << "Error loading player data from " << PLAYER_CSV << " or file is empty. Cannot generate game stats." << std::endl;
+        // Only the three columns used below, and only the two teams' players, are loaded
+        const char* playerFields[] = { Players::TeamID.name, Players::InGameName.name, Players::Role.name };
+        RowFilter matchTeams(Players::TeamID.name, { completedMatch.team1_id, completedMatch.team2_id });
+        dataContainer2D allPlayerData = getData(PLAYER_CSV, playerFields, 3, matchTeams);
+        if (allPlayerData.error) {
+            std::cerr << "Error loading player data from " << PLAYER_CSV << ". Cannot generate game stats." << std::endl;
             deleteDataContainer2D(allPlayerData);
             return;
         }
 
-        // Find column indices in playerData
-        int p_teamIdCol = -1, p_ignCol = -1, p_roleCol = -1;
-        if(allPlayerData.fields && allPlayerData.x > 0){
-            for (int k = 0; k < allPlayerData.x; ++k) {
-                if (strcmp(allPlayerData.fields[k], "TeamID") == 0) p_teamIdCol = k;
-                else if (strcmp(allPlayerData.fields[k], "InGameName") == 0) p_ignCol = k;
-                else if (strcmp(allPlayerData.fields[k], "Role") == 0) p_roleCol = k;
-            }
-        }
+        // Column indices in playerData
+        int p_teamIdCol = Players::TeamID.in(allPlayerData);
+        int p_ignCol = Players::InGameName.in(allPlayerData);
+        int p_roleCol = Players::Role.in(allPlayerData);
 
         if (p_teamIdCol == -1 || p_ignCol == -1 || p_roleCol == -1) {
             std::cerr << "Error: Required columns (TeamID, InGameName, Role) not found in " << PLAYER_CSV 
@@ -566,7 +468,7 @@ namespace EsportsScheduler {
                     hero,
                     kills_s, deaths_s, assists_s, gpm_s, xpm_s
                 };
-                writeNewDataRow(GAME_STAT_CSV, 8, statRow);
+                results.appendRow(GAME_STAT_CSV, 8, statRow);
             }
             // Cleanup team1Players array (destructors called by delete[])
             delete[] team1Players; // This will correctly call ~PlayerStatInfo() for each element.
@@ -595,7 +497,7 @@ namespace EsportsScheduler {
                     hero,
                     kills_s, deaths_s, assists_s, gpm_s, xpm_s
                 };
-                writeNewDataRow(GAME_STAT_CSV, 8, statRow);
+                results.appendRow(GAME_STAT_CSV, 8, statRow);
             }
             // Cleanup team2Players array
             delete[] team2Players; // This will correctly call ~PlayerStatInfo() for each element.
@@ -617,13 +519,7 @@ namespace EsportsScheduler {
         dataContainer2D matches = getData(MATCH_CSV);
         int maxIdNum = 0;
         if (!matches.error && matches.y > 0) {
-            int matchIdCol = -1;
-            for(int i=0; i < matches.x; ++i) {
-                if(matches.fields[i] && strcmp(matches.fields[i], "match_id") == 0) {
-                    matchIdCol = i;
-                    break;
-                }
-            }
+            int matchIdCol = Matches::MatchId.in(matches);
             if (matchIdCol != -1) {
                 for (int i = 0; i < matches.y; ++i) {
                     if (matches.data[i][matchIdCol] && strncmp(matches.data[i][matchIdCol], "MATCH", 5) == 0) {
@@ -643,61 +539,51 @@ namespace EsportsScheduler {
     Team* loadTeamsFromCSV(int& teamCount_out) 
     {
         teamCount_out = 0;
-        dataContainer2D teamData = getData(TEAMS_CSV); // TEAMS_CSV should be "team.csv"
-        
-        dataContainer2D checkedInTeams = filterDataContainer(teamData, "CheckInStatus", "CheckedIn");
-        deleteDataContainer2D(teamData);
+        // A view over the cached table (CheckInStatus is indexed, see manageMatchSchedulingAndProgression):
+        // only the four cells each Team needs are read, and no row is copied.
+        TableView checkedInTeams = Search1FieldValueView(TEAMS_CSV, "CheckInStatus", "CheckedIn");
         
         if (checkedInTeams.error) {
             std::cerr << "Error loading teams from " << TEAMS_CSV << std::endl;
-            deleteDataContainer2D(checkedInTeams);
             return nullptr;
         }
 
-        // Adjusted column lookups
-        int idCol = -1, nameCol = -1, uniCol = -1, /* countryCol = -1, REMOVED */ rankCol = -1;
-        for(int i=0; i < checkedInTeams.x; ++i) {
-            if(strcmp(checkedInTeams.fields[i], "TeamID") == 0) idCol = i;
-            else if(strcmp(checkedInTeams.fields[i], "TeamName") == 0) nameCol = i;
-            else if(strcmp(checkedInTeams.fields[i], "University") == 0) uniCol = i;
-            // else if(strcmp(checkedInTeams.fields[i], "Country") == 0) countryCol = i; // REMOVED
-            else if(strcmp(checkedInTeams.fields[i], "RankingPoint") == 0) rankCol = i; // Corrected from "RankingPoint" previously
-        }
+        // The view keeps the table's columns, so source positions are view positions
+        int idCol = Teams::TeamID.in(*checkedInTeams.source);
+        int nameCol = Teams::TeamName.in(*checkedInTeams.source);
+        int uniCol = Teams::University.in(*checkedInTeams.source);
+        int rankCol = Teams::RankingPoint.in(*checkedInTeams.source);
 
         // Update condition to check for required columns
         if(idCol == -1 || nameCol == -1 || uniCol == -1 || /* countryCol == -1 || REMOVED */ rankCol == -1) {
             std::cerr << "Error: Required columns (TeamID, TeamName, University, ranking_points) not found in " << TEAMS_CSV << std::endl;
-            deleteDataContainer2D(checkedInTeams);
             return nullptr;
         }
 
-        if (checkedInTeams.y == 0) {
-            deleteDataContainer2D(checkedInTeams);
+        if (checkedInTeams.y() == 0) {
             return nullptr;
         }
 
         // Allocate raw memory using global operator new[]
-        void* rawMemory = ::operator new[](static_cast<size_t>(checkedInTeams.y) * sizeof(Team));
+        void* rawMemory = ::operator new[](static_cast<size_t>(checkedInTeams.y()) * sizeof(Team));
         if (!rawMemory) {
             std::cerr << "Error: Memory allocation failed for teams array." << std::endl;
-            deleteDataContainer2D(checkedInTeams);
             return nullptr;
         }
         Team* loadedTeams = static_cast<Team*>(rawMemory);
 
-        for (int i = 0; i < checkedInTeams.y; ++i) {
+        for (int i = 0; i < checkedInTeams.y(); ++i) {
             // Construct objects in allocated memory using placement new
             new (&loadedTeams[i]) Team(
-                checkedInTeams.data[i][idCol],
-                checkedInTeams.data[i][nameCol],
-                checkedInTeams.data[i][uniCol],
+                checkedInTeams.cell(i, idCol),
+                checkedInTeams.cell(i, nameCol),
+                checkedInTeams.cell(i, uniCol),
                 //teamData.data[i][countryCol],
-                atoi(checkedInTeams.data[i][rankCol] ? checkedInTeams.data[i][rankCol] : "0")
+                atoi(checkedInTeams.cell(i, rankCol))
             );
         }
         
-        teamCount_out = checkedInTeams.y;
-        deleteDataContainer2D(checkedInTeams); // CSV data is now copied or used, so free it
+        teamCount_out = checkedInTeams.y();
 
         // Sort the constructed teams
         if (teamCount_out > 0) {
@@ -727,7 +613,7 @@ namespace EsportsScheduler {
         for (int i = 0; i < count; ++i) {
             displayData.data[i] = new char*[displayData.x];
             std::string indexStr = std::to_string(i + 1);
-            std::string dateTimeStr = std::string(matches[i].scheduled_date ? matches[i].scheduled_date : "") + " " + std::string(matches[i].scheduled_time ? matches[i].scheduled_time : "");
+            std::string dateTimeStr = std::string(matches[i].scheduled_date ? matches[i].scheduled_date : "") + " " + matches[i].scheduled_time;
 
             displayData.data[i][0] = duplicateString(indexStr.c_str());
             displayData.data[i][1] = duplicateString(matches[i].match_id ? matches[i].match_id : "N/A");
@@ -755,96 +641,75 @@ namespace EsportsScheduler {
             }
         }
 
-        dataContainer2D matchData = getData(matchCsvFile); // From CsvToolkit
-        if (matchData.error) {
-            std::cerr << "Warning: Error loading match data from " << matchCsvFile << " for ranking calculation. Points remain 0." << std::endl;
-            deleteDataContainer2D(matchData); // From CsvToolkit
-            // Points already defaulted to 0 or their previous values if not reset above
-            return;
-        }
-        if (matchData.y == 0) {
-            std::cout << "Info: No match data found in " << matchCsvFile << ". Calculated points will be 0 for new calculations." << std::endl;
-            // Points already defaulted to 0
-            deleteDataContainer2D(matchData); // From CsvToolkit
-            return;
-        }
+        // One pass over the completed matches credits both teams, keyed by the
+        // numeric part of their "TXXX" id (e.g. 1 for T001). A team earns
+        // score + score^2 per completed match, the score being its own in that match.
+        // The totals are kept between calls and recomputed only once the match
+        // file has changed.
+        static std::string pointsFile;
+        static FileVersion pointsVersion;
+        static std::unordered_map<int, int> pointsByTeamNumber;
+        if (pointsFile != matchCsvFile) {
+            pointsFile = matchCsvFile;
+            pointsVersion = FileVersion();
+        }
+        FileVersion matchVersion = pointsVersion;
+        if (fileChangedSince(matchCsvFile, matchVersion)) {
+            pointsByTeamNumber.clear(); // pointsVersion moves on only once the pass below completes
+
+            // The match history is streamed one row at a time, so its length is not bounded by memory
+            CsvReader matches; // From CsvToolkit
+            if (matches.open(matchCsvFile) != 0) {
+                std::cerr << "Warning: Error loading match data from " << matchCsvFile << " for ranking calculation. Points remain 0." << std::endl;
+                // Points already defaulted to 0 or their previous values if not reset above
+                return;
+            }
 
-        int m_team1IdCol = -1, m_team2IdCol = -1, m_team1ScoreCol = -1, m_team2ScoreCol = -1, m_statusCol = -1;
-        // These field names "team1_id", "team2_id" etc. MUST match the headers in your matches.csv
-        for (int k = 0; k < matchData.x; ++k) {
-            if (strcmp(matchData.fields[k], "team1_id") == 0) m_team1IdCol = k; // Or "Player1ID", "Team1ID" from your actual matches.csv
-            else if (strcmp(matchData.fields[k], "team2_id") == 0) m_team2IdCol = k; // Or "Player2ID", "Team2ID"
-            else if (strcmp(matchData.fields[k], "team1_score") == 0) m_team1ScoreCol = k; // Or "Player1Score"
-            else if (strcmp(matchData.fields[k], "team2_score") == 0) m_team2ScoreCol = k; // Or "Player2Score"
-            else if (strcmp(matchData.fields[k], "match_status") == 0) m_statusCol = k; // Or "Status"
-        }
+            int m_team1IdCol = Matches::Team1Id.in(matches);
+            int m_team2IdCol = Matches::Team2Id.in(matches);
+            int m_team1ScoreCol = Matches::Team1Score.in(matches);
+            int m_team2ScoreCol = Matches::Team2Score.in(matches);
+            int m_statusCol = Matches::MatchStatus.in(matches);
 
-        if (m_team1IdCol == -1 || m_team2IdCol == -1 || m_team1ScoreCol == -1 || m_team2ScoreCol == -1 || m_statusCol == -1) {
-            std::cerr << "Warning: Could not find all required columns (e.g., team1_id, team2_id, team1_score, team2_score, match_status) in "
-                    << matchCsvFile << ". Column names are case-sensitive. Calculated points remain 0." << std::endl;
-            // Points already defaulted to 0
-            deleteDataContainer2D(matchData); // From CsvToolkit
-            return;
+            if (m_team1IdCol == -1 || m_team2IdCol == -1 || m_team1ScoreCol == -1 || m_team2ScoreCol == -1 || m_statusCol == -1) {
+                std::cerr << "Warning: Could not find all required columns (e.g., team1_id, team2_id, team1_score, team2_score, match_status) in "
+                        << matchCsvFile << ". Column names are case-sensitive. Calculated points remain 0." << std::endl;
+                // Points already defaulted to 0
+                return;
+            }
+
+            while (matches.next()) {
+                if (strcmp(matches.cell(m_statusCol), "Completed") != 0) continue;
+                const char* team1 = matches.cell(m_team1IdCol);
+                const char* team2 = matches.cell(m_team2IdCol);
+                bool team1Valid = team1[0] == 'T' && team1[1] != '\0';
+                bool team2Valid = team2[0] == 'T' && team2[1] != '\0';
+                int team1Number = team1Valid ? atoi(team1 + 1) : 0;
+                int team2Number = team2Valid ? atoi(team2 + 1) : 0;
+                int team1Score = atoi(matches.cell(m_team1ScoreCol));
+                int team2Score = atoi(matches.cell(m_team2ScoreCol));
+                if (team1Valid) pointsByTeamNumber[team1Number] += team1Score + team1Score * team1Score;
+                // A team listed on both sides is credited once, as team 1
+                if (team2Valid && !(team1Valid && team1Number == team2Number)) {
+                    pointsByTeamNumber[team2Number] += team2Score + team2Score * team2Score;
+                }
+            }
+            if (matches.rowNumber() == 0) {
+                std::cout << "Info: No match data found in " << matchCsvFile << ". Calculated points will be 0 for new calculations." << std::endl;
+                return;
+            }
+            pointsVersion = matchVersion;
         }
 
         for (int i = 0; i < teamCount; ++i) { // For each team in your `teams` array
-            int calculated_points = 0;
             // Ensure team_id is valid, starts with 'T', and has digits following.
             if (!teams[i].team_id || teams[i].team_id[0] != 'T' || strlen(teams[i].team_id) <= 1) {
                 teams[i].ranking_point = 0; // Default or preserve existing, based on desired logic
                 continue;
             }
-            const char* currentTeamNumericPart = teams[i].team_id + 1; // Skips 'T', e.g., "001" from "T001"
-
-            for (int j = 0; j < matchData.y; ++j) { // For each match in the CSV
-                if (matchData.data[j][m_statusCol] && strcmp(matchData.data[j][m_statusCol], "Completed") == 0) {
-                    int score = 0;
-                    bool participated = false;
-
-                    // Check Team 1 in the match
-                    const char* match_team1_id_str = matchData.data[j][m_team1IdCol];
-                    // Expecting "TXXX" format in CSV, e.g., T001, T010
-                    if (match_team1_id_str && match_team1_id_str[0] == 'T' && strlen(match_team1_id_str) > 1) {
-                        const char* match_team1_numeric_part = match_team1_id_str + 1; // Skips 'T'
-                        if (atoi(currentTeamNumericPart) == atoi(match_team1_numeric_part)) {
-                            score = atoi(matchData.data[j][m_team1ScoreCol] ? matchData.data[j][m_team1ScoreCol] : "0");
-                            participated = true;
-                        }
-                    }
-
-                    // Check Team 2 in the match, if not already found as Team 1
-                    if (!participated) {
-                        const char* match_team2_id_str = matchData.data[j][m_team2IdCol];
-                        if (match_team2_id_str && match_team2_id_str[0] == 'T' && strlen(match_team2_id_str) > 1) {
-                            const char* match_team2_numeric_part = match_team2_id_str + 1; // Skips 'T'
-                            if (atoi(currentTeamNumericPart) == atoi(match_team2_numeric_part)) {
-                                score = atoi(matchData.data[j][m_team2ScoreCol] ? matchData.data[j][m_team2ScoreCol] : "0");
-                                participated = true;
-                            }
-                        }
-                    }
-
-                    if (participated) {
-                        // Your point calculation logic. Example: points = score^2
-                        // You might want a different logic, e.g., +3 for a win, +1 for a draw, + X based on score difference.
-                        // The current logic `(score * score)` might not be standard.
-                        // Let's assume for now, points are awarded based on the direct score achieved.
-                        // If it's a win/loss system, you'd check the winner_id column.
-                        // The current code doesn't use winner_id, it just uses the team's score in that match.
-                        // If the simple interpretation is "points = score achieved in match", then:
-                        calculated_points += score;
-                        // Or if it's points for winning (e.g., 3 points for a win, 1 for draw)
-                        // you'd need the winner_id column and compare.
-                        // The original code had `calculated_points += (score * score);`
-                        // Let's stick to that to match the original as closely as possible,
-                        // but it's an unusual scoring system.
-                        calculated_points += (score * score);
-                    }
-                }
-            }
-            teams[i].ranking_point = calculated_points;
+            std::unordered_map<int, int>::const_iterator points = pointsByTeamNumber.find(atoi(teams[i].team_id + 1));
+            teams[i].ranking_point = points == pointsByTeamNumber.end() ? 0 : points->second;
         }
-        deleteDataContainer2D(matchData); // From CsvToolkit
     }
 
 
@@ -1166,7 +1031,7 @@ char* getTimeFromUser(const char* prompt) {
                 } else {
                     std::cout << "Match not saved." << std::endl;
                 }
-                // Clean up date/time strings obtained from user input, as Match constructor duplicates them.
+                // Clean up date/time strings obtained from user input, as Match constructor interns its own copies.
                 delete[] newDate;
                 delete[] newTime;
 
@@ -1206,8 +1071,8 @@ char* getTimeFromUser(const char* prompt) {
         // Ensure date and time strings are not null for comparison; use empty string if null.
         const char* date_a_str = a.scheduled_date ? a.scheduled_date : "";
         const char* date_b_str = b.scheduled_date ? b.scheduled_date : "";
-        const char* time_a_str = a.scheduled_time ? a.scheduled_time : "";
-        const char* time_b_str = b.scheduled_time ? b.scheduled_time : "";
+        const char* time_a_str = a.scheduled_time.c_str();
+        const char* time_b_str = b.scheduled_time.c_str();
 
         int date_cmp = strcmp(date_a_str, date_b_str);
         if (date_cmp != 0) {
@@ -1221,40 +1086,30 @@ char* getTimeFromUser(const char* prompt) {
         clearTerminal();
         std::cout << "--- Current Match Schedule (Sorted by Date/Time) ---" << std::endl;
         
-        dataContainer2D originalMatchData = getData(MATCH_CSV);
-        dataContainer2D teamData = getData(TEAMS_CSV); // TEAMS_CSV is "team.csv"
+        // Both come from the table cache, which re-reads a file only after it changed on disk
+        TableView matchTable = tableView(MATCH_CSV);
+        TableView teamTable = tableView(TEAMS_CSV); // TEAMS_CSV is "team.csv"
+        const dataContainer2D& originalMatchData = *matchTable.source;
+        const dataContainer2D& teamData = *teamTable.source;
 
         if (originalMatchData.error || originalMatchData.y == 0) {
             std::cout << "No match schedule found or error loading match data." << std::endl;
         } else {
-            // Find column indices in originalMatchData for all 12 fields
-            int m_idCol = -1, m_schedDateCol = -1, m_schedTimeCol = -1, 
-                m_actualStartCol = -1, m_actualEndCol = -1,
-                m_team1IdCol = -1, m_team2IdCol = -1, m_winnerIdCol = -1,
-                m_t1ScoreCol = -1, m_t2ScoreCol = -1, m_statusCol = -1, m_levelCol = -1;
-
-            if (originalMatchData.fields && originalMatchData.x > 0) {
-                for(int k=0; k < originalMatchData.x; ++k) {
-                    if(!originalMatchData.fields[k]) continue; // Safety check for null field names
-                    if(strcmp(originalMatchData.fields[k], "match_id") == 0) m_idCol = k;
-                    else if(strcmp(originalMatchData.fields[k], "scheduled_date") == 0) m_schedDateCol = k;
-                    else if(strcmp(originalMatchData.fields[k], "scheduled_time") == 0) m_schedTimeCol = k;
-                    else if(strcmp(originalMatchData.fields[k], "actual_start_time") == 0) m_actualStartCol = k;
-                    else if(strcmp(originalMatchData.fields[k], "actual_end_time") == 0) m_actualEndCol = k;
-                    else if(strcmp(originalMatchData.fields[k], "team1_id") == 0) m_team1IdCol = k;
-                    else if(strcmp(originalMatchData.fields[k], "team2_id") == 0) m_team2IdCol = k;
-                    else if(strcmp(originalMatchData.fields[k], "winner_team_id") == 0) m_winnerIdCol = k;
-                    else if(strcmp(originalMatchData.fields[k], "team1_score") == 0) m_t1ScoreCol = k;
-                    else if(strcmp(originalMatchData.fields[k], "team2_score") == 0) m_t2ScoreCol = k;
-                    else if(strcmp(originalMatchData.fields[k], "match_status") == 0) m_statusCol = k;
-                    else if(strcmp(originalMatchData.fields[k], "match_level") == 0) m_levelCol = k;
-                }
-            }
-            
-            bool essentialColsFound = m_idCol != -1 && m_schedDateCol != -1 && m_schedTimeCol != -1 && 
-                                    m_actualStartCol != -1 && m_actualEndCol != -1 &&
-                                    m_team1IdCol != -1 && m_team2IdCol != -1 && m_winnerIdCol != -1 &&
-                                    m_t1ScoreCol != -1 && m_t2ScoreCol != -1 && m_statusCol != -1 && m_levelCol != -1;
+            // Column indices in originalMatchData for all 12 fields
+            int m_idCol = Matches::MatchId.in(originalMatchData);
+            int m_schedDateCol = Matches::ScheduledDate.in(originalMatchData);
+            int m_schedTimeCol = Matches::ScheduledTime.in(originalMatchData);
+            int m_actualStartCol = Matches::ActualStartTime.in(originalMatchData);
+            int m_actualEndCol = Matches::ActualEndTime.in(originalMatchData);
+            int m_team1IdCol = Matches::Team1Id.in(originalMatchData);
+            int m_team2IdCol = Matches::Team2Id.in(originalMatchData);
+            int m_winnerIdCol = Matches::WinnerTeamId.in(originalMatchData);
+            int m_t1ScoreCol = Matches::Team1Score.in(originalMatchData);
+            int m_t2ScoreCol = Matches::Team2Score.in(originalMatchData);
+            int m_statusCol = Matches::MatchStatus.in(originalMatchData);
+            int m_levelCol = Matches::MatchLevel.in(originalMatchData);
+
+            bool essentialColsFound = MatchesTable::schema.covers(originalMatchData);
 
             if (!essentialColsFound) {
                 std::cerr << "Error: Not all required columns found in " << MATCH_CSV << ". Displaying raw data if possible." << std::endl;
@@ -1277,13 +1132,10 @@ char* getTimeFromUser(const char* prompt) {
                         originalMatchData.data[i][m_statusCol],
                         originalMatchData.data[i][m_levelCol]
                     );
-                    // Manually populate remaining fields not set by that specific constructor
-                    delete[] matchesArray[i].actual_start_time; // Free string from Match default part of constructor
-                    matchesArray[i].actual_start_time = duplicateString(originalMatchData.data[i][m_actualStartCol] ? originalMatchData.data[i][m_actualStartCol] : "");
-                    delete[] matchesArray[i].actual_end_time;
-                    matchesArray[i].actual_end_time   = duplicateString(originalMatchData.data[i][m_actualEndCol] ? originalMatchData.data[i][m_actualEndCol] : "");
-                    delete[] matchesArray[i].winner_team_id;
-                    matchesArray[i].winner_team_id    = duplicateString(originalMatchData.data[i][m_winnerIdCol] ? originalMatchData.data[i][m_winnerIdCol] : "");
+                    // Manually populate remaining fields not set by that specific constructor (strings are interned, nothing to free)
+                    matchesArray[i].actual_start_time = originalMatchData.data[i][m_actualStartCol] ? originalMatchData.data[i][m_actualStartCol] : "";
+                    matchesArray[i].actual_end_time   = originalMatchData.data[i][m_actualEndCol] ? originalMatchData.data[i][m_actualEndCol] : "";
+                    matchesArray[i].winner_team_id    = internString(originalMatchData.data[i][m_winnerIdCol] ? originalMatchData.data[i][m_winnerIdCol] : "");
                     matchesArray[i].team1_score       = atoi(originalMatchData.data[i][m_t1ScoreCol] ? originalMatchData.data[i][m_t1ScoreCol] : "0");
                     matchesArray[i].team2_score       = atoi(originalMatchData.data[i][m_t2ScoreCol] ? originalMatchData.data[i][m_t2ScoreCol] : "0");
                 }
@@ -1309,10 +1161,8 @@ char* getTimeFromUser(const char* prompt) {
                 int t_teamIdCol = -1, t_teamNameCol = -1;
                 bool canDisplayNames = false;
                 if (!teamData.error && teamData.fields && teamData.x > 0) {
-                    for(int k=0; k < teamData.x; ++k) {
-                        if(strcmp(teamData.fields[k], "TeamID") == 0) t_teamIdCol = k;
-                        else if(strcmp(teamData.fields[k], "TeamName") == 0) t_teamNameCol = k;
-                    }
+                    t_teamIdCol = Teams::TeamID.in(teamData);
+                    t_teamNameCol = Teams::TeamName.in(teamData);
                     if (t_teamIdCol != -1 && t_teamNameCol != -1) canDisplayNames = true;
                     else std::cerr << "Warning: TeamID or TeamName column not found in " << TEAMS_CSV << ". Names may not be shown correctly." << std::endl;
                 } else std::cerr << "Warning: Could not load " << TEAMS_CSV << " or bad format. Names may not be shown correctly." << std::endl;
@@ -1326,9 +1176,9 @@ char* getTimeFromUser(const char* prompt) {
                     // Populate displayData row from currentMatch, augmenting team IDs
                     displayData.data[i][m_idCol] = duplicateString(currentMatch.match_id);
                     displayData.data[i][m_schedDateCol] = duplicateString(currentMatch.scheduled_date);
-                    displayData.data[i][m_schedTimeCol] = duplicateString(currentMatch.scheduled_time);
-                    displayData.data[i][m_actualStartCol] = duplicateString(currentMatch.actual_start_time);
-                    displayData.data[i][m_actualEndCol] = duplicateString(currentMatch.actual_end_time);
+                    displayData.data[i][m_schedTimeCol] = duplicateString(currentMatch.scheduled_time.c_str());
+                    displayData.data[i][m_actualStartCol] = duplicateString(currentMatch.actual_start_time.c_str());
+                    displayData.data[i][m_actualEndCol] = duplicateString(currentMatch.actual_end_time.c_str());
                     
                     if (canDisplayNames) {
                         char* name1 = findTeamName(currentMatch.team1_id, teamData, t_teamIdCol, t_teamNameCol);
@@ -1378,8 +1228,6 @@ char* getTimeFromUser(const char* prompt) {
             } // end if essentialColsFound
         } // end if originalMatchData is valid
         
-        deleteDataContainer2D(originalMatchData);
-        deleteDataContainer2D(teamData);
         getString("Press Enter to continue...");
     }
 
@@ -1387,17 +1235,13 @@ char* getTimeFromUser(const char* prompt) {
         clearTerminal();
         std::cout << "--- Bracket Progress (Sorted by Bracket/Placing) ---" << std::endl; // Updated title
         
-        dataContainer2D bracketInfo = getData(TOURNAMENT_BRACKET_CSV);
+        TableView bracketTable = tableView(TOURNAMENT_BRACKET_CSV); // Cached until the file changes
+        const dataContainer2D& bracketInfo = *bracketTable.source;
 
         if (!bracketInfo.error && bracketInfo.y > 0) {
-            int teamIdCol = -1, posCol = -1, bracketCol = -1;
-            if(bracketInfo.fields && bracketInfo.x > 0) { 
-                for (int k = 0; k < bracketInfo.x; ++k) {
-                    if (strcmp(bracketInfo.fields[k], "team_id") == 0) teamIdCol = k;
-                    else if (strcmp(bracketInfo.fields[k], "position") == 0) posCol = k;
-                    else if (strcmp(bracketInfo.fields[k], "bracket") == 0) bracketCol = k;
-                }
-            }
+            int teamIdCol = Brackets::TeamId.in(bracketInfo);
+            int posCol = Brackets::Position.in(bracketInfo);
+            int bracketCol = Brackets::Bracket.in(bracketInfo);
 
             if (teamIdCol == -1 || posCol == -1 || bracketCol == -1) {
                 std::cerr << "Error: Required columns ('team_id', 'position', 'bracket') not found in " << TOURNAMENT_BRACKET_CSV << "." << std::endl;
@@ -1435,12 +1279,12 @@ char* getTimeFromUser(const char* prompt) {
         } else {
             std::cout << "No bracket position data found or error loading from " << TOURNAMENT_BRACKET_CSV << "." << std::endl;
         }
-        deleteDataContainer2D(bracketInfo);
         getString("Press Enter to continue...");
     }
     
     // Modified handleTeamProgression
-    void handleTeamProgression(const Match& updatedMatch) { // Removed queue/stack params for now
+    // Bracket changes are staged in 'results' and written when the caller commits it.
+    void handleTeamProgression(const Match& updatedMatch, Transaction& results) { // Removed queue/stack params for now
         std::cout << "Processing progression for Match ID: " << updatedMatch.match_id << std::endl;
         if (!updatedMatch.winner_team_id || strlen(updatedMatch.winner_team_id) == 0 || 
             strcmp(updatedMatch.winner_team_id, "DRAW") == 0 || // Handle draws if necessary
@@ -1463,40 +1307,19 @@ char* getTimeFromUser(const char* prompt) {
 
         // Helper to update team status in tournament_bracket.csv
         auto updateTeamStatusInBracketFile = [&](const char* teamId, const char* newPosition, const char* newBracketStatus) {
-            dataContainer2D bracketData = getData(TOURNAMENT_BRACKET_CSV);
-            bool updated = false;
-            if (!bracketData.error && bracketData.y > 0) {
-                int teamIdCol = -1, posCol = -1, bracketCol = -1;
-                for(int k=0; k<bracketData.x; ++k) {
-                    if(strcmp(bracketData.fields[k], "team_id")==0) teamIdCol=k;
-                    else if(strcmp(bracketData.fields[k], "position")==0) posCol=k;
-                    else if(strcmp(bracketData.fields[k], "bracket")==0) bracketCol=k;
-                }
-
-                if (teamIdCol != -1 && posCol != -1 && bracketCol != -1) {
-                    for (int i = 0; i < bracketData.y; ++i) {
-                        if (bracketData.data[i][teamIdCol] && strcmp(bracketData.data[i][teamIdCol], teamId) == 0) {
-                            delete[] bracketData.data[i][posCol];
-                            bracketData.data[i][posCol] = duplicateString(newPosition);
-                            delete[] bracketData.data[i][bracketCol];
-                            bracketData.data[i][bracketCol] = duplicateString(newBracketStatus);
-                            updated = true;
-                            break;
-                        }
-                    }
-                    if (updated) {
-                        writeData(TOURNAMENT_BRACKET_CSV, bracketData);
-                        std::cout << "Team " << teamId << " status updated in " << TOURNAMENT_BRACKET_CSV << " to position: " << newPosition << ", bracket: " << newBracketStatus << std::endl;
-                    } else {
-                        std::cout << "Warning: Team " << teamId << " not found in " << TOURNAMENT_BRACKET_CSV << " to update status." << std::endl;
-                    }
-                } else {
-                    std::cerr << "Warning: Required columns missing in " << TOURNAMENT_BRACKET_CSV << " for status update." << std::endl;
-                }
+            // team_id is the bracket file's key column, so only this team's row is rewritten.
+            const char* bracketFields[] = { "position", "bracket" };
+            const char* bracketValues[] = { newPosition, newBracketStatus };
+            int result = results.updateFieldsByKey(TOURNAMENT_BRACKET_CSV, teamId, 2, bracketFields, bracketValues);
+            if (result == 0) {
+                std::cout << "Team " << teamId << " status updated in " << TOURNAMENT_BRACKET_CSV << " to position: " << newPosition << ", bracket: " << newBracketStatus << std::endl;
+            } else if (result == 3) {
+                std::cout << "Warning: Team " << teamId << " not found in " << TOURNAMENT_BRACKET_CSV << " to update status." << std::endl;
+            } else if (result == 2) {
+                std::cerr << "Warning: Required columns missing in " << TOURNAMENT_BRACKET_CSV << " for status update." << std::endl;
             } else {
                 std::cerr << "Warning: Could not load or empty " << TOURNAMENT_BRACKET_CSV << " for status update." << std::endl;
             }
-            deleteDataContainer2D(bracketData);
         };
 
         const char* matchLevel = updatedMatch.match_level ? updatedMatch.match_level : "";
@@ -1568,32 +1391,18 @@ char* getTimeFromUser(const char* prompt) {
 
         int matchRowIdx = -1;
         // Column indices for match.csv
-        int idCol=-1, schedDateCol=-1, schedTimeCol=-1, 
-            actualStartTimeCol=-1, actualEndTimeCol=-1, // New
-            t1IdCol=-1, t2IdCol=-1, winnerCol=-1, 
-            t1ScoreCol=-1, t2ScoreCol=-1, statusCol=-1, levelCol=-1;
-
-        if (allMatches.x > 0 && allMatches.fields) {
-            for(int i=0; i < allMatches.x; ++i) {
-                if(strcmp(allMatches.fields[i], "match_id") == 0) idCol = i;
-                else if(strcmp(allMatches.fields[i], "scheduled_date") == 0) schedDateCol = i;
-                else if(strcmp(allMatches.fields[i], "scheduled_time") == 0) schedTimeCol = i;
-                else if(strcmp(allMatches.fields[i], "actual_start_time") == 0) actualStartTimeCol = i; // Find index
-                else if(strcmp(allMatches.fields[i], "actual_end_time") == 0) actualEndTimeCol = i;   // Find index
-                else if(strcmp(allMatches.fields[i], "team1_id") == 0) t1IdCol = i;
-                else if(strcmp(allMatches.fields[i], "team2_id") == 0) t2IdCol = i;
-                else if(strcmp(allMatches.fields[i], "winner_team_id") == 0) winnerCol = i;
-                else if(strcmp(allMatches.fields[i], "team1_score") == 0) t1ScoreCol = i;
-                else if(strcmp(allMatches.fields[i], "team2_score") == 0) t2ScoreCol = i;
-                else if(strcmp(allMatches.fields[i], "match_status") == 0) statusCol = i;
-                else if(strcmp(allMatches.fields[i], "match_level") == 0) levelCol = i;
-            }
-        }
+        int idCol = Matches::MatchId.in(allMatches);
+        int schedDateCol = Matches::ScheduledDate.in(allMatches);
+        int schedTimeCol = Matches::ScheduledTime.in(allMatches);
+        int actualStartTimeCol = Matches::ActualStartTime.in(allMatches);
+        int actualEndTimeCol = Matches::ActualEndTime.in(allMatches);
+        int t1IdCol = Matches::Team1Id.in(allMatches);
+        int t2IdCol = Matches::Team2Id.in(allMatches);
+        int statusCol = Matches::MatchStatus.in(allMatches);
+        int levelCol = Matches::MatchLevel.in(allMatches);
 
         // Check if all necessary columns were found
-        if(idCol == -1 || schedDateCol == -1 || schedTimeCol == -1 || actualStartTimeCol == -1 || actualEndTimeCol == -1 || 
-        t1IdCol == -1 || t2IdCol == -1 || winnerCol == -1 || t1ScoreCol == -1 || t2ScoreCol == -1 || 
-        statusCol == -1 || levelCol == -1){
+        if (!MatchesTable::schema.covers(allMatches)) {
             std::cerr << "Error: One or more critical columns not found in " << MATCH_CSV 
                     << ". Cannot update match." << std::endl;
             deleteDataContainer2D(allMatches); 
@@ -1619,10 +1428,8 @@ char* getTimeFromUser(const char* prompt) {
                     allMatches.data[i][levelCol]
                 );
                 // Copy existing actual times, they will be overwritten by user input if provided
-                delete[] foundMatchForProgression.actual_start_time; // Delete default ""
-                foundMatchForProgression.actual_start_time = duplicateString(allMatches.data[i][actualStartTimeCol] ? allMatches.data[i][actualStartTimeCol] : "");
-                delete[] foundMatchForProgression.actual_end_time; // Delete default ""
-                foundMatchForProgression.actual_end_time = duplicateString(allMatches.data[i][actualEndTimeCol] ? allMatches.data[i][actualEndTimeCol] : "");
+                foundMatchForProgression.actual_start_time = allMatches.data[i][actualStartTimeCol] ? allMatches.data[i][actualStartTimeCol] : "";
+                foundMatchForProgression.actual_end_time = allMatches.data[i][actualEndTimeCol] ? allMatches.data[i][actualEndTimeCol] : "";
                 matchDataFound = true;
                 break;
             }
@@ -1640,45 +1447,33 @@ char* getTimeFromUser(const char* prompt) {
             int score2 = getInt("Enter Team 2 Score: ");
             char* winnerId_cstr = getString("Enter Winner Team ID: ");
 
-            // Update dataContainer2D allMatches in memory
             std::string s1_str = std::to_string(score1);
             std::string s2_str = std::to_string(score2);
-
-            delete[] allMatches.data[matchRowIdx][actualStartTimeCol]; // Delete old string
-            allMatches.data[matchRowIdx][actualStartTimeCol] = duplicateString(actual_start_time_input);
-            
-            delete[] allMatches.data[matchRowIdx][actualEndTimeCol];   // Delete old string
-            allMatches.data[matchRowIdx][actualEndTimeCol] = duplicateString(actual_end_time_input);
-
-            delete[] allMatches.data[matchRowIdx][t1ScoreCol];
-            allMatches.data[matchRowIdx][t1ScoreCol] = duplicateString(s1_str.c_str());
-            delete[] allMatches.data[matchRowIdx][t2ScoreCol];
-            allMatches.data[matchRowIdx][t2ScoreCol] = duplicateString(s2_str.c_str());
-            delete[] allMatches.data[matchRowIdx][winnerCol];
-            allMatches.data[matchRowIdx][winnerCol] = duplicateString(winnerId_cstr);
-            delete[] allMatches.data[matchRowIdx][statusCol];
-            allMatches.data[matchRowIdx][statusCol] = duplicateString("Completed");
             
             // Update foundMatchForProgression object for handleTeamProgression if it was found
             if (matchDataFound) {
-                delete[] foundMatchForProgression.actual_start_time; // Delete previously copied/default value
-                foundMatchForProgression.actual_start_time = duplicateString(actual_start_time_input);
-                delete[] foundMatchForProgression.actual_end_time;   // Delete previously copied/default value
-                foundMatchForProgression.actual_end_time = duplicateString(actual_end_time_input);
+                foundMatchForProgression.actual_start_time = actual_start_time_input ? actual_start_time_input : "";
+                foundMatchForProgression.actual_end_time = actual_end_time_input ? actual_end_time_input : "";
                 foundMatchForProgression.team1_score = score1; 
                 foundMatchForProgression.team2_score = score2;
-                delete[] foundMatchForProgression.winner_team_id; 
-                foundMatchForProgression.winner_team_id = duplicateString(winnerId_cstr);
-                delete[] foundMatchForProgression.match_status;   
-                foundMatchForProgression.match_status   = duplicateString("Completed");
+                foundMatchForProgression.winner_team_id = internString(winnerId_cstr);
+                foundMatchForProgression.match_status   = internString("Completed");
             }
 
-            if (writeData(MATCH_CSV, allMatches) == 0) {
-                std::cout << "Match result (including times) updated successfully in " << MATCH_CSV << std::endl;
+            // match.csv, tournament_bracket.csv and gameStat.csv are written together or not at all
+            Transaction results;
+            const char* resultFields[] = { "actual_start_time", "actual_end_time", "team1_score", "team2_score", "winner_team_id", "match_status" };
+            const char* resultValues[] = { actual_start_time_input, actual_end_time_input, s1_str.c_str(), s2_str.c_str(), winnerId_cstr, "Completed" };
+            if (results.updateFieldsByKey(MATCH_CSV, matchIdToUpdate_str.c_str(), 6, resultFields, resultValues) == 0) {
                 if (matchDataFound) {
                     // Pass the updated foundMatchForProgression object
-                    handleTeamProgression(foundMatchForProgression); 
-                    generateAndSaveGameStats(foundMatchForProgression);
+                    handleTeamProgression(foundMatchForProgression, results); 
+                    generateAndSaveGameStats(foundMatchForProgression, results);
+                }
+                if (results.commit() == 0) {
+                    std::cout << "Match result (including times) updated successfully in " << MATCH_CSV << std::endl;
+                } else {
+                    std::cout << "Error writing updated match data to " << MATCH_CSV << "; no changes were saved." << std::endl;
                 }
             } else {
                 std::cout << "Error writing updated match data to " << MATCH_CSV << std::endl;
@@ -1725,14 +1520,9 @@ Team selectTeamForProgressionMatch(const char* prompt, const dataContainer2D& br
     Team* eligibleTeams = new Team[bracketStates.y > 0 ? bracketStates.y : 1];
     int eligibleCount = 0;
 
-    int teamIdCol_bs = -1, bracketCol_bs = -1, positionCol_bs = -1;
-     if (bracketStates.x > 0 && bracketStates.fields) {
-        for (int k = 0; k < bracketStates.x; ++k) {
-            if (strcmp(bracketStates.fields[k], "team_id") == 0) teamIdCol_bs = k;
-            else if (strcmp(bracketStates.fields[k], "bracket") == 0) bracketCol_bs = k;
-            else if (strcmp(bracketStates.fields[k], "position") == 0) positionCol_bs = k;
-        }
-    }
+    int teamIdCol_bs = Brackets::TeamId.in(bracketStates);
+    int bracketCol_bs = Brackets::Bracket.in(bracketStates);
+    int positionCol_bs = Brackets::Position.in(bracketStates);
 
     if (teamIdCol_bs == -1 || bracketCol_bs == -1 || positionCol_bs == -1) {
         std::cerr << "Error: Required columns (team_id, bracket, position) missing in tournament_bracket.csv for team selection." << std::endl;
@@ -1800,48 +1590,29 @@ Team selectTeamForProgressionMatch(const char* prompt, const dataContainer2D& br
 
    // This is a helper that can be called after a new match is scheduled.
     void updateTeamPositionInBracketFile(const char* teamId, const char* newMatchId, const char* newMatchLevel, bool isTeam1) {
-        dataContainer2D bracketData = getData(TOURNAMENT_BRACKET_CSV);
-        bool updated = false;
-        if (!bracketData.error && bracketData.y > 0) {
-            int teamIdCol = -1, posCol = -1;
-            for(int k=0; k<bracketData.x; ++k) {
-                if(strcmp(bracketData.fields[k], "team_id")==0) teamIdCol=k;
-                else if(strcmp(bracketData.fields[k], "position")==0) posCol=k;
-            }
-
-            if (teamIdCol != -1 && posCol != -1) {
-                for (int i = 0; i < bracketData.y; ++i) {
-                    if (bracketData.data[i][teamIdCol] && strcmp(bracketData.data[i][teamIdCol], teamId) == 0) {
-                        delete[] bracketData.data[i][posCol];
-                        std::string positionStr = std::string(newMatchLevel) + " vs " + newMatchId + (isTeam1 ? "-P1" : "-P2");
-                        bracketData.data[i][posCol] = duplicateString(positionStr.c_str());
-                        updated = true;
-                        break;
-                    }
-                }
-                if (updated) {
-                    writeData(TOURNAMENT_BRACKET_CSV, bracketData);
-                    std::cout << "Team " << teamId << " position updated in " << TOURNAMENT_BRACKET_CSV << std::endl;
-                } else {
-                    std::cout << "Warning: Team " << teamId << " not found in " << TOURNAMENT_BRACKET_CSV << " to update position for new match." << std::endl;
-                }
-            } else {
-                std::cerr << "Warning: Required columns (team_id, position) missing in " << TOURNAMENT_BRACKET_CSV << " for position update." << std::endl;
-            }
+        std::string positionStr = std::string(newMatchLevel) + " vs " + newMatchId + (isTeam1 ? "-P1" : "-P2");
+        const char* positionField = "position";
+        const char* positionValue = positionStr.c_str();
+        int result = updateFieldsByKey(TOURNAMENT_BRACKET_CSV, teamId, 1, &positionField, &positionValue);
+        if (result == 0) {
+            std::cout << "Team " << teamId << " position updated in " << TOURNAMENT_BRACKET_CSV << std::endl;
+        } else if (result == 3) {
+            std::cout << "Warning: Team " << teamId << " not found in " << TOURNAMENT_BRACKET_CSV << " to update position for new match." << std::endl;
+        } else if (result == 2) {
+            std::cerr << "Warning: Required columns (team_id, position) missing in " << TOURNAMENT_BRACKET_CSV << " for position update." << std::endl;
         } else {
             std::cerr << "Warning: Could not load or empty " << TOURNAMENT_BRACKET_CSV << " for position update." << std::endl;
         }
-        deleteDataContainer2D(bracketData);
     }
 
         Team* findTeamsByStatus(const dataContainer2D& bracketData, const char* statusNeedle, const char* statusColumnName, int& count_out, Team* allLoadedTeams, int totalLoadedTeamCount) {
         count_out = 0;
         if (bracketData.error || bracketData.y == 0) return nullptr;
 
-        int teamIdCol = -1, statusCol = -1;
+        int teamIdCol = Brackets::TeamId.in(bracketData);
+        int statusCol = -1;
         for (int k = 0; k < bracketData.x; ++k) {
-            if (strcmp(bracketData.fields[k], "team_id") == 0) teamIdCol = k;
-            else if (strcmp(bracketData.fields[k], statusColumnName) == 0) statusCol = k; // "position" or "bracket"
+            if (strcmp(bracketData.fields[k], statusColumnName) == 0) statusCol = k; // "position" or "bracket"
         }
         if (teamIdCol == -1 || statusCol == -1) return nullptr;
 
@@ -2068,15 +1839,7 @@ Team selectTeamForProgressionMatch(const char* prompt, const dataContainer2D& br
             if (confirm_str == "yes" || confirm_str == "y") {
                 // Find the column index of 'match_id' in match.csv to pass to deleteByKey
                dataContainer2D tempMatchData =getData(MATCH_CSV);
-                int matchIdColIdx = -1;
-                if (!tempMatchData.error && tempMatchData.fields && tempMatchData.x > 0) {
-                    for (int k = 0; k < tempMatchData.x; ++k) {
-                        if (tempMatchData.fields[k] && strcmp(tempMatchData.fields[k], "match_id") == 0) {
-                            matchIdColIdx = k;
-                            break;
-                        }
-                    }
-                }
+                int matchIdColIdx = Matches::MatchId.in(tempMatchData);
                deleteDataContainer2D(tempMatchData);
 
                 if (matchIdColIdx == -1) {
@@ -2100,6 +1863,8 @@ Team selectTeamForProgressionMatch(const char* prompt, const dataContainer2D& br
     }
 
     void manageMatchSchedulingAndProgression() {
+        declareSecondaryIndex(TEAMS_CSV, "CheckInStatus");
+
         // These queues/stacks would manage teams between rounds.
         // For simplicity in this example, their full usage in generating next-round matches is not detailed.
         // Their size should be appropriate for the number of teams.
@@ -5,6 +5,7 @@
 #include <cstring>
 #include <cstdlib>
 #include "File_exe.hpp"  
+#include "EsportsTables.hpp"
 
 using namespace CsvToolkit;
 
@@ -410,23 +411,15 @@ private:
     }
 };
 
-static int getColumnIndex(const dataContainer2D& dc, const char* name) {
-    if (dc.error || !dc.fields) return -1;
-    for (int i = 0; i < dc.x; ++i) {
-        if (dc.fields[i] && std::strcmp(dc.fields[i], name) == 0) {
-            return i;
-        }
-    }
-    return -1;
-}
-
 static int loadSpectatorsCSV(const char* filename, Spectator allSpecs[], int& outCount) {
-    dataContainer2D dc = getData(filename);
+    const char* wanted[] = { Spectators::SpectatorId.name, Spectators::SpectatorName.name,
+                             Spectators::SpectatorType.name, Spectators::CheckIn.name };
+    dataContainer2D dc = getData(filename, wanted, 4);
     if (dc.error) return -1;
-    int idCol   = getColumnIndex(dc, "spectator_id");
-    int nameCol = getColumnIndex(dc, "spectator_name");
-    int typeCol = getColumnIndex(dc, "spectator_type");
-    int checkCol= getColumnIndex(dc, "check_in");
+    int idCol   = Spectators::SpectatorId.in(dc);
+    int nameCol = Spectators::SpectatorName.in(dc);
+    int typeCol = Spectators::SpectatorType.in(dc);
+    int checkCol= Spectators::CheckIn.in(dc);
     if (idCol < 0 || nameCol < 0 || typeCol < 0 || checkCol < 0) {
         deleteDataContainer2D(dc);
         return -1;
@@ -452,10 +445,11 @@ static int loadSpectatorsCSV(const char* filename, Spectator allSpecs[], int& ou
 }
 
 static int loadSeatAssignmentsCSV(const char* filename, Spectator allSpecs[], int allCount, ZoneManager& zm) {
-    dataContainer2D dc = getData(filename);
+    const char* wanted[] = { SeatAssignments::SpectatorId.name, SeatAssignments::SectionName.name };
+    dataContainer2D dc = getData(filename, wanted, 2);
     if (dc.error) return -1;
-    int specIdCol = getColumnIndex(dc, "spectator_id");
-    int sectionCol= getColumnIndex(dc, "section_name");
+    int specIdCol = SeatAssignments::SpectatorId.in(dc);
+    int sectionCol= SeatAssignments::SectionName.in(dc);
     if (specIdCol < 0 || sectionCol < 0) {
         deleteDataContainer2D(dc);
         return -1;
@@ -0,0 +1,233 @@
+#ifndef ESPORTS_TABLES_HPP
+#define ESPORTS_TABLES_HPP
+
+#include "File_exe.hpp"
+
+using namespace CsvToolkit;
+
+// Schemas of the championship's CSV files. Each table lists its columns once;
+// getData checks every load of the file against the list, and the handles below
+// give typed, index-based access to a column without searching the header, e.g.
+//     int points = cellInt(teams, i, Teams::RankingPoint);
+//     int statusCol = Matches::MatchStatus.in(matches);
+// Handles must stay in the same order as their table's 'columns'.
+namespace EsportsTables {
+
+    // --- teams.csv ---
+    struct TeamsTable {
+        static constexpr SchemaColumn columns[] = {
+            {"TeamID", COLUMN_STRING},
+            {"TeamName", COLUMN_STRING},
+            {"University", COLUMN_STRING},
+            {"Country", COLUMN_STRING},
+            {"TeamType", COLUMN_STRING},
+            {"RegistereDate", COLUMN_DATE},
+            {"RegisterTime", COLUMN_TIME},
+            {"RankingPoint", COLUMN_INT},
+            {"TeamStatus", COLUMN_STRING},
+            {"CheckedInTime", COLUMN_TIME},
+            {"CheckInStatus", COLUMN_STRING}
+        };
+        static inline TableSchema schema{"teams.csv", columns, sizeof(columns) / sizeof(columns[0])};
+    };
+
+    namespace Teams {
+        constexpr Column<TeamsTable, 0> TeamID{};
+        constexpr Column<TeamsTable, 1> TeamName{};
+        constexpr Column<TeamsTable, 2> University{};
+        constexpr Column<TeamsTable, 3> Country{};
+        constexpr Column<TeamsTable, 4> TeamType{};
+        constexpr Column<TeamsTable, 5> RegisterDate{};
+        constexpr Column<TeamsTable, 6> RegisterTime{};
+        constexpr Column<TeamsTable, 7> RankingPoint{};
+        constexpr Column<TeamsTable, 8> TeamStatus{};
+        constexpr Column<TeamsTable, 9> CheckedInTime{};
+        constexpr Column<TeamsTable, 10> CheckInStatus{};
+    }
+
+    // --- player.csv ---
+    struct PlayersTable {
+        static constexpr SchemaColumn columns[] = {
+            {"PlayerID", COLUMN_STRING},
+            {"PlayerName", COLUMN_STRING},
+            {"TeamID", COLUMN_STRING},
+            {"Role", COLUMN_STRING},
+            {"University", COLUMN_STRING},
+            {"Country", COLUMN_STRING},
+            {"InGameName", COLUMN_STRING},
+            {"Email", COLUMN_STRING},
+            {"RankingPoint", COLUMN_INT},
+            {"PlayerStatus", COLUMN_STRING},
+            {"EligibilityStatus", COLUMN_STRING},
+            {"CheckedInTime", COLUMN_STRING} // YYYY-MM-DD HH:MM, or NULL
+        };
+        static inline TableSchema schema{"player.csv", columns, sizeof(columns) / sizeof(columns[0])};
+    };
+
+    namespace Players {
+        constexpr Column<PlayersTable, 0> PlayerID{};
+        constexpr Column<PlayersTable, 1> PlayerName{};
+        constexpr Column<PlayersTable, 2> TeamID{};
+        constexpr Column<PlayersTable, 3> Role{};
+        constexpr Column<PlayersTable, 4> University{};
+        constexpr Column<PlayersTable, 5> Country{};
+        constexpr Column<PlayersTable, 6> InGameName{};
+        constexpr Column<PlayersTable, 7> Email{};
+        constexpr Column<PlayersTable, 8> RankingPoint{};
+        constexpr Column<PlayersTable, 9> PlayerStatus{};
+        constexpr Column<PlayersTable, 10> EligibilityStatus{};
+        constexpr Column<PlayersTable, 11> CheckedInTime{};
+    }
+
+    // --- match.csv ---
+    struct MatchesTable {
+        static constexpr SchemaColumn columns[] = {
+            {"match_id", COLUMN_STRING},
+            {"scheduled_date", COLUMN_DATE},
+            {"scheduled_time", COLUMN_TIME},
+            {"actual_start_time", COLUMN_TIME},
+            {"actual_end_time", COLUMN_TIME},
+            {"team1_id", COLUMN_STRING},
+            {"team2_id", COLUMN_STRING},
+            {"winner_team_id", COLUMN_STRING},
+            {"team1_score", COLUMN_INT},
+            {"team2_score", COLUMN_INT},
+            {"match_status", COLUMN_STRING},
+            {"match_level", COLUMN_STRING}
+        };
+        static inline TableSchema schema{"match.csv", columns, sizeof(columns) / sizeof(columns[0])};
+    };
+
+    namespace Matches {
+        constexpr Column<MatchesTable, 0> MatchId{};
+        constexpr Column<MatchesTable, 1> ScheduledDate{};
+        constexpr Column<MatchesTable, 2> ScheduledTime{};
+        constexpr Column<MatchesTable, 3> ActualStartTime{};
+        constexpr Column<MatchesTable, 4> ActualEndTime{};
+        constexpr Column<MatchesTable, 5> Team1Id{};
+        constexpr Column<MatchesTable, 6> Team2Id{};
+        constexpr Column<MatchesTable, 7> WinnerTeamId{};
+        constexpr Column<MatchesTable, 8> Team1Score{};
+        constexpr Column<MatchesTable, 9> Team2Score{};
+        constexpr Column<MatchesTable, 10> MatchStatus{};
+        constexpr Column<MatchesTable, 11> MatchLevel{};
+    }
+
+    // --- gameStat.csv ---
+    struct GameStatsTable {
+        static constexpr SchemaColumn columns[] = {
+            {"match_id", COLUMN_STRING},
+            {"InGameName", COLUMN_STRING},
+            {"hero_played", COLUMN_STRING},
+            {"kills", COLUMN_INT},
+            {"deaths", COLUMN_INT},
+            {"assists", COLUMN_INT},
+            {"gpm", COLUMN_INT},
+            {"xpm", COLUMN_INT}
+        };
+        static inline TableSchema schema{"gameStat.csv", columns, sizeof(columns) / sizeof(columns[0])};
+    };
+
+    namespace GameStats {
+        constexpr Column<GameStatsTable, 0> MatchId{};
+        constexpr Column<GameStatsTable, 1> InGameName{};
+        constexpr Column<GameStatsTable, 2> HeroPlayed{};
+        constexpr Column<GameStatsTable, 3> Kills{};
+        constexpr Column<GameStatsTable, 4> Deaths{};
+        constexpr Column<GameStatsTable, 5> Assists{};
+        constexpr Column<GameStatsTable, 6> Gpm{};
+        constexpr Column<GameStatsTable, 7> Xpm{};
+    }
+
+    // --- tournament_bracket.csv ---
+    struct BracketTable {
+        static constexpr SchemaColumn columns[] = {
+            {"team_id", COLUMN_STRING},
+            {"position", COLUMN_STRING},
+            {"bracket", COLUMN_STRING}
+        };
+        static inline TableSchema schema{"tournament_bracket.csv", columns, sizeof(columns) / sizeof(columns[0])};
+    };
+
+    namespace Brackets {
+        constexpr Column<BracketTable, 0> TeamId{};
+        constexpr Column<BracketTable, 1> Position{};
+        constexpr Column<BracketTable, 2> Bracket{};
+    }
+
+    // --- spectators.csv ---
+    struct SpectatorsTable {
+        static constexpr SchemaColumn columns[] = {
+            {"spectator_id", COLUMN_STRING},
+            {"spectator_name", COLUMN_STRING},
+            {"spectator_type", COLUMN_STRING},
+            {"email_contact", COLUMN_STRING},
+            {"organization", COLUMN_STRING},
+            {"register_timestamp", COLUMN_STRING},
+            {"check_in", COLUMN_INT}
+        };
+        static inline TableSchema schema{"spectators.csv", columns, sizeof(columns) / sizeof(columns[0])};
+    };
+
+    namespace Spectators {
+        constexpr Column<SpectatorsTable, 0> SpectatorId{};
+        constexpr Column<SpectatorsTable, 1> SpectatorName{};
+        constexpr Column<SpectatorsTable, 2> SpectatorType{};
+        constexpr Column<SpectatorsTable, 3> EmailContact{};
+        constexpr Column<SpectatorsTable, 4> Organization{};
+        constexpr Column<SpectatorsTable, 5> RegisterTimestamp{};
+        constexpr Column<SpectatorsTable, 6> CheckIn{};
+    }
+
+    // --- seatAssignment.csv ---
+    struct SeatAssignmentsTable {
+        static constexpr SchemaColumn columns[] = {
+            {"assignment_id", COLUMN_STRING},
+            {"spectator_id", COLUMN_STRING},
+            {"seat_number", COLUMN_STRING},
+            {"section_name", COLUMN_STRING},
+            {"assigned_datetime", COLUMN_STRING},
+            {"notes", COLUMN_STRING}
+        };
+        static inline TableSchema schema{"seatAssignment.csv", columns, sizeof(columns) / sizeof(columns[0])};
+    };
+
+    namespace SeatAssignments {
+        constexpr Column<SeatAssignmentsTable, 0> AssignmentId{};
+        constexpr Column<SeatAssignmentsTable, 1> SpectatorId{};
+        constexpr Column<SeatAssignmentsTable, 2> SeatNumber{};
+        constexpr Column<SeatAssignmentsTable, 3> SectionName{};
+        constexpr Column<SeatAssignmentsTable, 4> AssignedDatetime{};
+        constexpr Column<SeatAssignmentsTable, 5> Notes{};
+    }
+
+    // --- streamSchedule.csv ---
+    struct StreamScheduleTable {
+        static constexpr SchemaColumn columns[] = {
+            {"stream_slot_id", COLUMN_STRING},
+            {"stream_platform_channel", COLUMN_STRING},
+            {"streamer_name", COLUMN_STRING},
+            {"match_id_being_streamed", COLUMN_STRING},
+            {"scheduled_start_time", COLUMN_STRING},
+            {"scheduled_end_time", COLUMN_STRING},
+            {"dedicated_viewing_area_id", COLUMN_STRING},
+            {"technical_requirements", COLUMN_STRING}
+        };
+        static inline TableSchema schema{"streamSchedule.csv", columns, sizeof(columns) / sizeof(columns[0])};
+    };
+
+    namespace StreamSchedule {
+        constexpr Column<StreamScheduleTable, 0> StreamSlotId{};
+        constexpr Column<StreamScheduleTable, 1> PlatformChannel{};
+        constexpr Column<StreamScheduleTable, 2> StreamerName{};
+        constexpr Column<StreamScheduleTable, 3> MatchId{};
+        constexpr Column<StreamScheduleTable, 4> ScheduledStartTime{};
+        constexpr Column<StreamScheduleTable, 5> ScheduledEndTime{};
+        constexpr Column<StreamScheduleTable, 6> ViewingAreaId{};
+        constexpr Column<StreamScheduleTable, 7> TechnicalRequirements{};
+    }
+}
+
+using namespace EsportsTables;
+
+#endif // ESPORTS_TABLES_HPP
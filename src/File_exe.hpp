@@ -6,13 +6,51 @@
 #include <string>        // For std::string
 #include <cstring>       // For strcpy, strlen, strcmp, etc. (C-style string functions)
 #include <cstdlib>       // For std::atoi, std::atof
+#include <cstdint>       // For uintptr_t (arena alignment)
+#include <vector>        // For std::vector (row staging)
 #include <cmath>         // For std::floor, other math functions
 #include <cctype>        // For std::isdigit, std::tolower
 #include <filesystem>    // For path manipulation (C++17)
 #include <limits>        // For std::numeric_limits
 #include <chrono>        // For std::chrono (sleep)
-#include <thread>        // For std::this_thread (sleep)
+#include <thread>        // For std::this_thread (sleep), parallel parsing
+#include <atomic>        // For the parse thread pool's task counter
 #include <sstream>       // For std::ostringstream
+#include <iterator>      // For std::istreambuf_iterator (mmap fallback)
+#include <memory>        // For std::shared_ptr (table cache)
+#include <unordered_map> // For the table cache
+#include <unordered_set> // For the moved rows CsvReader has already returned
+#include <string_view>   // For the string pool's lookup keys
+#include <algorithm>     // For std::sort, std::lower_bound
+#include <charconv>      // For std::from_chars, std::to_chars (snapshot int columns)
+#include <cerrno>        // For errno (CsvWriter)
+#ifndef _WIN32
+#include <fcntl.h>       // For open
+#include <sys/mman.h>    // For mmap, munmap
+#include <sys/stat.h>    // For fstat
+#include <unistd.h>      // For close, write
+#include <sys/file.h>    // For flock (write-ahead log)
+#endif
+#ifdef __linux__
+#include <sys/inotify.h> // For the data directory watcher
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>   // For the SSE2 and AVX2 structural scans
+#define CSV_TOOLKIT_SSE2 1
+// GCC and Clang compile the AVX2 scan for its own function only and pick it at
+// run time, so a default build still uses AVX2 where the CPU has it.
+#if defined(__AVX2__) || defined(__GNUC__)
+#define CSV_TOOLKIT_AVX2 1
+#endif
+#endif
+#if defined(__AVX2__) || !defined(__GNUC__)
+#define CSV_TOOLKIT_TARGET_AVX2
+#else
+#define CSV_TOOLKIT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>      // For _BitScanForward
+#endif
 
 // Define a namespace alias for std::filesystem
 namespace fs = std::filesystem;
@@ -20,16 +58,135 @@ namespace fs = std::filesystem;
 namespace CsvToolkit {
 
     // --- Data Structures ---
+
+    // Bump allocator for arena-backed containers. Header names, row arrays and
+    // cell bytes are carved out of a few large blocks and released together.
+    struct CellArena {
+        struct Block {
+            Block* next;
+            size_t used;
+            size_t capacity;
+            char* bytes() { return reinterpret_cast<char*>(this + 1); }
+        };
+
+        static constexpr size_t kBlockSize = 64 * 1024;
+
+        Block* head;
+        size_t firstBlockSize; // getData sizes this to the whole file...
+        size_t blockSize;      // ...while cells written later come from small blocks
+
+        explicit CellArena(size_t firstBlock = kBlockSize) : head(nullptr), firstBlockSize(firstBlock), blockSize(kBlockSize) {}
+        ~CellArena() { release(); }
+        CellArena(const CellArena&) = delete;
+        CellArena& operator=(const CellArena&) = delete;
+
+        void* allocate(size_t bytes, size_t align = alignof(void*)) {
+            if (head) {
+                uintptr_t base = reinterpret_cast<uintptr_t>(head->bytes());
+                uintptr_t start = (base + head->used + align - 1) & ~static_cast<uintptr_t>(align - 1);
+                if (start + bytes <= base + head->capacity) {
+                    head->used = (start - base) + bytes;
+                    return reinterpret_cast<void*>(start);
+                }
+            }
+            size_t capacity = bytes + align;
+            size_t wanted = head ? blockSize : firstBlockSize;
+            bool oversized = capacity > wanted;
+            if (!oversized) capacity = wanted;
+            Block* block = static_cast<Block*>(::operator new(sizeof(Block) + capacity));
+            block->capacity = capacity;
+            if (oversized && head) { // Keep the partially used head block current for small cells
+                block->next = head->next;
+                head->next = block;
+            } else {
+                block->next = head;
+                head = block;
+            }
+            uintptr_t base = reinterpret_cast<uintptr_t>(block->bytes());
+            uintptr_t start = (base + align - 1) & ~static_cast<uintptr_t>(align - 1);
+            block->used = (start - base) + bytes;
+            return reinterpret_cast<void*>(start);
+        }
+
+        char* copyString(const char* cstr, size_t length) {
+            char* out = static_cast<char*>(allocate(length + 1, 1));
+            if (length > 0) memcpy(out, cstr, length);
+            out[length] = '\0';
+            return out;
+        }
+        char* copyString(const char* cstr) { return copyString(cstr ? cstr : "", cstr ? strlen(cstr) : 0); }
+
+        // Takes over every block of 'other' (left empty); the current block stays current.
+        void adopt(CellArena& other) {
+            if (!other.head) return;
+            Block* tail = other.head;
+            while (tail->next) tail = tail->next;
+            if (head) {
+                tail->next = head->next;
+                head->next = other.head;
+            } else {
+                head = other.head;
+            }
+            other.head = nullptr;
+        }
+
+        void release() {
+            while (head) {
+                Block* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    };
+
+    // Process-wide set of distinct strings. intern() returns one stable pointer
+    // per distinct value, so two interned strings are equal exactly when their
+    // pointers are. Ids are dense, in first-seen order. Nothing is freed before
+    // exit, so interned pointers are never passed to delete[].
+    class StringPool {
+    public:
+        static StringPool& instance();
+
+        const char* intern(const char* text); // Null interns as ""
+        const char* intern(const char* text, size_t length);
+        const char* find(const char* text) const; // Interned copy, or null if never interned
+        uint32_t idOf(const char* text);
+        const char* stringAt(uint32_t id) const { return strings[id]; }
+        size_t size() const { return strings.size(); }
+
+    private:
+        StringPool() {}
+        StringPool(const StringPool&) = delete;
+        StringPool& operator=(const StringPool&) = delete;
+
+        CellArena bytes;
+        std::unordered_map<std::string_view, uint32_t> ids;
+        std::vector<const char*> strings;
+    };
+
+    // Owns its header, rows and cells, and frees them when it goes out of scope.
+    // Move-only: results flow out of getData, filterDataContainer and friends
+    // without a copy, and no two containers ever own the same cells. Calling
+    // deleteDataContainer2D early is still fine; it leaves the container empty.
+    // getData packs the cells back to back in the arena in row order, so a short
+    // cell costs its pointer plus its bytes and a row's cells share cache lines.
     struct dataContainer2D {
         int error;
         char** fields;
         char*** data;
         int y; // Number of data rows
         int x; // Number of columns (fields)
-
-        dataContainer2D() : error(0), fields(nullptr), data(nullptr), y(0), x(0) {}
+        CellArena* arena; // Non-null when fields, rows and cells all live in one arena (see getData)
+
+        dataContainer2D() : error(0), fields(nullptr), data(nullptr), y(0), x(0), arena(nullptr) {}
+        ~dataContainer2D();
+        dataContainer2D(dataContainer2D&& other) noexcept;
+        dataContainer2D& operator=(dataContainer2D&& other) noexcept;
+        dataContainer2D(const dataContainer2D&) = delete;
+        dataContainer2D& operator=(const dataContainer2D&) = delete;
     };
 
+    // One row (or column) of values; owns them like dataContainer2D and is move-only too.
     struct dataContainer1D {
         int error;
         char** fields;
@@ -38,6 +195,776 @@ namespace CsvToolkit {
         int x; // Number of elements in the 'data' array
 
         dataContainer1D() : error(0), fields(nullptr), fields_count(0), data(nullptr), x(0) {}
+        ~dataContainer1D();
+        dataContainer1D(dataContainer1D&& other) noexcept;
+        dataContainer1D& operator=(dataContainer1D&& other) noexcept;
+        dataContainer1D(const dataContainer1D&) = delete;
+        dataContainer1D& operator=(const dataContainer1D&) = delete;
+    };
+
+    // The data directory, found once per process (see the constructor) instead of
+    // on every read and write, so all of them agree on it. On POSIX the directory
+    // is held open and data files are opened and stat'ed relative to it
+    // (openat/fstatat), which costs one system call per file operation.
+    class DataStore {
+    public:
+        static DataStore& instance();
+        ~DataStore();
+
+        const fs::path& root() const { return root_; }
+        fs::path pathOf(const std::string& filenameWithExtension) const { return root_ / filenameWithExtension; }
+        // Creates the directory if it does not exist yet; false if that fails.
+        bool ensureRoot();
+        // Descriptor for the file (flags as for open(2)), or -1; POSIX only.
+        int openFile(const std::string& filenameWithExtension, int flags, int mode = 0644);
+        bool statFile(const std::string& filenameWithExtension, fs::file_time_type& modifiedAt, uintmax_t& fileSize);
+        bool syncRoot(); // fsyncs the directory, making renames in it durable
+        // Switches to another directory, e.g. for a tool working on a copy of the
+        // data. Queued writes are committed and cached tables dropped first.
+        void setRoot(const fs::path& dataDir);
+
+    private:
+        DataStore();
+        void attach(const fs::path& dataDir);
+        bool fileClockOffset(fs::file_time_type::duration& offset);
+
+        fs::path root_;
+        int dirFd_;
+        bool rootExists_;
+        fs::file_time_type::duration clockOffset_; // file_time_type epoch to Unix epoch
+        bool clockOffsetKnown_;
+        DataStore(const DataStore&) = delete;
+        DataStore& operator=(const DataStore&) = delete;
+    };
+
+    // Read-only view of a whole file: mmap'd where available, otherwise read into memory.
+    struct MappedFile {
+        const char* data;
+        size_t size;
+
+        MappedFile() : data(nullptr), size(0), mapped_(false) {}
+        ~MappedFile() { close(); }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        int open(const fs::path& path); // 0 on success, 1 if the file cannot be read
+        int openData(const std::string& filenameWithExtension); // A file in the data directory, as open()
+        void close();
+
+    private:
+        int map(int fd, const fs::path& path);
+
+        bool mapped_;
+        std::string fallback_;
+    };
+
+    // Instruction set used by indexCsvStructure. Each level also uses the ones below
+    // it for the bytes left over after its last full block.
+    enum CsvScanKernel {
+        CSV_SCAN_SCALAR,
+        CSV_SCAN_SSE2, // 16 bytes per step
+        CSV_SCAN_AVX2  // 32 bytes per step
+    };
+
+    // A cell as a byte range of the mapped file. hasQuotes marks ranges that must
+    // be unquoted (see unquoteCell) when the value is materialized.
+    struct CellView {
+        size_t offset;
+        uint32_t length;
+        bool hasQuotes;
+    };
+
+    // Where a data row lives in its file. 'span' runs to the start of the next row
+    // or row pointer, so it also covers filler lines after the row left by earlier
+    // in-place patches (see writeChangedRows). A row that outgrew its place was
+    // appended at the end of the file; 'order' is then the offset of the row
+    // pointer left where it used to be, and gives its position in the table.
+    struct RowExtent {
+        size_t offset;
+        size_t length; // Row text, with any '\r' but without the '\n'
+        size_t span;
+        size_t order; // Same as offset unless the row was moved
+    };
+
+    // A line starting with '#' is a comment and never a row; in-place patches fill
+    // the bytes a row gives up with such lines. A row pointer is the comment "#>"
+    // followed by the moved row's offset as ROW_POINTER_DIGITS hex digits.
+    enum { ROW_POINTER_DIGITS = 12, ROW_POINTER_BYTES = 2 + ROW_POINTER_DIGITS };
+
+    // Byte layout of a CSV's data rows, as recorded by loadCsvViews.
+    struct CsvLayout {
+        size_t dataStart; // First byte after the header line
+        bool crlf; // The header line ends in "\r\n"; rows written to the file do too
+        std::vector<RowExtent> rows;
+
+        CsvLayout() : dataStart(0), crlf(false) {}
+    };
+
+    // Fixed header of a "<file>.snap" binary snapshot. After it come: a uint32 kind
+    // per column (SNAPSHOT_STRING or SNAPSHOT_INT), a uint32 dictionary code per
+    // column name, a uint64 offset and order and a uint32 length and span per row
+    // (the RowExtent), then each column as 'rows' uint32 codes or int32 values, then
+    // the dictionary: stringCount + 1 uint32 offsets followed by NUL-terminated strings.
+    struct SnapshotHeader {
+        char magic[8];         // "CSVSNAP3"
+        uint32_t columns;
+        uint32_t rows;
+        uint64_t csvSize;      // Stamps of the CSV the snapshot was built from
+        int64_t csvModifiedAt;
+        uint64_t dataStart;
+        uint32_t crlf;         // CsvLayout::crlf
+        uint32_t reserved;     // Zero
+        uint32_t stringCount;
+        uint32_t checksum;     // hashWords of everything after the header
+    };
+    enum SnapshotColumnKind { SNAPSHOT_STRING = 0, SNAPSHOT_INT = 1 };
+
+    // One row of a mapped file (several lines when a quoted field holds a line
+    // break) plus the range of its entries in the structural index.
+    struct IndexedLine {
+        size_t start;
+        size_t length;
+        size_t firstStructural;
+        size_t endStructural;
+        bool reachedEnd;
+    };
+
+    // One byte range of a CSV's data rows, parsed on its own. Ranges start and end
+    // on row breaks, so every range holds whole rows. 'lines' counts every line
+    // in the range, blank ones, comments and those inside quoted fields included,
+    // to recover file line numbers.
+    struct CsvChunk {
+        size_t begin;
+        size_t end;
+        size_t lines;
+        std::vector<CellView> cells;
+        std::vector<RowExtent> rows;
+        std::vector<std::pair<size_t, size_t>> pointers; // Offset of each row pointer line and the row it names
+        std::vector<size_t> unbalancedLines; // First line of each such row, 1-based within the range
+
+        CsvChunk() : begin(0), end(0), lines(0) {}
+    };
+
+    // Zero-copy result of loadCsvViews; cells are row-major, y * x entries.
+    struct CsvViewTable {
+        int error;
+        MappedFile file;
+        int x;
+        int y;
+        std::vector<CellView> fields;
+        std::vector<CellView> cells;
+        CsvLayout layout;
+
+        CsvViewTable() : error(0), x(0), y(0) {}
+        const CellView& cell(int row, int col) const { return cells[static_cast<size_t>(row) * x + col]; }
+        std::string cellString(int row, int col) const;
+    };
+
+    // Row test for the projecting getData: a row is kept when its 'field' cell
+    // equals one of 'keys'. Without a field every row is kept.
+    struct RowFilter {
+        const char* field;
+        std::vector<const char*> keys;
+
+        RowFilter() : field(nullptr) {}
+        RowFilter(const char* filterField, const char* key) : field(filterField), keys(1, key) {}
+        RowFilter(const char* filterField, const std::vector<const char*>& anyOf) : field(filterField), keys(anyOf) {}
+        bool accepts(std::string_view value) const;
+    };
+
+    // Forward-only reader that holds one row at a time, for files too large to
+    // load whole. Bytes come in through a fixed-size buffer (grown only for a row
+    // longer than it), and rows split exactly as getData splits them. next()
+    // moves to the following data row; cell() pointers last until the next call.
+    // A row moved to the end of the file is read at its row pointer, through a
+    // second handle, so rows come in the same order as from getData.
+    struct CsvReader {
+        int error;
+
+        explicit CsvReader(size_t bufferBytes = 64 * 1024);
+        int open(const std::string& filenameWithExtension); // Under the data dir, after its pending writes; 0 on success
+        int openPath(const fs::path& filePath);             // Exactly 'filePath'; 0 on success
+        void close();
+        bool next(); // False at the end of the file or on error
+
+        int x() const { return static_cast<int>(fields_.size()); }
+        char* const* fields() const { return fields_.data(); }
+        const char* field(int col) const { return fields_[col]; }
+        int columnOf(const char* fieldName) const; // -1 if absent
+        const char* cell(int col) const;          // "" past the end of a short row
+        long long rowNumber() const { return rowNumber_; } // 1-based data row, 0 before the first
+
+    private:
+        bool nextLine(const char*& line, size_t& length); // Raw text of the next row, '\r' kept
+        bool readRowAt(size_t offset, std::vector<char>& text); // Raw text of the row starting at 'offset'
+        void splitLine(const char* line, size_t length, int expectedFields, bool padShortRow,
+                       std::vector<char>& text, std::vector<char*>& cells);
+
+        fs::path path_;
+        std::ifstream file_;
+        std::ifstream movedFile_; // Opened at the first row pointer
+        std::unordered_set<size_t> movedRows_; // Returned at their pointer; skipped when reached
+        std::vector<char> movedText_;
+        std::vector<char> buffer_;
+        size_t bufferStart_; // File offset of buffer_[0]
+        size_t begin_; // Unconsumed bytes are buffer_[begin_, end_)
+        size_t end_;
+        bool eof_;
+        long long rowNumber_;
+        std::vector<size_t> structural_;
+        std::vector<CellView> views_;
+        std::vector<char> headerText_;
+        std::vector<char*> fields_;
+        std::vector<char> rowText_;
+        std::vector<char*> cells_;
+        CsvReader(const CsvReader&) = delete;
+        CsvReader& operator=(const CsvReader&) = delete;
+    };
+
+    // Buffered CSV output. Rows are formatted into one reusable buffer that goes
+    // to the file in a single write() when it fills and on flush(), so a batch of
+    // appended rows costs one system call. Fields are quoted only when they hold
+    // a ',', '"', '\r' or '\n' (quotes doubled, RFC 4180), or when a row's first
+    // field starts with '#', which would make it a comment line; readers keep a
+    // line break inside quotes as part of the value. Rows end in "\n" unless
+    // setCrlf asks for "\r\n".
+    struct CsvWriter {
+        int error;
+
+        explicit CsvWriter(size_t bufferBytes = 256 * 1024);
+        ~CsvWriter(); // Flushes and closes
+        int open(const fs::path& filePath, bool append); // 0 on success
+        int openData(const std::string& filenameWithExtension, bool append); // A file in the data directory, as open()
+        void writeRow(int numValues, const char* const* values);
+        void setCrlf(bool crlf) { lineBreak_ = crlf ? "\r\n" : "\n"; }
+        int flush(); // 0 on success
+        int close(); // 0 when every row reached the file
+        size_t offset() const { return written_ + buffer_.size(); } // Bytes written since open(), buffered ones included
+
+        static void appendRow(std::string& out, int numValues, const char* const* values); // Row text without the line break
+        static void appendField(std::string& out, const char* value, bool firstField = false);
+
+    private:
+        void start();
+
+#ifndef _WIN32
+        int fd_;
+#else
+        std::ofstream file_;
+#endif
+        std::string buffer_;
+        size_t bufferBytes_;
+        size_t written_;
+        const char* lineBreak_;
+        CsvWriter(const CsvWriter&) = delete;
+        CsvWriter& operator=(const CsvWriter&) = delete;
+    };
+
+    // Running totals of one column's numeric cells (cells that are not numbers
+    // are skipped), as produced by aggregateCsvStream.
+    struct ColumnAggregate {
+        long long count;
+        double sum;
+        double min;
+        double max;
+
+        ColumnAggregate() : count(0), sum(0), min(0), max(0) {}
+        void add(double value);
+    };
+
+    // Open-addressing (linear probing) index from one column's value to row ids.
+    // Duplicate keys are allowed; lookups return every matching row.
+    struct KeyIndex {
+        struct Slot {
+            uint32_t hash;
+            int row; // -1 marks an empty slot
+        };
+
+        int column;
+        size_t count;
+        std::vector<Slot> slots;
+
+        KeyIndex() : column(-1), count(0) {}
+        void build(const dataContainer2D& table, int keyColumn);
+        void insert(const dataContainer2D& table, int row);
+        void erase(int row, const char* key);
+        void find(const dataContainer2D& table, const char* key, std::vector<int>& rows) const;
+        int findFirst(const dataContainer2D& table, const char* key) const;
+
+    private:
+        void placeSlot(const Slot& slot);
+    };
+
+    // Value -> row-id list over one column, or over a pair of columns (composite).
+    // Open addressing on distinct values; each bucket keeps its rows ascending.
+    struct SecondaryIndex {
+        struct Bucket {
+            bool used;
+            uint32_t hash;
+            std::string key;
+            std::vector<int> rows;
+            Bucket() : used(false), hash(0) {}
+        };
+
+        std::vector<int> columns;
+        size_t distinct;
+        std::vector<Bucket> buckets;
+
+        SecondaryIndex() : distinct(0) {}
+        void build(const dataContainer2D& table, const std::vector<int>& indexColumns);
+        void add(const dataContainer2D& table, int row);
+        void remove(int row, const std::string& key);
+        const std::vector<int>* find(const char* value1, const char* value2 = nullptr) const;
+        std::string keyOfRow(const dataContainer2D& table, int row) const;
+
+    private:
+        std::string keyOf(const char* value1, const char* value2) const;
+        static uint32_t hashKey(const std::string& key);
+        Bucket& bucketFor(const std::string& key);
+    };
+
+    // A parsed CSV kept resident by TableCache, stamped with the file's mtime/size
+    // at load (or at our own last write) so external edits are noticed.
+    struct CachedTable {
+        std::string filename;
+        dataContainer2D table;
+        fs::file_time_type modifiedAt;
+        uintmax_t fileSize;
+        int rowCapacity; // Slots in table.data; grows when appended rows are patched in
+        std::vector<KeyIndex> keyIndexes;
+        std::vector<SecondaryIndex> secondaryIndexes; // Only those declared through declareSecondaryIndex
+        std::vector<RowExtent> extents; // Parallel to table rows; empty when the layout is unknown
+        size_t deadBytes; // Filler lines and row pointers left in the file by in-place patches and deletes
+        bool crlf; // CsvLayout::crlf
+        bool stale; // The watcher saw another writer change the file; reloaded on next use
+
+        CachedTable() : fileSize(0), rowCapacity(0), deadBytes(0), crlf(false), stale(false) {}
+        ~CachedTable();
+
+        KeyIndex* keyIndexFor(int column); // Built on first use for that column
+        void rebuildIndexes();
+        const SecondaryIndex* secondaryIndexFor(int column1, int column2 = -1, bool* swapped = nullptr) const;
+        void addSecondaryIndex(const std::string& field1, const std::string& field2);
+        void matchingRows(int column, const char* key, std::vector<int>& rows) const;
+        void setCell(int row, int col, const char* value);
+        void appendRow(const char* const* values);
+        void removeRows(const std::vector<int>& rows, std::vector<RowExtent>& removedExtents);
+        bool extentsKnown() const { return extents.size() == static_cast<size_t>(table.y); }
+        std::shared_ptr<CachedTable> clone() const; // Private copy with the same stamps and indexes
+        CachedTable(const CachedTable&) = delete;
+        CachedTable& operator=(const CachedTable&) = delete;
+    };
+
+    // Process-wide cache of parsed tables keyed by filename. The query and
+    // update/delete functions go through it instead of calling getData each time.
+    class TableCache {
+    public:
+        static TableCache& instance();
+
+        // Loaded or revalidated table; nullptr if the file cannot be read.
+        std::shared_ptr<CachedTable> acquire(const std::string& filenameWithExtension);
+        // As acquire, for callers about to mutate the table in place. If TableViews
+        // still reference the cached table, the entry is replaced by a private copy
+        // first so those views keep seeing the rows they were built over.
+        std::shared_ptr<CachedTable> acquireForWrite(const std::string& filenameWithExtension);
+        // Called after the toolkit rewrites or appends to a file. When 'written' is the
+        // cached container and every cell round-trips through the parser, the entry is
+        // re-stamped and kept; otherwise it is dropped and reloaded on next use.
+        void noteWrite(const std::string& filenameWithExtension, const dataContainer2D* written, bool roundTrips,
+                       const std::vector<RowExtent>* extents = nullptr);
+        // Appends are patched into a cached table only if it was current and the file
+        // ended in a newline before the write; beginAppend reports that.
+        bool beginAppend(const std::string& filenameWithExtension);
+        void noteAppend(const std::string& filenameWithExtension, bool patchable, int numValues, const char* const* values);
+        // The cached entry if it still matches the file on disk; never loads.
+        std::shared_ptr<CachedTable> current(const std::string& filenameWithExtension);
+        // Re-reads the stamps of a cached entry after its queued writes reach the file.
+        void restamp(const std::string& filenameWithExtension);
+        // Makes 'entry' the cached table for the file, e.g. a committed transaction copy.
+        void install(const std::string& filenameWithExtension, const std::shared_ptr<CachedTable>& entry);
+        void invalidate(const std::string& filenameWithExtension);
+        void clear();
+        // Called by TableWatcher: the next use of the table checks the file's stamps again.
+        void markStale(const std::string& filenameWithExtension);
+        void markAllStale();
+
+        // Secondary indexes to build for a file whenever it is (re)loaded. field2 is
+        // empty for a single-column index.
+        void declareIndex(const std::string& filenameWithExtension, const std::string& field1, const std::string& field2);
+        // The cached entry owning 'table', if it is a cached table.
+        std::shared_ptr<CachedTable> findByTable(const dataContainer2D* table) const;
+
+    private:
+        TableCache() {}
+        std::unordered_map<std::string, std::shared_ptr<CachedTable>> tables_;
+        std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> declaredIndexes_;
+    };
+
+    // Watches the data directory for files changed behind the toolkit's back (a
+    // second console on the same data, an editor, a restored backup). On Linux an
+    // inotify watch on the directory marks the cached table of every file named
+    // in an event stale, and TableCache reloads a stale table on its next use
+    // instead of comparing stamps, which a same-size edit within one mtime tick
+    // would get past. The toolkit's own writes are bracketed by beginOwnWrite /
+    // endOwnWrite: their events still count as changes of the file, but leave its
+    // cached table, which the write keeps up to date, as it is. Elsewhere, or if
+    // the watch cannot be set up, nothing is marked and every use stats the file.
+    class TableWatcher {
+    public:
+        static TableWatcher& instance();
+        ~TableWatcher();
+
+        bool watching() const { return watch_ >= 0; }
+        // Drains the pending events without blocking.
+        void poll();
+        // Number of changes seen for the file; every file's moves on when events
+        // were lost or the watch was restarted.
+        uint64_t generation(const std::string& filenameWithExtension) const;
+        // Watches another directory (DataStore::setRoot, or once it is created).
+        void watch(const fs::path& dataDir);
+        // Around a write by this process. Events queued before beginOwnWrite are
+        // someone else's; those queued by the time endOwnWrite drains them are
+        // the write's own, since inotify queues them before the call returns.
+        void beginOwnWrite(const std::string& filenameWithExtension);
+        void endOwnWrite(const std::string& filenameWithExtension);
+
+    private:
+        TableWatcher();
+        void stop();
+        void markChanged(const std::string& filenameWithExtension);
+
+        int fd_;
+        int watch_;
+        uint64_t epoch_; // Bumped when per-file counts can no longer be trusted
+        std::unordered_map<std::string, uint64_t> changes_;
+        std::unordered_map<std::string, int> ownWrites_; // Writes in progress per file
+        TableWatcher(const TableWatcher&) = delete;
+        TableWatcher& operator=(const TableWatcher&) = delete;
+    };
+
+    // What a consumer last saw of a data file; see fileChangedSince.
+    struct FileVersion {
+        bool known;
+        uint64_t generation;
+        fs::file_time_type modifiedAt;
+        uintmax_t fileSize;
+        uint64_t logged; // Write-ahead log groups for the file, which change it before they reach it
+
+        FileVersion() : known(false), generation(0), fileSize(0), logged(0) {}
+    };
+
+    // Redo log for the byte-level changes the toolkit makes to CSV files. Updates,
+    // deletes and appends on cached tables queue the bytes they produce, and the
+    // write function commits them as one group before it returns; a Transaction
+    // holds commits so all of its files form a single group. A commit appends the
+    // group to the data directory's log and fsyncs it once; that is what makes
+    // the write durable. Logged groups reach the CSV files in batches (see
+    // apply()): until then the cached tables show them, getData serves those
+    // files from the cache, and anything that reads a file from disk applies the
+    // log first. Each group records the size and mtime each of its files had, and
+    // is not applied to a file that no longer has them. The log is shared by every
+    // process using the directory and guarded by a file lock (flock) that each
+    // write holds from reading the table to logging its change; whoever takes the
+    // lock first applies what another process logged. Other processes therefore
+    // see a write once it is applied. A log left behind by a crash is replayed on
+    // first use; every record is a positional write, so replaying a partly
+    // applied group is harmless.
+    class WriteAheadLog {
+    public:
+        static WriteAheadLog& instance();
+        ~WriteAheadLog();
+
+        // Holds the log's file lock for a scope (reentrant). Taking it applies any
+        // groups another process logged since this one last held it.
+        class Lock {
+        public:
+            Lock() { WriteAheadLog::instance().lock(); }
+            ~Lock() { WriteAheadLog::instance().unlock(); }
+            Lock(const Lock&) = delete;
+            Lock& operator=(const Lock&) = delete;
+        };
+
+        // Queues 'bytes' to be written at 'offset' in the file. The stamps are the
+        // file's on-disk state, recorded with the first queued write for it.
+        void record(const std::string& filenameWithExtension, const fs::file_time_type& diskModifiedAt, uintmax_t diskSize,
+                    size_t offset, const std::string& bytes);
+        // Queues the rename of 'tempName', already written and fsynced in the data
+        // directory, over the file; 'tempSize' is its size.
+        void recordReplace(const std::string& filenameWithExtension, const std::string& tempName, uintmax_t tempSize);
+        // Whether the file has queued or logged writes that are not in it yet.
+        bool hasPending(const std::string& filenameWithExtension) const;
+        // Whether the file has logged writes that are not in it yet.
+        bool hasLogged(const std::string& filenameWithExtension) const { return loggedFiles_.count(filenameWithExtension) != 0; }
+        // Groups this process has logged for the file so far; grows with every write.
+        uint64_t loggedGroups(const std::string& filenameWithExtension) const;
+        // Drops a file's queued writes; used when the whole file is about to be replaced.
+        void discard(const std::string& filenameWithExtension);
+        // Size the file will have once its queued and logged writes are applied.
+        uintmax_t logicalSize(const std::string& filenameWithExtension, uintmax_t diskSize) const;
+        // Commits the queued writes unless commits are held; 0, or 1 if the group
+        // could not be logged (it is dropped and its files' cache entries reload).
+        int commitUnlessHeld();
+        int commit();
+        // Applies every logged group to the CSV files, fsyncs them and empties the
+        // log. commit() does this once 64 groups or 1 MiB are logged, or the
+        // oldest group is 2 seconds old; Transaction::commit, readers of the files
+        // and exit do it too. 0, or 1 if a file's writes could not be applied (its
+        // cache entry reloads from the file as it is).
+        int apply();
+        // While held, commitUnlessHeld() leaves writes queued so they commit as one group.
+        void holdCommits(bool hold) { held_ = hold; }
+        bool held() const { return held_; }
+        void lock();
+        void unlock();
+        // Switches to the log of the data directory DataStore now points at and
+        // replays it; the old directory's log should be applied first.
+        void reopen();
+
+    private:
+        struct Write {
+            std::string filename;
+            size_t offset;
+            std::string bytes; // For a rename, the temp file that replaces the file
+            bool rename;
+        };
+        struct PendingFile {
+            fs::file_time_type baseModifiedAt;
+            uintmax_t baseSize;
+            uintmax_t logicalSize;
+        };
+        struct Stamp {
+            std::string filename;
+            uintmax_t size;
+            long long modifiedAt;
+        };
+        struct Group {
+            size_t start; // Offset of its first record in the log
+            std::vector<Stamp> stamps;
+            std::vector<Write> writes;
+        };
+
+        WriteAheadLog();
+        bool open();
+        void close();
+        void lockFile();
+        bool readState(uint64_t& generation, uint64_t& size);
+        bool readLog(std::string& contents);
+        bool appendLog(const std::string& bytes, size_t& start);
+        bool resetLog(uint64_t generation);
+        void sync();
+        int applyLocked(bool touchCache);
+        void keepQueuedOnly();
+
+        fs::path path_;
+        int fd_; // Open log on POSIX, holding the flock; -1 elsewhere or when it cannot be opened
+        long openedBy_; // Process that opened fd_; a forked child needs its own lock
+        int lockDepth_;
+        uint64_t generation_;   // Bumped by every apply, so other processes notice it
+        uint64_t knownSize_;    // Log size after this process last wrote or read it
+        std::vector<Write> buffered_;
+        std::unordered_map<std::string, PendingFile> pending_;
+        std::unordered_set<std::string> loggedFiles_;
+        std::unordered_set<size_t> ownGroups_; // Start offsets of the groups this process logged
+        std::unordered_map<std::string, uint64_t> loggedGroups_;
+        size_t groupsSinceApply_;
+        std::chrono::steady_clock::time_point firstLoggedAt_;
+        bool committing_;
+        bool applying_;
+        bool replaying_;
+        bool held_;
+    };
+
+    // Changes to one or more tables that are written together. Each staging call
+    // applies to a private copy of the table, taken on the first change to that
+    // file, and returns the same codes as the direct functions; the cache and the
+    // files are untouched until commit(). commit() writes the changed rows of every
+    // file as a single write-ahead log group, so after a crash all of them are
+    // replayed or none are. A file that needs a full rewrite is written to a temp
+    // file first, and the group renames it into place. If a staged table was
+    // changed by other writes in the meantime, commit() writes nothing and fails.
+    class Transaction {
+    public:
+        Transaction() {}
+        ~Transaction() { rollback(); }
+
+        // 0, or 1 (unreadable/empty), 2 (unknown field), 3 (key not found), as updateFieldsByKey.
+        int updateFieldsByKey(const std::string& filename, const char* key, int numFields, const char* fieldNames[], const char* newValues[]);
+        // 0, or 1 (unreadable), 2 (column count mismatch).
+        int appendRow(const std::string& filenameWithExtension, int numValues, const char* const* values);
+        // 0, or 1 (unreadable/bad column), 2 (key not found); removes every matching row.
+        int deleteByKey(const std::string& filenameWithExtension, const char* key, int keyColumnIndex);
+        // 0 when every file was written; 1 on a conflict (nothing written) or a failed write.
+        int commit();
+        void rollback();
+        bool empty() const { return tables_.empty(); }
+
+    private:
+        struct StagedTable {
+            std::string filename;
+            std::shared_ptr<CachedTable> base; // Cache entry the copy was taken from
+            fs::file_time_type baseModifiedAt;
+            uintmax_t baseSize;
+            std::shared_ptr<CachedTable> working;
+            std::vector<char**> changedRows; // By row pointer, which survives deletes
+            std::vector<RowExtent> removedExtents;
+        };
+        StagedTable* stage(const std::string& filenameWithExtension);
+
+        std::vector<StagedTable> tables_;
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+    };
+
+    // Non-owning result of the filter/search/sort functions: row and column ids
+    // into a source table rather than copies of its cells. A view over a cached
+    // table holds a reference to it, so it stays valid while the view is alive;
+    // a view over a caller's container is only valid while that container is.
+    // materialize() produces an owning dataContainer2D when one is really needed.
+    struct TableView {
+        int error;
+        std::shared_ptr<CachedTable> keepAlive;
+        const dataContainer2D* source;
+        std::vector<int> rows;    // Source row ids, in view order
+        std::vector<int> columns; // Source column ids, in view order
+        bool wholeTable;          // rows/columns are exactly the source's, in order
+
+        TableView() : error(0), source(nullptr), wholeTable(false) {}
+        int x() const { return static_cast<int>(columns.size()); }
+        int y() const { return static_cast<int>(rows.size()); }
+        const char* field(int col) const;
+        const char* cell(int row, int col) const; // "" for missing rows/cells
+        dataContainer2D materialize() const;
+    };
+
+    enum JoinType {
+        JOIN_INNER, // One result row per matching (left, right) pair
+        JOIN_LEFT,  // As JOIN_INNER, plus left rows without a match (right cells read "-")
+        JOIN_ANTI   // Only left rows without a match; no right columns
+    };
+
+    // Non-owning result of joinDataContainerView: pairs of source row ids into a
+    // left and a right table. Columns are the left view's, then the right view's
+    // minus its key columns. Rows follow the left view's order, and a left row's
+    // matches follow the right view's. rightRows[i] is -1 for an unmatched row.
+    struct JoinView {
+        int error;
+        TableView left;  // Source and columns only; rows are in leftRows
+        TableView right; // Source and non-key columns only; rows are in rightRows
+        std::vector<int> leftRows;
+        std::vector<int> rightRows;
+
+        JoinView() : error(0) {}
+        int x() const { return left.x() + right.x(); }
+        int y() const { return static_cast<int>(leftRows.size()); }
+        const char* field(int col) const;
+        const char* cell(int row, int col) const; // "" for missing cells, "-" for an unmatched right side
+        dataContainer2D materialize() const;
+    };
+
+    // Value type of a column for sorting; COLUMN_AUTO infers it from the cells.
+    enum ColumnType {
+        COLUMN_AUTO,
+        COLUMN_STRING,
+        COLUMN_INT,
+        COLUMN_FLOAT,
+        COLUMN_DATE, // YYYY-MM-DD
+        COLUMN_TIME  // H:MM or H:MM:SS
+    };
+
+    // One ordering key for sortDataContainer; earlier keys take precedence.
+    struct SortKey {
+        const char* field;
+        bool ascending;
+        ColumnType type;
+
+        SortKey(const char* fieldName = nullptr, bool sortAscending = true, ColumnType columnType = COLUMN_AUTO)
+            : field(fieldName), ascending(sortAscending), type(columnType) {}
+    };
+
+    // A column a program expects in a CSV: its header name and value type.
+    struct SchemaColumn {
+        const char* name;
+        ColumnType type;
+    };
+
+    // The header one CSV is expected to have. A schema registers itself under its
+    // filename, and getData checks every load of that file against it, reporting
+    // missing columns once. Rows are then read through Column handles, which
+    // resolve a name to its header position once per table rather than per call.
+    class TableSchema {
+    public:
+        TableSchema(const char* filenameWithExtension, const SchemaColumn* schemaColumns, int columnCount);
+        static TableSchema* find(const std::string& filenameWithExtension);
+
+        const char* filename() const { return file; }
+        int columnCount() const { return count; }
+        const SchemaColumn& column(int slot) const { return columns[slot]; }
+
+        // Resolves every column against a header; false if any is missing from it.
+        bool bind(char* const* headerFields, int headerCount, bool reportMissing = false);
+        // Header position of column 'slot', -1 if the header lacks it. Only a
+        // different header than the last one costs a lookup.
+        int position(int slot, char* const* headerFields, int headerCount) {
+            if (!isBoundTo(headerFields, headerCount)) bind(headerFields, headerCount);
+            return positions[slot];
+        }
+        bool covers(const dataContainer2D& data) {
+            if (!isBoundTo(data.fields, data.x)) bind(data.fields, data.x);
+            return complete;
+        }
+
+    private:
+        // Same header array with the same names as the last bind. The names are
+        // compared too because a freed header's arena block can be reused at the
+        // same address for a different header.
+        bool isBoundTo(char* const* headerFields, int headerCount) const;
+        static uint32_t headerHash(char* const* headerFields, int headerCount);
+
+        const char* file;
+        const SchemaColumn* columns;
+        int count;
+        std::vector<int> positions; // Per schema column, for the bound header
+        char* const* boundFields;
+        int boundCount;
+        uint32_t boundHash; // headerHash of the bound header's names
+        bool complete;
+        bool reported; // Missing columns have been reported since the last complete load
+    };
+
+    // Compile-time handle to column 'Slot' of 'Table', a type with a constexpr
+    // 'columns' array of SchemaColumn and a static 'schema' built from it.
+    template <typename Table, int Slot>
+    struct Column {
+        static constexpr const char* name = Table::columns[Slot].name;
+        static constexpr ColumnType type = Table::columns[Slot].type;
+
+        int in(const dataContainer2D& data) const { return Table::schema.position(Slot, data.fields, data.x); }
+        int in(const dataContainer1D& row) const { return Table::schema.position(Slot, row.fields, row.fields_count); }
+        int in(const CsvReader& reader) const { return Table::schema.position(Slot, reader.fields(), reader.x()); }
+    };
+
+    // One schema column's values packed into an array: int32 for COLUMN_INT,
+    // COLUMN_DATE (YYYYMMDD) and COLUMN_TIME (seconds since midnight), float for
+    // COLUMN_FLOAT, and interned cells for COLUMN_STRING, so equal strings share
+    // a pointer. 'present' is 0 where the cell is empty or does not parse, and
+    // the value there is 0 ("" for strings).
+    struct TypedColumn {
+        ColumnType type;
+        std::vector<int32_t> ints;
+        std::vector<float> floats;
+        std::vector<const char*> strings;
+        std::vector<char> present;
+
+        TypedColumn() : type(COLUMN_STRING) {}
+    };
+
+    // A table's columns in schema order, parsed once by getData(file, typed).
+    struct TypedColumns {
+        const TableSchema* schema; // Null when the file has no registered schema
+        int rows;
+        std::vector<TypedColumn> columns;
+
+        TypedColumns() : schema(nullptr), rows(0) {}
     };
 
     // --- Forward Declarations ---
@@ -45,12 +972,61 @@ namespace CsvToolkit {
     // Memory Management
     void deleteDataContainer2D(dataContainer2D& container);
     void deleteDataContainer1D(dataContainer1D& container);
+    void setCellValue(dataContainer2D& container, int row, int col, const char* value);
+    void setCellValue(dataContainer1D& container, int index, const char* value);
+    void releaseRow(dataContainer2D& container, int row);
 
     // CSV Parsing
     char** parseCsvRow(const std::string& line, char delimiter, int expectedFields, int& actualTokenCount);
+    char** parseCsvRowScalar(const std::string& line, char delimiter, int expectedFields, int& actualTokenCount);
     dataContainer2D getData(const std::string& filenameWithExtension);
+    dataContainer2D getData(const std::string& filenameWithExtension, CsvLayout* layout);
+    dataContainer2D getData(const std::string& filenameWithExtension, CsvLayout* layout, std::vector<std::vector<int32_t>>* snapshotInts);
+    dataContainer2D getData(const std::string& filenameWithExtension, TypedColumns& typed);
+    dataContainer2D getData(const std::string& filenameWithExtension, const char* const wantedFields[], int numWantedFields,
+                            const RowFilter& filter = RowFilter());
+    int resolveDataFilePath(const std::string& filenameWithExtension, fs::path& filePath);
+    CsvScanKernel bestCsvScanKernel();
+    void indexCsvStructure(const char* data, size_t size, char delimiter, std::vector<size_t>& positions);
+    void indexCsvStructure(const char* data, size_t size, char delimiter, std::vector<size_t>& positions, CsvScanKernel kernel);
+    bool isQuotedField(const char* text, size_t length);
+    size_t unquoteCell(const char* text, size_t length, char* out);
+    size_t unquotedLength(const char* text, size_t length);
+    int tokenizeIndexedLine(const char* base, size_t lineStart, size_t lineLength, const size_t* structural, size_t structuralCount,
+                            char delimiter, int expectedFields, CellView* views);
+    char* materializeCell(const char* base, const CellView& view, CellArena& arena);
+    int loadCsvViews(const std::string& filenameWithExtension, CsvViewTable& table);
+    int loadCsvViews(const std::string& filenameWithExtension, CsvViewTable& table, int threads);
+    int csvParseThreads(size_t bytes);
+    template <typename Work>
+    void runOnThreadPool(size_t tasks, int threads, Work work);
+    void parseCsvChunk(const char* data, int fieldCount, CsvChunk& chunk);
+    bool parseRowPointer(const char* text, size_t length, size_t& target);
+    std::string rowPointerText(size_t target);
+    std::string fillerLine(size_t bytes, bool crlf);
+    void orderMovedRows(CsvLayout& layout, const std::vector<std::pair<size_t, size_t>>& pointers, size_t fileSize,
+                        std::vector<CellView>& cells, size_t fieldCount);
+    size_t findCsvRowBreak(const char* data, size_t rowStart, size_t from, size_t end, bool* unclosed = nullptr);
+    uint32_t hashBytes(const char* bytes, size_t length, uint32_t hash = 2166136261u);
+    bool statDataFile(const std::string& filenameWithExtension, fs::file_time_type& modifiedAt, uintmax_t& fileSize);
+    bool readSnapshot(const std::string& filenameWithExtension, const fs::file_time_type& modifiedAt, uintmax_t fileSize,
+                      dataContainer2D& container, CsvLayout* layout, std::vector<std::vector<int32_t>>* intColumns);
+    void writeSnapshot(const std::string& filenameWithExtension, const fs::file_time_type& modifiedAt, uintmax_t fileSize,
+                       const dataContainer2D& container, const CsvLayout& layout);
+    void checkTableSchema(const std::string& filenameWithExtension, const dataContainer2D& container);
+    bool parseInt32Cell(const char* text, int32_t& value);
+    void buildTypedColumns(const dataContainer2D& data, TableSchema& schema, TypedColumns& typed,
+                           std::vector<std::vector<int32_t>>* snapshotInts = nullptr);
+
+    // Streaming
+    template <typename OnRow>
+    int filterCsvStream(const std::string& filenameWithExtension, const char* field, const char* key, OnRow onRow);
+    int aggregateCsvStream(const std::string& filenameWithExtension, const char* groupField, const char* valueField,
+                           std::unordered_map<std::string, ColumnAggregate>& groups);
 
     // Utilities
+    char* duplicateString(const char* cstr);
+    const char* internString(const char* cstr);
     void clearTerminal();
     char* getString(const char* prompt);
     int getInt(const char* prompt);
@@ -61,32 +1037,131 @@ namespace CsvToolkit {
     dataContainer1D getFieldValues(const dataContainer2D& data, const char* field);
     dataContainer2D shortenDataContainer(const dataContainer2D& data, const char* wantedFields[], int numFields);
 
+    // Table Views
+    TableView wholeTableView(const dataContainer2D& data);
+    TableView viewOf(const dataContainer2D& data);
+    TableView tableView(const std::string& filenameWithExtension);
+    TableView filterDataContainerView(const TableView& view, const char* field, const char* key);
+    TableView filterDataContainerView(const dataContainer2D& data, const char* field, const char* key);
+    TableView shortenDataContainerView(const TableView& view, const char* wantedFields[], int numFields);
+    TableView shortenDataContainerView(const dataContainer2D& data, const char* wantedFields[], int numFields);
+    TableView Search1FieldValueView(const std::string& filenameWithExtension, const char* fieldName, const char* dataToMatch);
+    TableView Search2FieldValueView(const std::string& file, const char* field1, const char* key1, const char* field2, const char* key2);
+    TableView sortDataContainerView(const TableView& view, const SortKey keys[], int numKeys);
+    TableView sortDataContainerView(const dataContainer2D& data, const SortKey keys[], int numKeys);
+    dataContainer2D sortDataContainer(const dataContainer2D& data, const SortKey keys[], int numKeys);
+    bool parseTypedValue(const char* text, ColumnType type, double& value);
+    ColumnType inferColumnType(const TableView& view, int col);
+    TableView SortByFieldNameView(const TableView& view, const char* fieldName, bool ascending);
+    TableView SortByFieldNameView(const dataContainer2D& data, const char* fieldName, bool ascending);
+    TableView sortByTwoFieldsView(const TableView& view, const char* primaryField, const char* secondaryField, bool ascending);
+    TableView sortByTwoFieldsView(const dataContainer2D& data, const char* primaryField, const char* secondaryField, bool ascending);
+
+    // Joins
+    JoinView joinDataContainerView(const TableView& left, const TableView& right, const char* leftKeys[], const char* rightKeys[], int numKeys, JoinType type);
+    JoinView joinDataContainerView(const dataContainer2D& left, const dataContainer2D& right, const char* leftKeys[], const char* rightKeys[], int numKeys, JoinType type);
+    JoinView joinDataContainerView(const dataContainer2D& left, const dataContainer2D& right, const char* leftKey, const char* rightKey, JoinType type = JOIN_INNER);
+
     // Display Functions
     void displaySystemMessage(const char* message, int waitTimeInSeconds);
     void displayUnorderedOptions(const char* header, const char* options[], int noOptions);
     void displayOptions(const char* header, const char* options[], int noOptions, bool freeModified = true);
     int displayMenu(const char* header, const char* options[], int noOptions);
     void displayTabulatedData(const dataContainer2D& data);
+    void displayTabulatedData(const TableView& view);
+    void displayTabulatedData(const JoinView& view);
 
     // Data Read Functions (Query Functions)
     dataContainer1D queryKey(const std::string& filenameWithExtension, const char* key);
     dataContainer1D queryField(const std::string& filenameWithExtension, const char* field);
     dataContainer2D queryFieldStrict(const std::string& filenameWithExtension, const char* field, const char* key);
+    void declareSecondaryIndex(const std::string& filenameWithExtension, const char* fieldName);
+    void declareCompositeIndex(const std::string& filenameWithExtension, const char* field1, const char* field2);
 
     // Data Write Functions
+    bool resolveWritePath(const std::string& filenameWithExtension, fs::path& filePath);
     bool openCsvFileForWrite(const std::string& filenameWithExtension, std::ofstream& outFileStream, std::ios_base::openmode mode);
+    bool openCsvFileForAppend(const std::string& filenameWithExtension, CsvWriter& writer);
+    bool syncPath(const fs::path& path);
     int writeData(const std::string& filenameWithExtension, const dataContainer2D& containerToWrite);
     int writeNewDataRow(const std::string& filenameWithExtension, int numInputs, const char* inputs[]);
     int updateDataByUniqueKey(const std::string& filenameWithExtension, const char* uniqueKeyToUpdate, int uniqueKeyColumnIndex, int numColsInNewData, const char* newDataRow[]);
     int updateDataBySecondKey(const std::string& filenameWithExtension, const char* primaryKey, int primaryKeyIndex, const char* secondaryKey, int secondaryKeyIndex, int numColsInNewData, const char* newDataRow[]);
     int deleteByKey(const std::string& filenameWithExtension, const char* uniqueKeyToDelete, int uniqueKeyColumnIndex);
     int deleteBySecondKey(const std::string& filenameWithExtension, const char* primaryKey, int primaryKeyIndex, const char* secondaryKey, int secondaryKeyIndex);
+    int updateFieldsByKey(const std::string& filename, const char* key, int numFields, const char* fieldNames[], const char* newValues[]);
+    int flushWriteAheadLog();
+    void flushPendingWrites(const std::string& filenameWithExtension);
+
+    // Change Tracking
+    bool fileChangedSince(const std::string& filenameWithExtension, FileVersion& seen);
 
 
 // --- Implementations ---
 
 // --- Memory Management ---
+dataContainer2D::~dataContainer2D() {
+    deleteDataContainer2D(*this);
+}
+
+dataContainer2D::dataContainer2D(dataContainer2D&& other) noexcept
+    : error(other.error), fields(other.fields), data(other.data), y(other.y), x(other.x), arena(other.arena) {
+    other.fields = nullptr;
+    other.data = nullptr;
+    other.arena = nullptr;
+    other.y = 0;
+    other.x = 0;
+    other.error = 0;
+}
+
+dataContainer2D& dataContainer2D::operator=(dataContainer2D&& other) noexcept {
+    if (this == &other) return *this;
+    deleteDataContainer2D(*this);
+    std::swap(error, other.error);
+    std::swap(fields, other.fields);
+    std::swap(data, other.data);
+    std::swap(y, other.y);
+    std::swap(x, other.x);
+    std::swap(arena, other.arena);
+    return *this;
+}
+
+dataContainer1D::~dataContainer1D() {
+    deleteDataContainer1D(*this);
+}
+
+dataContainer1D::dataContainer1D(dataContainer1D&& other) noexcept
+    : error(other.error), fields(other.fields), fields_count(other.fields_count), data(other.data), x(other.x) {
+    other.fields = nullptr;
+    other.data = nullptr;
+    other.fields_count = 0;
+    other.x = 0;
+    other.error = 0;
+}
+
+dataContainer1D& dataContainer1D::operator=(dataContainer1D&& other) noexcept {
+    if (this == &other) return *this;
+    deleteDataContainer1D(*this);
+    std::swap(error, other.error);
+    std::swap(fields, other.fields);
+    std::swap(fields_count, other.fields_count);
+    std::swap(data, other.data);
+    std::swap(x, other.x);
+    return *this;
+}
+
 void deleteDataContainer2D(dataContainer2D& container) {
+    if (container.arena) { // Everything was carved from the arena, so one release frees it all
+        delete container.arena;
+        container.arena = nullptr;
+        container.fields = nullptr;
+        container.data = nullptr;
+        container.y = 0;
+        container.x = 0;
+        container.error = 0;
+        return;
+    }
+
     if (container.fields) {
         for (int i = 0; i < container.x; ++i) {
             delete[] container.fields[i];
@@ -112,6 +1187,35 @@ void deleteDataContainer2D(dataContainer2D& container) {
     container.error = 0;
 }
 
+// Replaces one cell, honouring the container's ownership mode. Arena cells are
+// never freed one by one; the old bytes go when the arena is released.
+void setCellValue(dataContainer2D& container, int row, int col, const char* value) {
+    if (!container.data || row < 0 || row >= container.y || col < 0 || col >= container.x || !container.data[row]) return;
+    if (container.arena) {
+        container.data[row][col] = container.arena->copyString(value);
+    } else {
+        delete[] container.data[row][col];
+        container.data[row][col] = duplicateString(value);
+    }
+}
+
+// Replaces one value, freeing the old one.
+void setCellValue(dataContainer1D& container, int index, const char* value) {
+    if (!container.data || index < 0 || index >= container.x) return;
+    delete[] container.data[index];
+    container.data[index] = duplicateString(value);
+}
+
+// Frees a row's cells (heap mode only) and nulls the row slot.
+void releaseRow(dataContainer2D& container, int row) {
+    if (!container.data || row < 0 || row >= container.y || !container.data[row]) return;
+    if (!container.arena) {
+        for (int j = 0; j < container.x; ++j) delete[] container.data[row][j];
+        delete[] container.data[row];
+    }
+    container.data[row] = nullptr;
+}
+
 void deleteDataContainer1D(dataContainer1D& container) {
     if (container.fields) {
         for (int i = 0; i < container.fields_count; ++i) {
@@ -134,7 +1238,222 @@ void deleteDataContainer1D(dataContainer1D& container) {
 }
 
 // --- CSV Parsing ---
+
+// Index of the lowest set bit; callers guarantee mask != 0.
+unsigned lowestSetBit(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// The best kernel this build and CPU support; checked once.
+CsvScanKernel bestCsvScanKernel() {
+#if defined(__AVX2__)
+    return CSV_SCAN_AVX2;
+#elif defined(CSV_TOOLKIT_AVX2)
+    static const CsvScanKernel best = []() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? CSV_SCAN_AVX2 : CSV_SCAN_SSE2;
+    }();
+    return best;
+#elif defined(CSV_TOOLKIT_SSE2)
+    return CSV_SCAN_SSE2;
+#else
+    return CSV_SCAN_SCALAR;
+#endif
+}
+
+#if defined(CSV_TOOLKIT_AVX2)
+// Scans whole 32-byte blocks from 'i'; returns where the unscanned tail starts.
+CSV_TOOLKIT_TARGET_AVX2 size_t scanCsvBlocksAvx2(const char* data, size_t i, size_t size, char delimiter, std::vector<size_t>& positions) {
+    const __m256i delimiters32 = _mm256_set1_epi8(delimiter);
+    const __m256i quotes32 = _mm256_set1_epi8('"');
+    const __m256i newlines32 = _mm256_set1_epi8('\n');
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, delimiters32), _mm256_cmpeq_epi8(chunk, quotes32)),
+                                       _mm256_cmpeq_epi8(chunk, newlines32));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+        while (mask) {
+            positions.push_back(i + lowestSetBit(mask));
+            mask &= mask - 1;
+        }
+    }
+    return i;
+}
+#endif
+
+#if defined(CSV_TOOLKIT_SSE2)
+// As scanCsvBlocksAvx2, 16 bytes at a time.
+size_t scanCsvBlocksSse2(const char* data, size_t i, size_t size, char delimiter, std::vector<size_t>& positions) {
+    const __m128i delimiters16 = _mm_set1_epi8(delimiter);
+    const __m128i quotes16 = _mm_set1_epi8('"');
+    const __m128i newlines16 = _mm_set1_epi8('\n');
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, delimiters16), _mm_cmpeq_epi8(chunk, quotes16)),
+                                    _mm_cmpeq_epi8(chunk, newlines16));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+        while (mask) {
+            positions.push_back(i + lowestSetBit(mask));
+            mask &= mask - 1;
+        }
+    }
+    return i;
+}
+#endif
+
+void indexCsvStructure(const char* data, size_t size, char delimiter, std::vector<size_t>& positions) {
+    indexCsvStructure(data, size, delimiter, positions, bestCsvScanKernel());
+}
+
+// Records the offset of every delimiter, '"' and '\n' byte in one pass over the
+// buffer, with the given kernel (lowered to bestCsvScanKernel if needed) and a
+// scalar tail. Quote state is not tracked here; tokenizeIndexedLine applies it
+// to the recorded positions.
+void indexCsvStructure(const char* data, size_t size, char delimiter, std::vector<size_t>& positions, CsvScanKernel kernel) {
+    positions.clear();
+    positions.reserve(size / 6 + 16);
+    if (kernel > bestCsvScanKernel()) kernel = bestCsvScanKernel();
+    size_t i = 0;
+
+#if defined(CSV_TOOLKIT_AVX2)
+    if (kernel >= CSV_SCAN_AVX2) i = scanCsvBlocksAvx2(data, i, size, delimiter, positions);
+#endif
+#if defined(CSV_TOOLKIT_SSE2)
+    if (kernel >= CSV_SCAN_SSE2) i = scanCsvBlocksSse2(data, i, size, delimiter, positions);
+#endif
+    for (; i < size; ++i) {
+        char c = data[i];
+        if (c == delimiter || c == '"' || c == '\n') positions.push_back(i);
+    }
+}
+
+// True when text is one quoted field: it opens and closes with '"' and every
+// quote in between is doubled.
+bool isQuotedField(const char* text, size_t length) {
+    if (length < 2 || text[0] != '"' || text[length - 1] != '"') return false;
+    for (size_t i = 1; i + 1 < length; ++i) {
+        if (text[i] != '"') continue;
+        if (i + 2 < length && text[i + 1] == '"') ++i;
+        else return false;
+    }
+    return true;
+}
+
+// Copies a cell without its quote marks; inside quotes a doubled '"' stands for
+// one quote character (RFC 4180). Returns the bytes written to 'out'.
+size_t unquoteCell(const char* text, size_t length, char* out) {
+    size_t written = 0;
+    bool insideQuotes = false;
+    for (size_t i = 0; i < length; ++i) {
+        char c = text[i];
+        if (c != '"') out[written++] = c;
+        else if (insideQuotes && i + 1 < length && text[i + 1] == '"') { out[written++] = '"'; ++i; }
+        else insideQuotes = !insideQuotes;
+    }
+    return written;
+}
+
+// Length of unquoteCell's output for the same text.
+size_t unquotedLength(const char* text, size_t length) {
+    size_t written = 0;
+    bool insideQuotes = false;
+    for (size_t i = 0; i < length; ++i) {
+        if (text[i] != '"') ++written;
+        else if (insideQuotes && i + 1 < length && text[i + 1] == '"') { ++written; ++i; }
+        else insideQuotes = !insideQuotes;
+    }
+    return written;
+}
+
+// Splits one line into CellViews using the structural positions that fall inside
+// it. Rules are those of parseCsvRowScalar: quotes toggle and are dropped (hasQuotes),
+// delimiters inside quotes are content, and once expectedFields - 1 tokens exist
+// the rest of the line becomes the last token: unquoted when it is a single
+// quoted field (as CsvWriter writes it), else raw. '\n' entries count as content.
+int tokenizeIndexedLine(const char* base, size_t lineStart, size_t lineLength, const size_t* structural, size_t structuralCount,
+                        char delimiter, int expectedFields, CellView* views) {
+    if (expectedFields < 1) return 0;
+
+    size_t lineEnd = lineStart + lineLength;
+    size_t tokenStart = lineStart;
+    size_t quotesInToken = 0;
+    bool insideQuotes = false;
+    int tokenIndex = 0;
+
+    for (size_t k = 0; k < structuralCount; ++k) {
+        size_t position = structural[k];
+        if (position < lineStart) continue;
+        if (position >= lineEnd) break;
+        char c = base[position];
+
+        if (c == '"') {
+            insideQuotes = !insideQuotes;
+            ++quotesInToken;
+        } else if (c == delimiter && !insideQuotes) {
+            if (tokenIndex < expectedFields) {
+                views[tokenIndex++] = CellView{tokenStart, static_cast<uint32_t>(position - tokenStart), quotesInToken > 0};
+            }
+            tokenStart = position + 1;
+            quotesInToken = 0;
+
+            if (tokenIndex == expectedFields - 1) {
+                size_t restLength = lineEnd - (position + 1);
+                views[tokenIndex++] = CellView{position + 1, static_cast<uint32_t>(restLength), isQuotedField(base + position + 1, restLength)};
+                return tokenIndex;
+            }
+        }
+    }
+
+    if (tokenIndex < expectedFields) {
+        size_t contentBytes = (lineEnd - tokenStart) - quotesInToken;
+        if (contentBytes == 0 && quotesInToken > 0) contentBytes = unquotedLength(base + tokenStart, lineEnd - tokenStart); // "" pairs
+        bool emitToken = contentBytes > 0
+            || (lineLength > 0 && base[lineEnd - 1] == delimiter && !insideQuotes)
+            || lineLength == 0;
+        if (emitToken) views[tokenIndex++] = CellView{tokenStart, static_cast<uint32_t>(lineEnd - tokenStart), quotesInToken > 0};
+    }
+    return tokenIndex;
+}
+
+// Lines shorter than one vector block gain nothing from the structural index,
+// so they go through the scalar tokenizer.
 char** parseCsvRow(const std::string& line, char delimiter, int expectedFields, int& actualTokenCount) {
+    if (line.length() < 16) return parseCsvRowScalar(line, delimiter, expectedFields, actualTokenCount);
+    if (expectedFields < 1) {
+        actualTokenCount = 0;
+        return nullptr;
+    }
+
+    char** tokens = new char*[expectedFields];
+    for (int i = 0; i < expectedFields; ++i) {
+        tokens[i] = nullptr;
+    }
+
+    std::vector<size_t> structural;
+    indexCsvStructure(line.data(), line.length(), delimiter, structural);
+    std::vector<CellView> views(static_cast<size_t>(expectedFields));
+    actualTokenCount = tokenizeIndexedLine(line.data(), 0, line.length(), structural.data(), structural.size(), delimiter, expectedFields, views.data());
+
+    for (int t = 0; t < actualTokenCount; ++t) {
+        const CellView& view = views[t];
+        tokens[t] = new char[view.length + 1];
+        size_t written = view.hasQuotes ? unquoteCell(line.data() + view.offset, view.length, tokens[t]) : view.length;
+        if (!view.hasQuotes) memcpy(tokens[t], line.data() + view.offset, view.length);
+        tokens[t][written] = '\0';
+    }
+    return tokens;
+}
+
+// Byte-at-a-time tokenizer with the same rules as parseCsvRow. It is the reference
+// the structural-index path is tested against (tests/csv_tokenizer_test.cpp), so
+// keep the two in step.
+char** parseCsvRowScalar(const std::string& line, char delimiter, int expectedFields, int& actualTokenCount) {
     if (expectedFields < 1) {
         actualTokenCount = 0;
         return nullptr;
@@ -153,19 +1472,26 @@ char** parseCsvRow(const std::string& line, char delimiter, int expectedFields,
         char c = line[i];
 
         if (c == '"') {
-            insideQuotes = !insideQuotes;
+            if (insideQuotes && i + 1 < line.length() && line[i + 1] == '"') {
+                currentTokenBuffer += '"';
+                ++i;
+            } else {
+                insideQuotes = !insideQuotes;
+            }
         } else if (c == delimiter && !insideQuotes) {
             if (tokenIndex < expectedFields) {
-                tokens[tokenIndex] = new char[currentTokenBuffer.length() + 1];
-                strcpy(tokens[tokenIndex], currentTokenBuffer.c_str());
-                tokenIndex++;
+                tokens[tokenIndex++] = duplicateString(currentTokenBuffer.c_str());
             }
             currentTokenBuffer.clear();
 
-            if (tokenIndex == expectedFields - 1 && tokenIndex < expectedFields ) {
+            if (tokenIndex == expectedFields - 1) {
                 std::string restOfLine = line.substr(i + 1);
-                tokens[tokenIndex] = new char[restOfLine.length() + 1];
-                strcpy(tokens[tokenIndex], restOfLine.c_str());
+                if (isQuotedField(restOfLine.data(), restOfLine.length())) {
+                    tokens[tokenIndex] = new char[restOfLine.length() + 1];
+                    tokens[tokenIndex][unquoteCell(restOfLine.data(), restOfLine.length(), tokens[tokenIndex])] = '\0';
+                } else {
+                    tokens[tokenIndex] = duplicateString(restOfLine.c_str());
+                }
                 tokenIndex++;
                 actualTokenCount = tokenIndex;
                 return tokens;
@@ -176,201 +1502,2762 @@ char** parseCsvRow(const std::string& line, char delimiter, int expectedFields,
     }
 
     if (tokenIndex < expectedFields && !currentTokenBuffer.empty()) {
-        tokens[tokenIndex] = new char[currentTokenBuffer.length() + 1];
-        strcpy(tokens[tokenIndex], currentTokenBuffer.c_str());
-        tokenIndex++;
-    } else if (tokenIndex < expectedFields && currentTokenBuffer.empty() && line.length() > 0 && line.back() == delimiter && !insideQuotes) {
-        tokens[tokenIndex] = new char[1];
-        tokens[tokenIndex][0] = '\0';
-        tokenIndex++;
-    } else if (tokenIndex < expectedFields && currentTokenBuffer.empty() && line.empty()){
-         tokens[tokenIndex] = new char[1];
-         tokens[tokenIndex][0] = '\0';
-         tokenIndex++;
+        tokens[tokenIndex++] = duplicateString(currentTokenBuffer.c_str());
+    } else if (tokenIndex < expectedFields && line.length() > 0 && line.back() == delimiter && !insideQuotes) {
+        tokens[tokenIndex++] = duplicateString("");
+    } else if (tokenIndex < expectedFields && line.empty()) {
+        tokens[tokenIndex++] = duplicateString("");
     }
 
     actualTokenCount = tokenIndex;
     return tokens;
 }
 
-dataContainer2D getData(const std::string& filenameWithExtension) {
-    dataContainer2D container;
-    fs::path dataDir;
+// --- Data Directory ---
+DataStore& DataStore::instance() {
+    static DataStore store;
+    return store;
+}
 
+// Looks where the toolkit always has: ../data from a src/ working directory,
+// ../../data from a build directory (project_root/src/build), else ./data. If
+// none exists yet, ../data (./data at a filesystem root) is created on the
+// first write.
+DataStore::DataStore() : dirFd_(-1), rootExists_(false), clockOffset_(0), clockOffsetKnown_(false) {
+    fs::path dataDir = "data";
     try {
         fs::path currentPath = fs::current_path();
+        std::vector<fs::path> candidates;
         if (currentPath.has_parent_path()) {
-            dataDir = currentPath.parent_path() / "data";
-             if (!fs::exists(dataDir) && currentPath.parent_path().has_parent_path()){ // project_root/src/build -> project_root/data
-                dataDir = currentPath.parent_path().parent_path() / "data";
-            }
-        } else { // Running from root of a drive or similar
-            dataDir = currentPath / "data";
-        }
-
-        // Final check for 'data' directory existence
-        if (!fs::exists(dataDir) || !fs::is_directory(dataDir)) {
-            fs::path alternativeDataDir = fs::current_path() / "data"; // e.g. running from project_root
-            if (fs::exists(alternativeDataDir) && fs::is_directory(alternativeDataDir)) {
-                dataDir = alternativeDataDir;
-            } else { // Try to create data dir if it's in a reasonable place (relative to parent or current)
-                 fs::path primaryAttemptPath = currentPath.has_parent_path() ? currentPath.parent_path() / "data" : currentPath / "data";
-                 std::cout << "Info: 'data' directory not found at " << primaryAttemptPath.string() 
-                           << " or " << alternativeDataDir.string() << ". Attemping to use/create: " << primaryAttemptPath.string() << std::endl;
-                dataDir = primaryAttemptPath; // Choose one to try to create if necessary
-                // This directory creation logic might be too aggressive or platform-dependent for a library.
-                // Better to assume the 'data' directory exists or handle its absence more gracefully.
-                // For now, will proceed as if it exists or error out if file can't be opened.
-                // The file opening will fail if dataDir isn't found/creatable.
-            }
+            candidates.push_back(currentPath.parent_path() / "data");
+            if (currentPath.parent_path().has_parent_path()) candidates.push_back(currentPath.parent_path().parent_path() / "data");
+        }
+        candidates.push_back(currentPath / "data");
+        dataDir = candidates.front();
+        for (const fs::path& candidate : candidates) {
+            std::error_code ec;
+            if (fs::is_directory(candidate, ec)) { dataDir = candidate; break; }
         }
     } catch (const fs::filesystem_error& e) {
         std::cerr << "Filesystem error when determining path: " << e.what() << std::endl;
-        container.error = 1;
-        return container;
     }
+    attach(dataDir);
+}
 
-    fs::path filePath = dataDir / filenameWithExtension;
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file: " << filePath.string() << std::endl;
-        container.error = 1;
-        return container;
+DataStore::~DataStore() {
+#ifndef _WIN32
+    if (dirFd_ >= 0) ::close(dirFd_);
+#endif
+}
+
+void DataStore::attach(const fs::path& dataDir) {
+#ifndef _WIN32
+    if (dirFd_ >= 0) ::close(dirFd_);
+    dirFd_ = ::open(dataDir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    rootExists_ = dirFd_ >= 0;
+#else
+    std::error_code ec;
+    rootExists_ = fs::is_directory(dataDir, ec);
+#endif
+    root_ = dataDir;
+    clockOffsetKnown_ = false;
+}
+
+void DataStore::setRoot(const fs::path& dataDir) {
+    flushWriteAheadLog();
+    TableCache::instance().clear();
+    attach(dataDir);
+    WriteAheadLog::instance().reopen();
+    TableWatcher::instance().watch(root_);
+}
+
+bool DataStore::ensureRoot() {
+    if (rootExists_) return true;
+    std::cout << "Info: Data directory (" << root_.string() << ") not found, attempting to create." << std::endl;
+    std::error_code ec;
+    fs::create_directories(root_, ec);
+    if (ec) {
+        std::cerr << "Error: Could not create data directory: " << root_.string() << std::endl;
+        return false;
     }
+    attach(root_);
+    TableWatcher::instance().watch(root_); // There was nothing to watch before
+    return rootExists_;
+}
 
-    std::string lineBuffer;
-    int M_expectedFields = 0;
-
-    if (std::getline(file, lineBuffer)) {
-        if (lineBuffer.empty() && !file.eof()) {
-             if (!std::getline(file, lineBuffer)){
-                 std::cerr << "Error: CSV file is empty or contains only an empty header line after first." << std::endl;
-                 container.error = 1; file.close(); return container;
-             }
-        } else if (lineBuffer.empty() && file.eof()){
-            std::cerr << "Error: CSV file is empty or header is empty." << std::endl;
-            container.error = 1; file.close(); return container;
-        }
-
-        if (lineBuffer.length() >= 3 && static_cast<unsigned char>(lineBuffer[0]) == 0xEF &&
-            static_cast<unsigned char>(lineBuffer[1]) == 0xBB && static_cast<unsigned char>(lineBuffer[2]) == 0xBF) {
-            lineBuffer = lineBuffer.substr(3);
-        }
-        if (!lineBuffer.empty() && lineBuffer.back() == '\r') lineBuffer.pop_back();
-
-        int actualFieldCountInHeader = 0;
-        char** tempFields = parseCsvRow(lineBuffer, ',', 256, actualFieldCountInHeader);
-
-        if (!tempFields || actualFieldCountInHeader == 0) {
-             std::cerr << "Error: Could not parse header or header is empty in file: " << filePath.string() << std::endl;
-             container.error = 1;
-             if(tempFields) {
-                 for(int i=0; i < 256; ++i) delete[] tempFields[i]; // Clean up if array was made
-                 delete[] tempFields;
-             }
-             file.close(); return container;
-        }
-        M_expectedFields = actualFieldCountInHeader;
-        container.x = M_expectedFields;
-        container.fields = new char*[M_expectedFields];
-        for(int i=0; i < M_expectedFields; ++i) {
-            if (tempFields[i]) container.fields[i] = tempFields[i]; // Transfer ownership
-            else { container.fields[i] = new char[1]; container.fields[i][0] = '\0';} // Should not happen
-        }
-        // Clean up remaining pointers in tempFields if they were somehow allocated by parseCsvRow beyond actualFieldCountInHeader
-        // (current parseCsvRow doesn't do this for its main output, but good for safety with the large expectedFields value)
-        for (int i = M_expectedFields; i < 256; ++i) delete[] tempFields[i]; // delete[] nullptr is safe
-        delete[] tempFields; // Delete the temporary array of pointers.
-    } else {
-        std::cerr << "Error: Could not read header line (file might be empty): " << filePath.string() << std::endl;
-        container.error = 1; file.close(); return container;
-    }
-
-    int rowCount = 0; int rowCapacity = 10;
-    if (rowCapacity == 0 && container.y > 0) rowCapacity = 10; // Ensure capacity if y > 0 but capacity is 0.
-    container.data = new char**[rowCapacity > 0 ? rowCapacity : 1]; // Min alloc 1 to avoid new char**[0]
-    if (rowCapacity > 0) container.data[0] = nullptr; 
-
-    while (std::getline(file, lineBuffer)) {
-        if (lineBuffer.empty()) continue;
-        if (!lineBuffer.empty() && lineBuffer.back() == '\r') lineBuffer.pop_back();
-
-        if (rowCount >= rowCapacity) {
-            int newCapacity = rowCapacity == 0 ? 10 : rowCapacity * 2;
-            char*** newData = new char**[newCapacity];
-            for (int i = 0; i < rowCount; ++i) newData[i] = container.data[i];
-            for (int i = rowCount; i < newCapacity; ++i) newData[i] = nullptr; // Init new part
-            delete[] container.data;
-            container.data = newData;
-            rowCapacity = newCapacity;
-        }
-
-        int actualDataTokensInRow = 0;
-        container.data[rowCount] = parseCsvRow(lineBuffer, ',', M_expectedFields, actualDataTokensInRow);
-        
-        if (!container.data[rowCount]) {
-            std::cerr << "Warning: Failed to parse data row " << (rowCount + 1) << ". Malformed CSV or memory issue. Skipping." << std::endl;
-            continue; 
-        }
-
-        if (actualDataTokensInRow != M_expectedFields) {
-            // std::cerr << "Warning: Row " << (rowCount + 1) << " in " << filenameWithExtension << " has " << actualDataTokensInRow
-            //           << " fields, expected " << M_expectedFields << ". Padding with empty strings." << std::endl;
-            for(int k=actualDataTokensInRow; k < M_expectedFields; ++k) {
-                if (container.data[rowCount][k] == nullptr) { // If parseCsvRow didn't fill it
-                    container.data[rowCount][k] = new char[1];
-                    container.data[rowCount][k][0] = '\0';
-                }
-            }
-        }
-        rowCount++;
+int DataStore::openFile(const std::string& filenameWithExtension, int flags, int mode) {
+#ifndef _WIN32
+    if (dirFd_ < 0) return -1;
+    return ::openat(dirFd_, filenameWithExtension.c_str(), flags | O_CLOEXEC, mode);
+#else
+    (void)filenameWithExtension; (void)flags; (void)mode;
+    return -1;
+#endif
+}
+
+// file_time_type's epoch is unspecified before C++20, so its distance from the
+// Unix epoch is measured once, on the directory itself.
+bool DataStore::fileClockOffset(fs::file_time_type::duration& offset) {
+#ifndef _WIN32
+    auto sinceUnixEpoch = [](const struct stat& info) {
+#ifdef __APPLE__
+        const struct timespec& stamp = info.st_mtimespec;
+#else
+        const struct timespec& stamp = info.st_mtim;
+#endif
+        return std::chrono::duration_cast<fs::file_time_type::duration>(std::chrono::seconds(stamp.tv_sec) + std::chrono::nanoseconds(stamp.tv_nsec));
+    };
+    for (int attempt = 0; attempt < 3 && !clockOffsetKnown_ && dirFd_ >= 0; ++attempt) {
+        struct stat before, after;
+        std::error_code ec;
+        if (fstat(dirFd_, &before) != 0) break;
+        fs::file_time_type seen = fs::last_write_time(root_, ec);
+        if (ec || fstat(dirFd_, &after) != 0) break;
+        if (sinceUnixEpoch(before) != sinceUnixEpoch(after)) continue; // Changed in between; measure again
+        clockOffset_ = seen.time_since_epoch() - sinceUnixEpoch(before);
+        clockOffsetKnown_ = true;
     }
-    container.y = rowCount;
-    file.close();
+#endif
+    offset = clockOffset_;
+    return clockOffsetKnown_;
+}
 
-    if (rowCount > 0 && rowCount < rowCapacity) {
-        char*** finalData = new char**[rowCount]; 
-        for (int i = 0; i < rowCount; ++i) finalData[i] = container.data[i];
-        delete[] container.data;
-        container.data = finalData;
-    } else if (rowCount == 0 && container.data != nullptr) { 
-        delete[] container.data; container.data = nullptr;
+bool DataStore::statFile(const std::string& filenameWithExtension, fs::file_time_type& modifiedAt, uintmax_t& fileSize) {
+#ifndef _WIN32
+    fs::file_time_type::duration offset;
+    if (dirFd_ >= 0 && fileClockOffset(offset)) {
+        struct stat info;
+        if (fstatat(dirFd_, filenameWithExtension.c_str(), &info, 0) != 0 || !S_ISREG(info.st_mode)) return false;
+#ifdef __APPLE__
+        const struct timespec& stamp = info.st_mtimespec;
+#else
+        const struct timespec& stamp = info.st_mtim;
+#endif
+        modifiedAt = fs::file_time_type(offset + std::chrono::duration_cast<fs::file_time_type::duration>(
+                                                     std::chrono::seconds(stamp.tv_sec) + std::chrono::nanoseconds(stamp.tv_nsec)));
+        fileSize = static_cast<uintmax_t>(info.st_size);
+        return true;
     }
-    return container;
+#endif
+    fs::path filePath = pathOf(filenameWithExtension);
+    std::error_code ec;
+    modifiedAt = fs::last_write_time(filePath, ec);
+    if (ec) return false;
+    fileSize = fs::file_size(filePath, ec);
+    return !ec;
 }
 
+bool DataStore::syncRoot() {
+#ifndef _WIN32
+    return dirFd_ >= 0 && fsync(dirFd_) == 0;
+#else
+    return true; // No directory fsync on Windows; MoveFileEx replaces the file atomically
+#endif
+}
 
-// --- Utilities ---
-void clearTerminal() {
-    std::cout << "\033[2J\033[1;1H"; // Clears screen, moves cursor to top-left (ANSI)
-    std::cout.flush();
+// <data dir>/<file>; the directory was resolved once by DataStore.
+int resolveDataFilePath(const std::string& filenameWithExtension, fs::path& filePath) {
+    filePath = DataStore::instance().pathOf(filenameWithExtension);
+    return 0;
 }
 
-char* getString(const char* prompt) {
-    std::string inputString;
-    if(prompt) std::cout << prompt;
-    std::getline(std::cin, inputString);
+// --- Memory-Mapped Reading ---
+int MappedFile::open(const fs::path& path) {
+    close();
+#ifndef _WIN32
+    return map(::open(path.c_str(), O_RDONLY), path);
+#else
+    return map(-1, path);
+#endif
+}
 
-    if (std::cin.fail() && !std::cin.eof()) {
-        std::cin.clear();
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear rest of bad input line
-        std::cerr << "Input error during getString." << std::endl;
-        char* errorRes = new char[1]; errorRes[0] = '\0'; return errorRes;
+int MappedFile::openData(const std::string& filenameWithExtension) {
+    close();
+    DataStore& store = DataStore::instance();
+#ifndef _WIN32
+    return map(store.openFile(filenameWithExtension, O_RDONLY), store.pathOf(filenameWithExtension));
+#else
+    return map(-1, store.pathOf(filenameWithExtension));
+#endif
+}
+
+// Maps the open descriptor 'fd', closing it; without one (or if mapping fails)
+// 'path' is read whole instead.
+int MappedFile::map(int fd, const fs::path& path) {
+#ifndef _WIN32
+    if (fd < 0) return 1;
+    struct stat info;
+    if (fstat(fd, &info) != 0) { ::close(fd); return 1; }
+    size = static_cast<size_t>(info.st_size);
+    if (size > 0) {
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            data = static_cast<const char*>(mapped);
+            mapped_ = true;
+        }
     }
+    ::close(fd); // The mapping stays valid after the descriptor is closed
+    if (size == 0 || mapped_) return 0;
+#else
+    (void)fd;
+#endif
+    // No mmap on this platform (or mapping failed): read the whole file once instead.
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) { size = 0; return 1; }
+    fallback_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data = fallback_.data();
+    size = fallback_.size();
+    return 0;
+}
 
-    char* result = new char[inputString.length() + 1];
-    strcpy(result, inputString.c_str());
-    return result;
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mapped_ && data) munmap(const_cast<char*>(data), size);
+#endif
+    mapped_ = false;
+    fallback_.clear();
+    data = nullptr;
+    size = 0;
 }
 
-int getInt(const char* prompt) {
-    std::string line;
-    if(prompt) std::cout << prompt;
-    std::getline(std::cin, line);
+char* materializeCell(const char* base, const CellView& view, CellArena& arena) {
+    if (!view.hasQuotes) return arena.copyString(base + view.offset, view.length);
 
-    if (std::cin.fail() && !std::cin.eof()) {
-        std::cin.clear();
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    char* out = static_cast<char*>(arena.allocate(view.length + 1, 1));
+    out[unquoteCell(base + view.offset, view.length, out)] = '\0';
+    return out;
+}
+
+std::string CsvViewTable::cellString(int row, int col) const {
+    const CellView& view = cells[static_cast<size_t>(row) * x + col];
+    if (!view.hasQuotes) return std::string(file.data + view.offset, view.length);
+    std::string value(view.length, '\0');
+    value.resize(unquoteCell(file.data + view.offset, view.length, &value[0]));
+    return value;
+}
+
+// Offset of the first row break at or after 'from' in data[rowStart, end), where
+// 'rowStart' begins a row: the first '\n' outside a quoted field. A '"' opens a
+// quoted field only at the start of a field, and "" inside one is an escaped
+// quote. A quote that is not closed before 'end' opens nothing, so its line ends
+// at its own line break; '*unclosed' is then set. Returns 'end' if no row break
+// is found. Before 'from' only the quotes are visited.
+size_t findCsvRowBreak(const char* data, size_t rowStart, size_t from, size_t end, bool* unclosed) {
+    size_t i = rowStart;
+    size_t lineEnd = end; // First '\n' at or after i, once i >= from
+    bool lineEndKnown = false;
+    while (i < end) {
+        const char* quote;
+        if (i < from) {
+            quote = static_cast<const char*>(memchr(data + i, '"', from - i));
+            if (!quote) { i = from; continue; }
+        } else {
+            if (!lineEndKnown || lineEnd < i) {
+                const char* newline = static_cast<const char*>(memchr(data + i, '\n', end - i));
+                lineEnd = newline ? static_cast<size_t>(newline - data) : end;
+                lineEndKnown = true;
+            }
+            quote = static_cast<const char*>(memchr(data + i, '"', lineEnd - i));
+            if (!quote) return lineEnd;
+        }
+
+        size_t q = static_cast<size_t>(quote - data);
+        i = q + 1;
+        if (q != rowStart && data[q - 1] != ',' && data[q - 1] != '\n') continue; // Inside a field: no quoted field
+        size_t close = q + 1;
+        for (;;) {
+            const char* next = static_cast<const char*>(memchr(data + close, '"', end - close));
+            if (!next) { close = end; break; }
+            close = static_cast<size_t>(next - data);
+            if (close + 1 < end && data[close + 1] == '"') { close += 2; continue; }
+            break;
+        }
+        if (close < end) i = close + 1;
+        else if (unclosed) *unclosed = true;
+    }
+    return end;
+}
+
+// Splits data[cursor, end) into rows at findCsvRowBreak's row breaks, with a
+// final unterminated row only when it is non-empty. The row's structural
+// positions are structural[firstStructural, endStructural); quoted '\n' entries
+// are among them.
+bool nextIndexedLine(const char* data, size_t end, const std::vector<size_t>& structural, size_t& cursor, size_t& nextStructural, IndexedLine& line) {
+    if (cursor >= end) return false;
+    line.start = cursor;
+    line.firstStructural = nextStructural;
+
+    size_t rowBreak = findCsvRowBreak(data, cursor, cursor, end);
+    size_t k = nextStructural;
+    while (k < structural.size() && structural[k] < rowBreak) ++k;
+    line.endStructural = k;
+
+    if (rowBreak < end) {
+        line.length = rowBreak - cursor;
+        cursor = rowBreak + 1;
+        nextStructural = k + 1; // structural[k] is the row break
+        line.reachedEnd = false;
+    } else {
+        line.length = end - cursor;
+        cursor = end;
+        nextStructural = k;
+        line.reachedEnd = true;
+    }
+    return true;
+}
+
+// Threads worth using to parse 'bytes' of CSV: one below 1 MiB, then one per
+// 256 KiB up to the core count.
+int csvParseThreads(size_t bytes) {
+    const size_t minParallelBytes = 1 << 20;
+    const size_t bytesPerThread = 256 * 1024;
+    if (bytes < minParallelBytes) return 1;
+    unsigned cores = std::thread::hardware_concurrency();
+    size_t wanted = bytes / bytesPerThread;
+    return static_cast<int>(std::max<size_t>(1, std::min<size_t>(wanted, cores > 0 ? cores : 1)));
+}
+
+// Runs work(i) for every i in [0, tasks) on up to 'threads' threads, the calling
+// thread included; each takes the next unclaimed task until none are left.
+template <typename Work>
+void runOnThreadPool(size_t tasks, int threads, Work work) {
+    std::atomic<size_t> nextTask(0);
+    auto worker = [&]() {
+        for (size_t i = nextTask++; i < tasks; i = nextTask++) work(i);
+    };
+    size_t helpers = std::min(tasks, static_cast<size_t>(threads > 1 ? threads : 1)) - (tasks > 0 ? 1 : 0);
+    std::vector<std::thread> pool;
+    pool.reserve(helpers);
+    for (size_t t = 0; t < helpers; ++t) pool.emplace_back(worker);
+    worker();
+    for (std::thread& thread : pool) thread.join();
+}
+
+// Reads the row pointer comment at 'text'; false for any other line.
+bool parseRowPointer(const char* text, size_t length, size_t& target) {
+    if (length < ROW_POINTER_BYTES || text[0] != '#' || text[1] != '>') return false;
+    target = 0;
+    for (size_t i = 2; i < ROW_POINTER_BYTES; ++i) {
+        char c = text[i];
+        int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+        if (digit < 0) return false;
+        target = target * 16 + static_cast<size_t>(digit);
+    }
+    return true;
+}
+
+// "#>" and 'target' in ROW_POINTER_DIGITS hex digits, without a line break.
+std::string rowPointerText(size_t target) {
+    std::string text(ROW_POINTER_BYTES, '0');
+    text[0] = '#';
+    text[1] = '>';
+    for (size_t i = ROW_POINTER_BYTES; i > 2 && target > 0; --i, target /= 16) text[i - 1] = "0123456789abcdef"[target % 16];
+    return text;
+}
+
+// A comment line of exactly 'bytes' bytes, line break included; 'bytes' must be
+// at least 2, or 3 with "\r\n".
+std::string fillerLine(size_t bytes, bool crlf) {
+    std::string line = "#";
+    line.append(bytes - 1 - (crlf ? 2 : 1), ' ');
+    line += crlf ? "\r\n" : "\n";
+    return line;
+}
+
+// Tokenizes the rows in data[chunk.begin, chunk.end) with the same rules as a
+// whole-file pass: blank lines and comment lines are skipped (row pointers are
+// collected on the way), a trailing '\r' is dropped, and short rows are padded.
+// Extents and cells use absolute file offsets.
+void parseCsvChunk(const char* data, int fieldCount, CsvChunk& chunk) {
+    std::vector<size_t> structural;
+    indexCsvStructure(data + chunk.begin, chunk.end - chunk.begin, ',', structural);
+    for (size_t& position : structural) position += chunk.begin;
+
+    std::vector<CellView> rowViews(static_cast<size_t>(fieldCount));
+    size_t cursor = chunk.begin, nextStructural = 0;
+    IndexedLine line;
+    while (nextIndexedLine(data, chunk.end, structural, cursor, nextStructural, line)) {
+        size_t firstLine = ++chunk.lines;
+        if (line.length == 0) continue;
+        if (data[line.start] == '#') {
+            size_t target = 0;
+            if (parseRowPointer(data + line.start, line.length, target)) chunk.pointers.emplace_back(line.start, target);
+            for (size_t k = line.firstStructural; k < line.endStructural; ++k) {
+                if (data[structural[k]] == '\n') ++chunk.lines;
+            }
+            continue;
+        }
+
+        size_t quotes = 0;
+        for (size_t k = line.firstStructural; k < line.endStructural; ++k) {
+            if (data[structural[k]] == '"') ++quotes;
+            else if (data[structural[k]] == '\n') ++chunk.lines; // Inside a quoted field
+        }
+        if (quotes % 2 != 0) chunk.unbalancedLines.push_back(firstLine);
+
+        size_t rowLength = line.length;
+        if (data[line.start + line.length - 1] == '\r') --line.length;
+        int tokenCount = tokenizeIndexedLine(data, line.start, line.length, structural.data() + line.firstStructural,
+                                             line.endStructural - line.firstStructural, ',', fieldCount, rowViews.data());
+        for (int k = tokenCount; k < fieldCount; ++k) rowViews[k] = CellView{0, 0, false}; // Pad short rows
+        chunk.cells.insert(chunk.cells.end(), rowViews.begin(), rowViews.end());
+        chunk.rows.push_back(RowExtent{line.start, rowLength, 0, line.start});
+    }
+}
+
+// Ends each row's span at the next row or row pointer, so rewriting a row never
+// touches a pointer, and puts each moved row back where its pointer stands. The
+// rows and 'pointers' are in file order; a pointer counts only when it names the
+// start of a row after it, and only the first one naming that row.
+void orderMovedRows(CsvLayout& layout, const std::vector<std::pair<size_t, size_t>>& pointers, size_t fileSize,
+                    std::vector<CellView>& cells, size_t fieldCount) {
+    std::vector<RowExtent>& rows = layout.rows;
+    size_t nextPointer = 0;
+    for (size_t r = 0; r < rows.size(); ++r) {
+        while (nextPointer < pointers.size() && pointers[nextPointer].first < rows[r].offset) ++nextPointer;
+        size_t end = r + 1 < rows.size() ? rows[r + 1].offset : fileSize;
+        if (nextPointer < pointers.size() && pointers[nextPointer].first < end) end = pointers[nextPointer].first;
+        rows[r].span = end - rows[r].offset;
+    }
+    if (pointers.empty()) return;
+
+    std::unordered_map<size_t, size_t> rowAt;
+    for (size_t r = 0; r < rows.size(); ++r) rowAt[rows[r].offset] = r;
+    bool moved = false;
+    for (const std::pair<size_t, size_t>& pointer : pointers) {
+        auto found = rowAt.find(pointer.second);
+        if (pointer.second <= pointer.first || found == rowAt.end()) continue;
+        RowExtent& row = rows[found->second];
+        if (row.order != row.offset) continue;
+        row.order = pointer.first;
+        moved = true;
+    }
+    if (!moved) return;
+
+    std::vector<size_t> sequence(rows.size());
+    for (size_t r = 0; r < sequence.size(); ++r) sequence[r] = r;
+    std::stable_sort(sequence.begin(), sequence.end(), [&](size_t a, size_t b) { return rows[a].order < rows[b].order; });
+    std::vector<RowExtent> orderedRows;
+    std::vector<CellView> orderedCells;
+    orderedRows.reserve(rows.size());
+    orderedCells.reserve(cells.size());
+    for (size_t r : sequence) {
+        orderedRows.push_back(rows[r]);
+        orderedCells.insert(orderedCells.end(), cells.begin() + r * fieldCount, cells.begin() + (r + 1) * fieldCount);
+    }
+    rows.swap(orderedRows);
+    cells.swap(orderedCells);
+}
+
+int loadCsvViews(const std::string& filenameWithExtension, CsvViewTable& table) {
+    return loadCsvViews(filenameWithExtension, table, 0);
+}
+
+// 'threads' of 0 picks a count from the file size (see csvParseThreads). The data
+// rows are cut into ranges at row breaks, found with the quote state carried
+// from the first data row so a line break in a quoted field never splits a row,
+// then parsed on a thread pool and joined in file order, so the result is the
+// same for any thread count. Rows moved by in-place patches are then put back in
+// table order (see orderMovedRows).
+int loadCsvViews(const std::string& filenameWithExtension, CsvViewTable& table, int threads) {
+    table.error = 1; table.x = 0; table.y = 0;
+    table.fields.clear(); table.cells.clear(); table.layout = CsvLayout();
+    flushPendingWrites(filenameWithExtension); // Read what the cache already shows
+
+    fs::path filePath = DataStore::instance().pathOf(filenameWithExtension);
+    if (table.file.openData(filenameWithExtension) != 0) {
+        std::cerr << "Error: Could not open file: " << filePath.string() << std::endl;
+        return 1;
+    }
+    const char* data = table.file.data;
+    size_t size = table.file.size;
+
+    // The header is the first row, or the second when the first line is blank.
+    size_t headerEnd = std::min(findCsvRowBreak(data, 0, 0, size) + 1, size);
+    if (headerEnd == 1) headerEnd = std::min(findCsvRowBreak(data, 1, 1, size) + 1, size);
+    std::vector<size_t> structural;
+    indexCsvStructure(data, headerEnd, ',', structural);
+
+    size_t cursor = 0, nextStructural = 0;
+    size_t headerLines = 1;
+    IndexedLine line;
+
+    if (!nextIndexedLine(data, headerEnd, structural, cursor, nextStructural, line)) {
+        std::cerr << "Error: Could not read header line (file might be empty): " << filePath.string() << std::endl;
+        return 1;
+    }
+    if (line.length == 0 && !line.reachedEnd) {
+        if (!nextIndexedLine(data, headerEnd, structural, cursor, nextStructural, line)) {
+            std::cerr << "Error: CSV file is empty or contains only an empty header line after first." << std::endl;
+            return 1;
+        }
+        headerLines = 2;
+    } else if (line.length == 0 && line.reachedEnd) {
+        std::cerr << "Error: CSV file is empty or header is empty." << std::endl;
+        return 1;
+    }
+
+    const unsigned char* header = reinterpret_cast<const unsigned char*>(data + line.start);
+    if (line.length >= 3 && header[0] == 0xEF && header[1] == 0xBB && header[2] == 0xBF) {
+        line.start += 3; line.length -= 3;
+    }
+    table.layout.crlf = line.length > 0 && data[line.start + line.length - 1] == '\r';
+    if (table.layout.crlf) --line.length;
+
+    CellView headerViews[256];
+    int headerCount = tokenizeIndexedLine(data, line.start, line.length, structural.data() + line.firstStructural,
+                                          line.endStructural - line.firstStructural, ',', 256, headerViews);
+    if (headerCount == 0) {
+        std::cerr << "Error: Could not parse header or header is empty in file: " << filePath.string() << std::endl;
+        return 1;
+    }
+    table.x = headerCount;
+    table.fields.assign(headerViews, headerViews + headerCount);
+    table.layout.dataStart = cursor;
+
+    // Cut the data rows into ranges that end just after a row break. Each search
+    // starts from the previous cut, which is a row start.
+    if (threads <= 0) threads = csvParseThreads(size - cursor);
+    size_t chunkCount = threads > 1 ? static_cast<size_t>(threads) * 4 : 1; // Spare ranges even out uneven rows
+    std::vector<CsvChunk> chunks;
+    size_t chunkStart = cursor;
+    for (size_t c = 1; c <= chunkCount && chunkStart < size; ++c) {
+        size_t chunkEnd = size;
+        if (c < chunkCount) {
+            size_t target = cursor + (size - cursor) / chunkCount * c;
+            if (target < chunkStart) target = chunkStart;
+            chunkEnd = std::min(findCsvRowBreak(data, chunkStart, target, size) + 1, size);
+        }
+        if (chunkEnd <= chunkStart) continue;
+        chunks.emplace_back();
+        chunks.back().begin = chunkStart;
+        chunks.back().end = chunkEnd;
+        chunkStart = chunkEnd;
+    }
+    runOnThreadPool(chunks.size(), threads, [&](size_t c) { parseCsvChunk(data, table.x, chunks[c]); });
+
+    size_t cellCount = 0, rowCount = 0;
+    for (const CsvChunk& chunk : chunks) {
+        cellCount += chunk.cells.size();
+        rowCount += chunk.rows.size();
+    }
+    table.cells.reserve(cellCount);
+    table.layout.rows.reserve(rowCount);
+    size_t linesBefore = headerLines;
+    size_t unbalancedCount = 0;
+    std::vector<std::pair<size_t, size_t>> pointers;
+    for (CsvChunk& chunk : chunks) {
+        table.cells.insert(table.cells.end(), chunk.cells.begin(), chunk.cells.end());
+        table.layout.rows.insert(table.layout.rows.end(), chunk.rows.begin(), chunk.rows.end());
+        pointers.insert(pointers.end(), chunk.pointers.begin(), chunk.pointers.end());
+        for (size_t localLine : chunk.unbalancedLines) {
+            if (++unbalancedCount <= 5) {
+                std::cerr << "Warning: " << filenameWithExtension << " line " << linesBefore + localLine
+                          << " has an unclosed quote; the field ends at the line break." << std::endl;
+            }
+        }
+        linesBefore += chunk.lines;
+        std::vector<CellView>().swap(chunk.cells);
+    }
+    if (unbalancedCount > 5) {
+        std::cerr << "Warning: " << filenameWithExtension << " has " << unbalancedCount - 5 << " more lines with an unclosed quote." << std::endl;
+    }
+    table.y = static_cast<int>(rowCount);
+    orderMovedRows(table.layout, pointers, size, table.cells, static_cast<size_t>(table.x));
+
+    table.error = 0;
+    return 0;
+}
+
+dataContainer2D getData(const std::string& filenameWithExtension) {
+    return getData(filenameWithExtension, nullptr);
+}
+
+// Also reports where each row sits in the file when 'layout' is given. A current
+// binary snapshot is used instead of parsing; a missing or stale one is rebuilt.
+dataContainer2D getData(const std::string& filenameWithExtension, CsvLayout* layout) {
+    return getData(filenameWithExtension, layout, nullptr);
+}
+
+// When the table comes from a current snapshot, 'snapshotInts' (if given) also
+// receives its int32 columns by file column, empty for string columns; after a
+// parse it is left empty.
+dataContainer2D getData(const std::string& filenameWithExtension, CsvLayout* layout, std::vector<std::vector<int32_t>>* snapshotInts) {
+    dataContainer2D container;
+    if (snapshotInts) snapshotInts->clear();
+    if (!layout && !snapshotInts && WriteAheadLog::instance().hasLogged(filenameWithExtension)) {
+        // The file is behind the log; the cache already shows the table as it will be.
+        std::shared_ptr<CachedTable> cached = TableCache::instance().current(filenameWithExtension);
+        if (cached) return wholeTableView(cached->table).materialize();
+    }
+    flushPendingWrites(filenameWithExtension);
+    fs::file_time_type modifiedAt;
+    uintmax_t fileSize = 0;
+    bool statOk = statDataFile(filenameWithExtension, modifiedAt, fileSize); // Before parsing, so a racing edit reads as stale
+    if (statOk && readSnapshot(filenameWithExtension, modifiedAt, fileSize, container, layout, snapshotInts)) {
+        checkTableSchema(filenameWithExtension, container);
+        return container;
+    }
+
+    CsvViewTable table;
+    if (loadCsvViews(filenameWithExtension, table) != 0) {
+        container.error = 1;
+        return container;
+    }
+
+    // The views point into the mapping, so only the final cell bytes are copied.
+    // Large tables copy their cells in row ranges, each into its own arena that
+    // the container takes over afterwards.
+    int threads = csvParseThreads(table.file.size);
+    size_t ranges = threads > 1 ? static_cast<size_t>(threads) : 1;
+    size_t cellBytes = table.file.size + 2 * (table.cells.size() + table.fields.size()) + 1024;
+    size_t slotBytes = sizeof(char*) * (table.cells.size() + table.y) + 1024;
+    container.arena = new CellArena(ranges > 1 ? slotBytes + table.file.size / ranges : cellBytes + slotBytes);
+    CellArena& arena = *container.arena;
+    const char* base = table.file.data;
+
+    container.x = table.x;
+    container.fields = static_cast<char**>(arena.allocate(sizeof(char*) * table.x));
+    for (int i = 0; i < table.x; ++i) container.fields[i] = materializeCell(base, table.fields[i], arena);
+
+    container.y = table.y;
+    if (container.y > 0) {
+        container.data = static_cast<char***>(arena.allocate(sizeof(char**) * container.y));
+        char** cellSlots = static_cast<char**>(arena.allocate(sizeof(char*) * table.cells.size()));
+        char* emptyCell = arena.copyString("", 0); // Shared padding for short rows
+        for (int i = 0; i < container.y; ++i) container.data[i] = cellSlots + static_cast<size_t>(i) * container.x;
+        std::vector<std::unique_ptr<CellArena>> rangeArenas;
+        for (size_t r = 0; ranges > 1 && r < ranges; ++r) rangeArenas.emplace_back(new CellArena(cellBytes / ranges + 1024));
+        runOnThreadPool(ranges, threads, [&](size_t r) {
+            int firstRow = static_cast<int>(container.y * r / ranges);
+            int endRow = static_cast<int>(container.y * (r + 1) / ranges);
+            CellArena& cellArena = ranges > 1 ? *rangeArenas[r] : arena;
+            for (int i = firstRow; i < endRow; ++i) {
+                for (int j = 0; j < container.x; ++j) {
+                    const CellView& view = table.cells[static_cast<size_t>(i) * container.x + j];
+                    container.data[i][j] = view.length == 0 ? emptyCell : materializeCell(base, view, cellArena);
+                }
+            }
+        });
+        for (std::unique_ptr<CellArena>& rangeArena : rangeArenas) arena.adopt(*rangeArena);
+    }
+    if (statOk) writeSnapshot(filenameWithExtension, modifiedAt, fileSize, container, table.layout);
+    if (layout) std::swap(*layout, table.layout);
+    checkTableSchema(filenameWithExtension, container);
+    return container;
+}
+
+bool RowFilter::accepts(std::string_view value) const {
+    if (!field) return true;
+    for (const char* key : keys) {
+        if (key && value == key) return true;
+    }
+    return false;
+}
+
+// The text of a cell view; quoted cells are unquoted into 'scratch'.
+std::string_view cellViewText(const char* base, const CellView& view, std::string& scratch) {
+    if (!view.hasQuotes) return std::string_view(base + view.offset, view.length);
+    scratch.resize(view.length);
+    scratch.resize(unquoteCell(base + view.offset, view.length, &scratch[0]));
+    return scratch;
+}
+
+// Only 'wantedFields', in that order, of the rows 'filter' keeps. Rows are
+// tested on their cell views, and only the kept cells are copied out of the
+// mapping, so unwanted columns and rows cost no allocation. This always parses
+// the file: the table cache and snapshots hold whole tables.
+dataContainer2D getData(const std::string& filenameWithExtension, const char* const wantedFields[], int numWantedFields,
+                        const RowFilter& filter) {
+    dataContainer2D container;
+    if (!wantedFields || numWantedFields <= 0) {
+        std::cerr << "Error: No/invalid fields for projection." << std::endl;
+        container.error = 1;
+        return container;
+    }
+    CsvViewTable table;
+    if (loadCsvViews(filenameWithExtension, table) != 0) {
+        container.error = 1;
+        return container;
+    }
+    const char* base = table.file.data;
+
+    std::string scratch;
+    auto columnOf = [&](const char* name) {
+        for (int j = 0; j < table.x; ++j) {
+            if (cellViewText(base, table.fields[j], scratch) == name) return j;
+        }
+        return -1;
+    };
+    std::vector<int> columns(static_cast<size_t>(numWantedFields));
+    for (int i = 0; i < numWantedFields; ++i) {
+        columns[i] = wantedFields[i] ? columnOf(wantedFields[i]) : -1;
+        if (columns[i] == -1) {
+            std::cerr << "Error: Wanted field '" << (wantedFields[i] ? wantedFields[i] : "(null)") << "' not found in "
+                      << filenameWithExtension << "." << std::endl;
+            container.error = 1;
+            return container;
+        }
+    }
+    int filterColumn = filter.field ? columnOf(filter.field) : -1;
+    if (filter.field && filterColumn == -1) {
+        std::cerr << "Error: Field '" << filter.field << "' not found for filter." << std::endl;
+        container.error = 1;
+        return container;
+    }
+
+    std::vector<int> keptRows;
+    size_t cellBytes = 0;
+    for (int i = 0; i < table.y; ++i) {
+        if (filterColumn != -1 && !filter.accepts(cellViewText(base, table.cell(i, filterColumn), scratch))) continue;
+        keptRows.push_back(i);
+        for (int column : columns) cellBytes += table.cell(i, column).length + 1;
+    }
+
+    size_t slotBytes = sizeof(char*) * (keptRows.size() + 1) * (numWantedFields + 1);
+    container.arena = new CellArena(cellBytes + slotBytes + 1024);
+    CellArena& arena = *container.arena;
+    container.x = numWantedFields;
+    container.fields = static_cast<char**>(arena.allocate(sizeof(char*) * container.x));
+    for (int j = 0; j < container.x; ++j) container.fields[j] = materializeCell(base, table.fields[columns[j]], arena);
+
+    container.y = static_cast<int>(keptRows.size());
+    if (container.y > 0) {
+        container.data = static_cast<char***>(arena.allocate(sizeof(char**) * container.y));
+        char* emptyCell = arena.copyString("", 0); // Shared by every empty cell, as in a full load
+        for (int i = 0; i < container.y; ++i) {
+            char** row = static_cast<char**>(arena.allocate(sizeof(char*) * container.x));
+            for (int j = 0; j < container.x; ++j) {
+                const CellView& view = table.cell(keptRows[i], columns[j]);
+                row[j] = view.length == 0 ? emptyCell : materializeCell(base, view, arena);
+            }
+            container.data[i] = row;
+        }
+    }
+    return container;
+}
+
+// --- Streaming Reader ---
+CsvReader::CsvReader(size_t bufferBytes)
+    : error(1), buffer_(bufferBytes > 0 ? bufferBytes : 1), bufferStart_(0), begin_(0), end_(0), eof_(true), rowNumber_(0) {}
+
+int CsvReader::open(const std::string& filenameWithExtension) {
+    close();
+    flushPendingWrites(filenameWithExtension); // Read what the cache already shows
+    fs::path filePath;
+    if (resolveDataFilePath(filenameWithExtension, filePath) != 0) return 1;
+    return openPath(filePath);
+}
+
+// Reads the header the way loadCsvViews does: one leading blank line is
+// skipped, then a UTF-8 BOM and a trailing '\r' are dropped.
+int CsvReader::openPath(const fs::path& filePath) {
+    close();
+    path_ = filePath;
+    file_.open(filePath, std::ios::binary);
+    if (!file_.is_open()) {
+        std::cerr << "Error: Could not open file: " << filePath.string() << std::endl;
+        return 1;
+    }
+    eof_ = false;
+
+    const char* line = nullptr;
+    size_t length = 0;
+    if (!nextLine(line, length)) {
+        std::cerr << "Error: Could not read header line (file might be empty): " << filePath.string() << std::endl;
+        close();
+        return 1;
+    }
+    if (length == 0 && !nextLine(line, length)) {
+        std::cerr << "Error: CSV file is empty or contains only an empty header line after first." << std::endl;
+        close();
+        return 1;
+    }
+    const unsigned char* header = reinterpret_cast<const unsigned char*>(line);
+    if (length >= 3 && header[0] == 0xEF && header[1] == 0xBB && header[2] == 0xBF) { line += 3; length -= 3; }
+    if (length > 0 && line[length - 1] == '\r') --length;
+
+    splitLine(line, length, 256, false, headerText_, fields_);
+    if (fields_.empty()) {
+        std::cerr << "Error: Could not parse header or header is empty in file: " << filePath.string() << std::endl;
+        close();
+        return 1;
+    }
+    error = 0;
+    return 0;
+}
+
+void CsvReader::close() {
+    if (file_.is_open()) file_.close();
+    file_.clear();
+    if (movedFile_.is_open()) movedFile_.close();
+    movedFile_.clear();
+    movedRows_.clear();
+    error = 1;
+    bufferStart_ = begin_ = end_ = 0;
+    eof_ = true;
+    rowNumber_ = 0;
+    fields_.clear();
+    cells_.clear();
+}
+
+bool CsvReader::next() {
+    if (error) return false;
+    const char* line = nullptr;
+    size_t length = 0;
+    while (nextLine(line, length)) {
+        if (length == 0) continue; // Blank padding left by older in-place row updates
+        size_t offset = bufferStart_ + static_cast<size_t>(line - buffer_.data());
+        if (line[0] == '#') { // Filler, or the pointer to a moved row (see orderMovedRows)
+            size_t target = 0;
+            if (!parseRowPointer(line, length, target) || target <= offset || movedRows_.count(target) ||
+                !readRowAt(target, movedText_)) {
+                continue;
+            }
+            movedRows_.insert(target);
+            line = movedText_.data();
+            length = movedText_.size();
+        } else if (movedRows_.erase(offset) > 0) {
+            continue; // Already returned at its pointer
+        }
+        if (line[length - 1] == '\r') --length;
+        splitLine(line, length, x(), true, rowText_, cells_);
+        ++rowNumber_;
+        return true;
+    }
+    cells_.clear();
+    return false;
+}
+
+int CsvReader::columnOf(const char* fieldName) const {
+    for (int j = 0; fieldName && j < x(); ++j) {
+        if (strcmp(fields_[j], fieldName) == 0) return j;
+    }
+    return -1;
+}
+
+const char* CsvReader::cell(int col) const {
+    return col >= 0 && col < static_cast<int>(cells_.size()) ? cells_[col] : "";
+}
+
+// Rows end at findCsvRowBreak's row breaks, so a quoted field may span lines; a
+// final unterminated row counts only when non-empty. The partial row at the end
+// of the buffer is moved to the front before refilling, and the buffer only
+// grows when one row fills all of it. A row whose quote is still open at the
+// end of the buffer waits for more bytes before it is cut at its line break.
+bool CsvReader::nextLine(const char*& line, size_t& length) {
+    for (;;) {
+        bool unclosed = false;
+        size_t rowBreak = findCsvRowBreak(buffer_.data(), begin_, begin_, end_, &unclosed);
+        if (rowBreak < end_ && (!unclosed || eof_)) {
+            line = buffer_.data() + begin_;
+            length = rowBreak - begin_;
+            begin_ = rowBreak + 1;
+            return true;
+        }
+        if (eof_) {
+            if (begin_ == end_) return false;
+            line = buffer_.data() + begin_;
+            length = end_ - begin_;
+            begin_ = end_;
+            return true;
+        }
+
+        size_t partial = end_ - begin_;
+        if (begin_ > 0 && partial > 0) memmove(buffer_.data(), buffer_.data() + begin_, partial);
+        bufferStart_ += begin_;
+        begin_ = 0;
+        end_ = partial;
+        if (end_ == buffer_.size()) buffer_.resize(buffer_.size() * 2);
+        file_.read(buffer_.data() + end_, static_cast<std::streamsize>(buffer_.size() - end_));
+        std::streamsize got = file_.gcount();
+        end_ += static_cast<size_t>(got);
+        if (got == 0 || file_.eof()) eof_ = true;
+    }
+}
+
+// Only a data row counts: 'offset' must start a line that is neither blank nor
+// a comment. The row ends at its row break, found as nextLine finds it.
+bool CsvReader::readRowAt(size_t offset, std::vector<char>& text) {
+    if (!movedFile_.is_open()) movedFile_.open(path_, std::ios::binary);
+    movedFile_.clear();
+    char before = 0;
+    if (!movedFile_.seekg(static_cast<std::streamoff>(offset) - 1).get(before) || before != '\n') return false;
+
+    text.clear();
+    char block[4096];
+    for (;;) {
+        movedFile_.read(block, sizeof(block));
+        size_t got = static_cast<size_t>(movedFile_.gcount());
+        text.insert(text.end(), block, block + got);
+        bool atEnd = got < sizeof(block);
+        bool unclosed = false;
+        size_t rowBreak = findCsvRowBreak(text.data(), 0, 0, text.size(), &unclosed);
+        if (rowBreak < text.size() && (!unclosed || atEnd)) { text.resize(rowBreak); break; }
+        if (atEnd) break;
+    }
+    return !text.empty() && text[0] != '#';
+}
+
+// Same tokenizing rules as getData; cells are copied (unquoted) into 'text',
+// which is reused from row to row.
+void CsvReader::splitLine(const char* line, size_t length, int expectedFields, bool padShortRow,
+                          std::vector<char>& text, std::vector<char*>& cells) {
+    indexCsvStructure(line, length, ',', structural_);
+    views_.resize(expectedFields > 0 ? expectedFields : 1);
+    int tokenCount = tokenizeIndexedLine(line, 0, length, structural_.data(), structural_.size(), ',', expectedFields, views_.data());
+
+    text.resize(length + static_cast<size_t>(expectedFields) + 1); // Every cell's bytes plus its NUL
+    cells.assign(padShortRow ? expectedFields : tokenCount, nullptr);
+    char* out = text.data();
+    for (int t = 0; t < tokenCount; ++t) {
+        const CellView& view = views_[t];
+        cells[t] = out;
+        if (view.hasQuotes) {
+            out += unquoteCell(line + view.offset, view.length, out);
+        } else {
+            memcpy(out, line + view.offset, view.length);
+            out += view.length;
+        }
+        *out++ = '\0';
+    }
+    *out = '\0';
+    for (int t = tokenCount; t < static_cast<int>(cells.size()); ++t) cells[t] = out; // Pad short rows with ""
+}
+
+void ColumnAggregate::add(double value) {
+    if (count == 0 || value < min) min = value;
+    if (count == 0 || value > max) max = value;
+    sum += value;
+    ++count;
+}
+
+// Calls onRow(reader) for every row whose 'field' equals 'key', in file order;
+// onRow returns false to stop early. 0 on success, 1 if the file or field is missing.
+template <typename OnRow>
+int filterCsvStream(const std::string& filenameWithExtension, const char* field, const char* key, OnRow onRow) {
+    if (!field || !key) { std::cerr << "Error: Null field/key for filter." << std::endl; return 1; }
+    CsvReader reader;
+    if (reader.open(filenameWithExtension) != 0) return 1;
+    int column = reader.columnOf(field);
+    if (column == -1) {
+        std::cerr << "Error: Field '" << field << "' not found for filter." << std::endl; return 1;
+    }
+    while (reader.next()) {
+        if (strcmp(reader.cell(column), key) == 0 && !onRow(static_cast<const CsvReader&>(reader))) break;
+    }
+    return 0;
+}
+
+// Totals 'valueField' per distinct 'groupField' value in one pass; a null
+// groupField totals the whole file under "". 0 on success, 1 on error.
+int aggregateCsvStream(const std::string& filenameWithExtension, const char* groupField, const char* valueField,
+                       std::unordered_map<std::string, ColumnAggregate>& groups) {
+    groups.clear();
+    if (!valueField) { std::cerr << "Error: Null value field for aggregate." << std::endl; return 1; }
+    CsvReader reader;
+    if (reader.open(filenameWithExtension) != 0) return 1;
+    int valueColumn = reader.columnOf(valueField);
+    int groupColumn = groupField ? reader.columnOf(groupField) : -1;
+    if (valueColumn == -1 || (groupField && groupColumn == -1)) {
+        std::cerr << "Error: Field '" << (valueColumn == -1 ? valueField : groupField) << "' not found for aggregate." << std::endl;
+        return 1;
+    }
+    std::string group;
+    while (reader.next()) {
+        double value;
+        if (!parseTypedValue(reader.cell(valueColumn), COLUMN_FLOAT, value)) continue;
+        group.assign(groupField ? reader.cell(groupColumn) : "");
+        groups[group].add(value);
+    }
+    return 0;
+}
+
+// --- Binary Snapshots ---
+fs::path snapshotPathFor(const fs::path& csvPath) {
+    fs::path snapshotPath = csvPath;
+    snapshotPath += ".snap";
+    return snapshotPath;
+}
+
+// Cells that read back from an int32 exactly: no sign on zero, no leading zeros or '+'.
+bool parseSnapshotInt(const char* text, int32_t& value) {
+    size_t length = strlen(text);
+    if (length == 0 || length > 11) return false;
+    std::from_chars_result parsed = std::from_chars(text, text + length, value);
+    if (parsed.ec != std::errc() || parsed.ptr != text + length) return false;
+    char formatted[12];
+    std::to_chars_result written = std::to_chars(formatted, formatted + sizeof(formatted), value);
+    return static_cast<size_t>(written.ptr - formatted) == length && memcmp(formatted, text, length) == 0;
+}
+
+// Checksum that consumes eight bytes per step, for whole-snapshot validation.
+uint32_t hashWords(const char* bytes, size_t length) {
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ length;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 29;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, bytes + i, length - i);
+    hash = (hash ^ tail) * 0xFF51AFD7ED558CCDull;
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+template <typename T>
+T readSnapshotValue(const char* at) {
+    T value;
+    memcpy(&value, at, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void appendSnapshotValue(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Whether a snapshot header says it was built from the CSV as it is now.
+bool snapshotMatches(const SnapshotHeader& header, const fs::file_time_type& modifiedAt, uintmax_t fileSize) {
+    return memcmp(header.magic, "CSVSNAP3", 8) == 0 && header.csvSize == fileSize &&
+           header.csvModifiedAt == static_cast<int64_t>(modifiedAt.time_since_epoch().count());
+}
+
+// Loads the table from "<file>.snap" if it was built from the CSV as it is now
+// (same size and mtime) and is intact; false means parse the CSV instead. The
+// int32 columns are also copied into 'intColumns' when it is given.
+bool readSnapshot(const std::string& filenameWithExtension, const fs::file_time_type& modifiedAt, uintmax_t fileSize,
+                  dataContainer2D& container, CsvLayout* layout, std::vector<std::vector<int32_t>>* intColumns) {
+    fs::path csvPath;
+    if (resolveDataFilePath(filenameWithExtension, csvPath) != 0) return false;
+    MappedFile snapshot;
+    if (snapshot.open(snapshotPathFor(csvPath)) != 0 || snapshot.size < sizeof(SnapshotHeader)) return false;
+
+    SnapshotHeader header;
+    memcpy(&header, snapshot.data, sizeof(header));
+    if (!snapshotMatches(header, modifiedAt, fileSize) || header.columns == 0) return false;
+
+    // Section sizes, checked against the file before anything is read from it.
+    uint64_t columns = header.columns, rows = header.rows, strings = header.stringCount;
+    uint64_t kindsAt = sizeof(SnapshotHeader);
+    uint64_t namesAt = kindsAt + 4 * columns;
+    uint64_t extentsAt = namesAt + 4 * columns;
+    uint64_t cellsAt = extentsAt + 24 * rows;
+    uint64_t offsetsAt = cellsAt + 4 * rows * columns;
+    uint64_t bytesAt = offsetsAt + 4 * (strings + 1);
+    if (bytesAt > snapshot.size || columns > INT32_MAX || rows > INT32_MAX) return false;
+    const char* base = snapshot.data;
+    if (hashWords(base + kindsAt, snapshot.size - kindsAt) != header.checksum) return false;
+    uint64_t bytesSize = snapshot.size - bytesAt;
+    for (uint64_t k = 0; k <= strings; ++k) { // Offsets must be increasing and each string NUL-terminated
+        uint32_t offset = readSnapshotValue<uint32_t>(base + offsetsAt + 4 * k);
+        if (offset > bytesSize || (k > 0 && (offset <= readSnapshotValue<uint32_t>(base + offsetsAt + 4 * (k - 1)) ||
+                                            base[bytesAt + offset - 1] != '\0'))) {
+            return false;
+        }
+    }
+    for (uint64_t j = 0; j < columns; ++j) {
+        uint32_t kind = readSnapshotValue<uint32_t>(base + kindsAt + 4 * j);
+        if (kind != SNAPSHOT_STRING && kind != SNAPSHOT_INT) return false;
+        if (readSnapshotValue<uint32_t>(base + namesAt + 4 * j) >= strings) return false;
+        if (kind == SNAPSHOT_STRING) {
+            for (uint64_t i = 0; i < rows; ++i) {
+                if (readSnapshotValue<uint32_t>(base + cellsAt + 4 * (j * rows + i)) >= strings) return false;
+            }
+        }
+    }
+
+    // Each dictionary string is copied once and shared by every cell using it.
+    container.arena = new CellArena(bytesSize + 8 * (strings + columns * rows) + 1024);
+    CellArena& arena = *container.arena;
+    std::vector<char*> dictionary(strings);
+    for (uint64_t k = 0; k < strings; ++k) {
+        uint32_t offset = readSnapshotValue<uint32_t>(base + offsetsAt + 4 * k);
+        uint32_t next = readSnapshotValue<uint32_t>(base + offsetsAt + 4 * (k + 1));
+        dictionary[k] = arena.copyString(base + bytesAt + offset, next - offset - 1);
+    }
+
+    container.x = static_cast<int>(columns);
+    container.y = static_cast<int>(rows);
+    container.fields = static_cast<char**>(arena.allocate(sizeof(char*) * columns));
+    for (uint64_t j = 0; j < columns; ++j) container.fields[j] = dictionary[readSnapshotValue<uint32_t>(base + namesAt + 4 * j)];
+    if (rows > 0) {
+        container.data = static_cast<char***>(arena.allocate(sizeof(char**) * rows));
+        char** cellSlots = static_cast<char**>(arena.allocate(sizeof(char*) * rows * columns));
+        for (uint64_t i = 0; i < rows; ++i) container.data[i] = cellSlots + i * columns;
+        char formatted[12];
+        std::vector<char*> smallInts(1024, nullptr); // Counts and scores repeat, so small values are shared
+        for (uint64_t j = 0; j < columns; ++j) {
+            bool isInt = readSnapshotValue<uint32_t>(base + kindsAt + 4 * j) == SNAPSHOT_INT;
+            const char* column = base + cellsAt + 4 * j * rows;
+            if (isInt && intColumns) {
+                intColumns->resize(columns);
+                (*intColumns)[j].resize(rows);
+                memcpy((*intColumns)[j].data(), column, 4 * rows);
+            }
+            for (uint64_t i = 0; i < rows; ++i) {
+                if (isInt) {
+                    int32_t value = readSnapshotValue<int32_t>(column + 4 * i);
+                    bool small = value >= 0 && value < static_cast<int32_t>(smallInts.size());
+                    if (small && smallInts[value]) { container.data[i][j] = smallInts[value]; continue; }
+                    std::to_chars_result written = std::to_chars(formatted, formatted + sizeof(formatted), value);
+                    container.data[i][j] = arena.copyString(formatted, static_cast<size_t>(written.ptr - formatted));
+                    if (small) smallInts[value] = container.data[i][j];
+                } else {
+                    container.data[i][j] = dictionary[readSnapshotValue<uint32_t>(column + 4 * i)];
+                }
+            }
+        }
+    }
+
+    if (layout) {
+        layout->dataStart = static_cast<size_t>(header.dataStart);
+        layout->crlf = header.crlf != 0;
+        layout->rows.resize(rows);
+        for (uint64_t i = 0; i < rows; ++i) {
+            const char* extent = base + extentsAt + 24 * i;
+            layout->rows[i] = RowExtent{static_cast<size_t>(readSnapshotValue<uint64_t>(extent)), readSnapshotValue<uint32_t>(extent + 16),
+                                        readSnapshotValue<uint32_t>(extent + 20), static_cast<size_t>(readSnapshotValue<uint64_t>(extent + 8))};
+        }
+    }
+    return true;
+}
+
+// Writes "<file>.snap" for a freshly parsed table, unless the snapshot there is
+// already current (another process may have written it since readSnapshot
+// looked) or the directory is read-only. Columns whose every cell is a plain
+// int32 are stored as integers; everything else goes through one string
+// dictionary. The snapshot goes to a temp file of this process's own and is
+// renamed into place, so concurrent writers never mix their bytes. It is only a
+// cache, so failures are silently ignored.
+void writeSnapshot(const std::string& filenameWithExtension, const fs::file_time_type& modifiedAt, uintmax_t fileSize,
+                   const dataContainer2D& container, const CsvLayout& layout) {
+    if (container.error || container.x <= 0 || !container.fields || layout.rows.size() != static_cast<size_t>(container.y)) return;
+    // A CSV changed moments ago could change again within the same mtime tick
+    // without changing size, which the stamps could not tell apart.
+    if (fs::file_time_type::clock::now() - modifiedAt < std::chrono::seconds(2)) return;
+    fs::path csvPath;
+    if (resolveDataFilePath(filenameWithExtension, csvPath) != 0) return;
+    fs::path snapshotPath = snapshotPathFor(csvPath);
+    {
+        std::ifstream existing(snapshotPath, std::ios::binary);
+        SnapshotHeader header;
+        if (existing.read(reinterpret_cast<char*>(&header), sizeof(header)) && snapshotMatches(header, modifiedAt, fileSize)) return;
+    }
+#ifndef _WIN32
+    if (access(csvPath.parent_path().c_str(), W_OK) != 0) return;
+#endif
+
+    size_t columns = static_cast<size_t>(container.x), rows = static_cast<size_t>(container.y);
+    std::vector<uint32_t> kinds(columns, SNAPSHOT_INT);
+    std::vector<int32_t> ints(columns * rows);
+    for (size_t j = 0; j < columns; ++j) {
+        for (size_t i = 0; i < rows && kinds[j] == SNAPSHOT_INT; ++i) {
+            const char* cell = container.data[i][j];
+            if (!cell || !parseSnapshotInt(cell, ints[j * rows + i])) kinds[j] = SNAPSHOT_STRING;
+        }
+    }
+
+    std::unordered_map<std::string, uint32_t> codes;
+    std::string strings;
+    std::vector<uint32_t> offsets;
+    auto codeOf = [&](const char* cell) {
+        auto inserted = codes.emplace(cell ? cell : "", static_cast<uint32_t>(offsets.size()));
+        if (inserted.second) {
+            offsets.push_back(static_cast<uint32_t>(strings.size()));
+            strings += inserted.first->first;
+            strings += '\0';
+        }
+        return inserted.first->second;
+    };
+
+    std::string body;
+    body.reserve(8 * columns + 24 * rows + 4 * columns * rows);
+    for (size_t j = 0; j < columns; ++j) appendSnapshotValue<uint32_t>(body, kinds[j]);
+    for (size_t j = 0; j < columns; ++j) appendSnapshotValue<uint32_t>(body, codeOf(container.fields[j]));
+    for (const RowExtent& extent : layout.rows) {
+        if (extent.span >= UINT32_MAX) return;
+        appendSnapshotValue<uint64_t>(body, extent.offset);
+        appendSnapshotValue<uint64_t>(body, extent.order);
+        appendSnapshotValue<uint32_t>(body, static_cast<uint32_t>(extent.length));
+        appendSnapshotValue<uint32_t>(body, static_cast<uint32_t>(extent.span));
+    }
+    for (size_t j = 0; j < columns; ++j) {
+        for (size_t i = 0; i < rows; ++i) {
+            if (kinds[j] == SNAPSHOT_INT) appendSnapshotValue<int32_t>(body, ints[j * rows + i]);
+            else appendSnapshotValue<uint32_t>(body, codeOf(container.data[i][j]));
+        }
+    }
+    if (strings.size() >= UINT32_MAX) return;
+    offsets.push_back(static_cast<uint32_t>(strings.size()));
+    for (uint32_t offset : offsets) appendSnapshotValue<uint32_t>(body, offset);
+    body += strings;
+
+    SnapshotHeader header;
+    memcpy(header.magic, "CSVSNAP3", 8);
+    header.columns = static_cast<uint32_t>(columns);
+    header.rows = static_cast<uint32_t>(rows);
+    header.csvSize = fileSize;
+    header.csvModifiedAt = static_cast<int64_t>(modifiedAt.time_since_epoch().count());
+    header.dataStart = layout.dataStart;
+    header.crlf = layout.crlf ? 1 : 0;
+    header.reserved = 0;
+    header.stringCount = static_cast<uint32_t>(offsets.size() - 1);
+    header.checksum = hashWords(body.data(), body.size());
+
+    static std::atomic<unsigned> written(0);
+    fs::path tempPath = snapshotPath;
+#ifndef _WIN32
+    tempPath += "." + std::to_string(getpid());
+#else
+    tempPath += "." + std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+#endif
+    tempPath += "." + std::to_string(written++) + ".tmp";
+    std::ofstream out(tempPath, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!out.is_open()) return;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(body.data(), static_cast<std::streamsize>(body.size()));
+    out.close();
+    std::error_code ec;
+    if (out.fail()) { fs::remove(tempPath, ec); return; }
+    fs::rename(tempPath, snapshotPath, ec); // Readers see the old snapshot or the new one
+    if (ec) fs::remove(tempPath, ec);
+}
+
+
+// --- String Interning ---
+StringPool& StringPool::instance() {
+    static StringPool pool;
+    return pool;
+}
+
+const char* StringPool::intern(const char* text, size_t length) {
+    std::string_view key(text, length);
+    std::unordered_map<std::string_view, uint32_t>::iterator it = ids.find(key);
+    if (it != ids.end()) return strings[it->second];
+    const char* copy = bytes.copyString(text, length);
+    ids.emplace(std::string_view(copy, length), static_cast<uint32_t>(strings.size()));
+    strings.push_back(copy);
+    return copy;
+}
+
+const char* StringPool::intern(const char* text) {
+    return text ? intern(text, strlen(text)) : intern("", 0);
+}
+
+const char* StringPool::find(const char* text) const {
+    std::unordered_map<std::string_view, uint32_t>::const_iterator it = ids.find(text ? text : "");
+    return it == ids.end() ? nullptr : strings[it->second];
+}
+
+uint32_t StringPool::idOf(const char* text) {
+    const char* interned = intern(text);
+    return ids.find(interned)->second;
+}
+
+// Shared, never-freed copy of 'cstr' for values that repeat (ids, statuses, names).
+const char* internString(const char* cstr) {
+    return StringPool::instance().intern(cstr);
+}
+
+// --- Table Schemas ---
+std::unordered_map<std::string, TableSchema*>& schemaRegistry() {
+    static std::unordered_map<std::string, TableSchema*> registry;
+    return registry;
+}
+
+TableSchema::TableSchema(const char* filenameWithExtension, const SchemaColumn* schemaColumns, int columnCount)
+    : file(filenameWithExtension), columns(schemaColumns), count(columnCount), positions(columnCount, -1),
+      boundFields(nullptr), boundCount(0), boundHash(0), complete(false), reported(false) {
+    schemaRegistry()[filenameWithExtension] = this;
+}
+
+TableSchema* TableSchema::find(const std::string& filenameWithExtension) {
+    std::unordered_map<std::string, TableSchema*>& registry = schemaRegistry();
+    std::unordered_map<std::string, TableSchema*>::iterator it = registry.find(filenameWithExtension);
+    return it == registry.end() ? nullptr : it->second;
+}
+
+uint32_t TableSchema::headerHash(char* const* headerFields, int headerCount) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; headerFields && i < headerCount; ++i) {
+        const char* name = headerFields[i] ? headerFields[i] : "";
+        hash = hashBytes(name, strlen(name) + 1, hash); // The NUL keeps "ab","c" apart from "a","bc"
+    }
+    return hash;
+}
+
+bool TableSchema::isBoundTo(char* const* headerFields, int headerCount) const {
+    return headerFields == boundFields && headerCount == boundCount && headerHash(headerFields, headerCount) == boundHash;
+}
+
+bool TableSchema::bind(char* const* headerFields, int headerCount, bool reportMissing) {
+    boundFields = headerFields;
+    boundCount = headerCount;
+    boundHash = headerHash(headerFields, headerCount);
+    complete = true;
+    for (int c = 0; c < count; ++c) {
+        positions[c] = -1;
+        for (int i = 0; headerFields && i < headerCount; ++i) {
+            if (headerFields[i] && strcmp(headerFields[i], columns[c].name) == 0) { positions[c] = i; break; }
+        }
+        if (positions[c] == -1) complete = false;
+    }
+    if (complete) {
+        reported = false;
+    } else if (reportMissing && headerFields && !reported) {
+        for (int c = 0; c < count; ++c) {
+            if (positions[c] == -1) std::cerr << "Error: " << file << " has no '" << columns[c].name << "' column." << std::endl;
+        }
+        reported = true;
+    }
+    return complete;
+}
+
+// Validates a freshly loaded table against its registered schema, if any.
+void checkTableSchema(const std::string& filenameWithExtension, const dataContainer2D& container) {
+    TableSchema* schema = TableSchema::find(filenameWithExtension);
+    if (schema && !container.error) schema->bind(container.fields, container.x, true);
+}
+
+// Also parses the columns of the file's registered schema into 'typed'; without
+// a schema, 'typed' is left empty.
+dataContainer2D getData(const std::string& filenameWithExtension, TypedColumns& typed) {
+    typed = TypedColumns();
+    std::vector<std::vector<int32_t>> snapshotInts;
+    dataContainer2D container = getData(filenameWithExtension, nullptr, &snapshotInts);
+    TableSchema* schema = TableSchema::find(filenameWithExtension);
+    if (schema && !container.error) buildTypedColumns(container, *schema, typed, &snapshotInts);
+    return container;
+}
+
+// Whole-cell int32 with optional surrounding spaces and '+'; false if anything else.
+bool parseInt32Cell(const char* text, int32_t& value) {
+    if (!text) return false;
+    while (*text == ' ') ++text;
+    size_t length = strlen(text);
+    while (length > 0 && text[length - 1] == ' ') --length;
+    if (length > 1 && text[0] == '+' && text[1] != '-') { ++text; --length; }
+    if (length == 0) return false;
+    int32_t parsed;
+    std::from_chars_result result = std::from_chars(text, text + length, parsed);
+    if (result.ec != std::errc() || result.ptr != text + length) return false;
+    value = parsed;
+    return true;
+}
+
+// COLUMN_INT columns that a snapshot already holds as int32 ('snapshotInts', by
+// file column) are taken from it instead of parsing their cells again.
+void buildTypedColumns(const dataContainer2D& data, TableSchema& schema, TypedColumns& typed,
+                       std::vector<std::vector<int32_t>>* snapshotInts) {
+    size_t rows = data.y > 0 ? static_cast<size_t>(data.y) : 0;
+    typed.schema = &schema;
+    typed.rows = static_cast<int>(rows);
+    typed.columns.assign(schema.columnCount(), TypedColumn());
+    for (int slot = 0; slot < schema.columnCount(); ++slot) {
+        TypedColumn& column = typed.columns[slot];
+        column.type = schema.column(slot).type;
+        column.present.assign(rows, 0);
+        int col = schema.position(slot, data.fields, data.x);
+        auto cellAt = [&](size_t i) -> const char* { return col >= 0 && data.data[i] ? data.data[i][col] : nullptr; };
+
+        switch (column.type) {
+            case COLUMN_INT:
+                if (col >= 0 && snapshotInts && static_cast<size_t>(col) < snapshotInts->size() &&
+                    (*snapshotInts)[col].size() == rows && rows > 0) {
+                    column.ints.swap((*snapshotInts)[col]); // Every cell of a snapshot int column is a plain int32
+                    column.present.assign(rows, 1);
+                    break;
+                }
+                column.ints.assign(rows, 0);
+                for (size_t i = 0; i < rows; ++i) column.present[i] = parseInt32Cell(cellAt(i), column.ints[i]);
+                break;
+            case COLUMN_FLOAT:
+            case COLUMN_DATE:
+            case COLUMN_TIME: {
+                bool isFloat = column.type == COLUMN_FLOAT;
+                if (isFloat) column.floats.assign(rows, 0.0f);
+                else column.ints.assign(rows, 0);
+                for (size_t i = 0; i < rows; ++i) {
+                    double value;
+                    if (!parseTypedValue(cellAt(i), column.type, value)) continue;
+                    column.present[i] = 1;
+                    if (isFloat) column.floats[i] = static_cast<float>(value);
+                    else column.ints[i] = static_cast<int32_t>(value);
+                }
+                break;
+            }
+            default: {
+                StringPool& pool = StringPool::instance();
+                column.type = COLUMN_STRING;
+                column.strings.assign(rows, pool.intern(""));
+                for (size_t i = 0; i < rows; ++i) {
+                    const char* cell = cellAt(i);
+                    if (!cell || cell[0] == '\0') continue;
+                    column.strings[i] = pool.intern(cell);
+                    column.present[i] = 1;
+                }
+                break;
+            }
+        }
+    }
+}
+
+template <typename Table, int Slot>
+const TypedColumn* typedColumn(const TypedColumns& typed, Column<Table, Slot>) {
+    return typed.schema == &Table::schema && Slot < static_cast<int>(typed.columns.size()) ? &typed.columns[Slot] : nullptr;
+}
+
+// Packed values of an int, date or time column; null if 'typed' is for another table.
+template <typename Table, int Slot>
+const int32_t* intColumn(const TypedColumns& typed, Column<Table, Slot> column) {
+    static_assert(Column<Table, Slot>::type == COLUMN_INT || Column<Table, Slot>::type == COLUMN_DATE ||
+                  Column<Table, Slot>::type == COLUMN_TIME, "intColumn reads int, date and time columns");
+    const TypedColumn* values = typedColumn(typed, column);
+    return values ? values->ints.data() : nullptr;
+}
+
+// Interned values of a string column: compare them by pointer against
+// internString(...) or StringPool::find(...).
+template <typename Table, int Slot>
+const char* const* stringColumn(const TypedColumns& typed, Column<Table, Slot> column) {
+    static_assert(Column<Table, Slot>::type == COLUMN_STRING, "stringColumn reads COLUMN_STRING columns");
+    const TypedColumn* values = typedColumn(typed, column);
+    return values ? values->strings.data() : nullptr;
+}
+
+template <typename Table, int Slot>
+const float* floatColumn(const TypedColumns& typed, Column<Table, Slot> column) {
+    static_assert(Column<Table, Slot>::type == COLUMN_FLOAT, "floatColumn reads COLUMN_FLOAT columns");
+    const TypedColumn* values = typedColumn(typed, column);
+    return values ? values->floats.data() : nullptr;
+}
+
+// Sorts by one schema column using its packed values, so no cell is parsed. The
+// order is the one sortDataContainerView gives for that column type. 'typed'
+// must come from the same getData call as 'data'.
+template <typename Table, int Slot>
+TableView sortDataContainerView(const dataContainer2D& data, const TypedColumns& typed, Column<Table, Slot> column, bool ascending) {
+    const TypedColumn* values = typedColumn(typed, column);
+    if (!values || typed.rows != data.y) {
+        SortKey key(column.name, ascending, Column<Table, Slot>::type);
+        return sortDataContainerView(data, &key, 1);
+    }
+
+    TableView sorted = viewOf(data);
+    if (sorted.error) return sorted;
+    int col = column.in(data);
+    bool isInt = !values->ints.empty();
+    bool isFloat = !values->floats.empty();
+    std::stable_sort(sorted.rows.begin(), sorted.rows.end(), [&](int a, int b) {
+        int cmp = 0;
+        if ((isInt || isFloat) && values->present[a] && values->present[b]) {
+            if (isInt) cmp = values->ints[a] < values->ints[b] ? -1 : (values->ints[b] < values->ints[a] ? 1 : 0);
+            else cmp = values->floats[a] < values->floats[b] ? -1 : (values->floats[b] < values->floats[a] ? 1 : 0);
+        } else if ((isInt || isFloat) && values->present[a] != values->present[b]) {
+            cmp = values->present[a] ? 1 : -1;
+        } else if (col >= 0) {
+            cmp = strcmp(data.data[a][col] ? data.data[a][col] : "", data.data[b][col] ? data.data[b][col] : "");
+        }
+        return ascending ? cmp < 0 : cmp > 0;
+    });
+    sorted.wholeTable = false;
+    return sorted;
+}
+
+// Cell of a schema column; "" when the header lacks the column or the row is missing.
+template <typename Table, int Slot>
+const char* cellText(const dataContainer2D& data, int row, Column<Table, Slot> column) {
+    int col = column.in(data);
+    const char* cell = col >= 0 && row >= 0 && row < data.y && data.data[row] ? data.data[row][col] : nullptr;
+    return cell ? cell : "";
+}
+
+// A view keeps the source's column order unless it was shortened, so that is tried first.
+template <typename Table, int Slot>
+const char* cellText(const TableView& view, int row, Column<Table, Slot> column) {
+    if (!view.source) return "";
+    int sourceCol = column.in(*view.source);
+    if (sourceCol < 0) return "";
+    if (sourceCol < view.x() && view.columns[sourceCol] == sourceCol) return view.cell(row, sourceCol);
+    for (int c = 0; c < view.x(); ++c) {
+        if (view.columns[c] == sourceCol) return view.cell(row, c);
+    }
+    return "";
+}
+
+template <typename Table, int Slot>
+const char* cellText(const CsvReader& reader, Column<Table, Slot> column) {
+    return reader.cell(column.in(reader));
+}
+
+template <typename Table, int Slot>
+int cellInt(const dataContainer2D& data, int row, Column<Table, Slot> column) {
+    static_assert(Column<Table, Slot>::type == COLUMN_INT, "cellInt reads COLUMN_INT columns");
+    return atoi(cellText(data, row, column));
+}
+
+template <typename Table, int Slot>
+int cellInt(const CsvReader& reader, Column<Table, Slot> column) {
+    static_assert(Column<Table, Slot>::type == COLUMN_INT, "cellInt reads COLUMN_INT columns");
+    return atoi(cellText(reader, column));
+}
+
+template <typename Table, int Slot>
+float cellFloat(const dataContainer2D& data, int row, Column<Table, Slot> column) {
+    static_assert(Column<Table, Slot>::type == COLUMN_FLOAT || Column<Table, Slot>::type == COLUMN_INT,
+                  "cellFloat reads numeric columns");
+    return static_cast<float>(atof(cellText(data, row, column)));
+}
+
+// --- Key Index ---
+uint32_t hashCell(const char* cell) {
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (const unsigned char* p = reinterpret_cast<const unsigned char*>(cell ? cell : ""); *p; ++p) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void KeyIndex::build(const dataContainer2D& table, int keyColumn) {
+    column = keyColumn;
+    count = 0;
+    size_t capacity = 16;
+    while (capacity < static_cast<size_t>(table.y) * 2) capacity <<= 1;
+    slots.assign(capacity, Slot{0, -1});
+    for (int i = 0; i < table.y; ++i) {
+        if (table.data[i]) insert(table, i);
+    }
+}
+
+void KeyIndex::insert(const dataContainer2D& table, int row) {
+    if ((count + 1) * 2 > slots.size()) { // Keep the load factor at or below 1/2
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.assign(old.size() * 2, Slot{0, -1});
+        count = 0;
+        for (const Slot& slot : old) {
+            if (slot.row >= 0) placeSlot(slot);
+        }
+    }
+    placeSlot(Slot{hashCell(table.data[row][column]), row});
+}
+
+void KeyIndex::placeSlot(const Slot& slot) {
+    size_t mask = slots.size() - 1;
+    size_t position = slot.hash & mask;
+    while (slots[position].row >= 0) position = (position + 1) & mask;
+    slots[position] = slot;
+    ++count;
+}
+
+// Backward-shift deletion keeps probe runs intact without tombstones. 'key' is
+// the value the row was indexed under (the cell may already hold a new value).
+void KeyIndex::erase(int row, const char* key) {
+    size_t mask = slots.size() - 1;
+    size_t position = hashCell(key) & mask;
+    while (slots[position].row >= 0 && slots[position].row != row) position = (position + 1) & mask;
+    if (slots[position].row < 0) return;
+
+    size_t hole = position;
+    size_t next = (hole + 1) & mask;
+    while (slots[next].row >= 0) {
+        size_t home = slots[next].hash & mask;
+        bool movable = (hole <= next) ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (movable) {
+            slots[hole] = slots[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    slots[hole] = Slot{0, -1};
+    --count;
+}
+
+// Rows whose key equals 'key', in ascending row order.
+void KeyIndex::find(const dataContainer2D& table, const char* key, std::vector<int>& rows) const {
+    rows.clear();
+    if (slots.empty() || !key) return;
+    uint32_t hash = hashCell(key);
+    size_t mask = slots.size() - 1;
+    for (size_t position = hash & mask; slots[position].row >= 0; position = (position + 1) & mask) {
+        const Slot& slot = slots[position];
+        const char* cell = table.data[slot.row][column];
+        if (slot.hash == hash && cell && strcmp(cell, key) == 0) rows.push_back(slot.row);
+    }
+    if (rows.size() > 1) std::sort(rows.begin(), rows.end());
+}
+
+int KeyIndex::findFirst(const dataContainer2D& table, const char* key) const {
+    std::vector<int> rows;
+    find(table, key, rows);
+    return rows.empty() ? -1 : rows.front();
+}
+
+KeyIndex* CachedTable::keyIndexFor(int column) {
+    if (column < 0 || column >= table.x) return nullptr;
+    for (KeyIndex& index : keyIndexes) {
+        if (index.column == column) return &index;
+    }
+    keyIndexes.emplace_back();
+    keyIndexes.back().build(table, column);
+    return &keyIndexes.back();
+}
+
+// Row ids shift after deletions, so every index is rebuilt from the compacted table.
+void CachedTable::rebuildIndexes() {
+    for (KeyIndex& index : keyIndexes) index.build(table, index.column);
+    for (SecondaryIndex& index : secondaryIndexes) index.build(table, index.columns);
+}
+
+// Replaces one cell and keeps every index on that column current.
+void CachedTable::setCell(int row, int col, const char* value) {
+    if (table.data[row][col] && value && strcmp(table.data[row][col], value) == 0) return;
+
+    KeyIndex* affected = nullptr;
+    for (KeyIndex& index : keyIndexes) {
+        if (index.column == col) affected = &index;
+    }
+    std::string previous = affected && table.data[row][col] ? table.data[row][col] : "";
+    std::vector<std::pair<SecondaryIndex*, std::string>> affectedSecondary;
+    for (SecondaryIndex& index : secondaryIndexes) {
+        if (std::find(index.columns.begin(), index.columns.end(), col) != index.columns.end()) {
+            affectedSecondary.emplace_back(&index, index.keyOfRow(table, row));
+        }
+    }
+
+    setCellValue(table, row, col, value);
+    if (affected) {
+        affected->erase(row, previous.c_str());
+        affected->insert(table, row);
+    }
+    for (auto& entry : affectedSecondary) {
+        entry.first->remove(row, entry.second);
+        entry.first->add(table, row);
+    }
+}
+
+// Adds a row that was just appended to the file. Cells are copied into the
+// table's arena; the row pointer array grows geometrically.
+void CachedTable::appendRow(const char* const* values) {
+    if (table.y >= rowCapacity) {
+        int newCapacity = rowCapacity < 8 ? 16 : rowCapacity * 2;
+        char*** grown = static_cast<char***>(table.arena->allocate(sizeof(char**) * newCapacity));
+        for (int i = 0; i < table.y; ++i) grown[i] = table.data[i];
+        table.data = grown;
+        rowCapacity = newCapacity;
+    }
+    char** row = static_cast<char**>(table.arena->allocate(sizeof(char*) * table.x));
+    for (int j = 0; j < table.x; ++j) row[j] = table.arena->copyString(values[j]);
+    table.data[table.y] = row;
+    ++table.y;
+    for (KeyIndex& index : keyIndexes) index.insert(table, table.y - 1);
+    for (SecondaryIndex& index : secondaryIndexes) index.add(table, table.y - 1);
+}
+
+// Drops rows (keeping the rest in order) and hands back where they were in the file.
+void CachedTable::removeRows(const std::vector<int>& rows, std::vector<RowExtent>& removedExtents) {
+    bool haveExtents = extentsKnown();
+    for (int i : rows) releaseRow(table, i);
+    int keptRowCount = 0;
+    for (int i = 0; i < table.y; ++i) {
+        if (table.data[i]) {
+            if (haveExtents) extents[keptRowCount] = extents[i];
+            table.data[keptRowCount++] = table.data[i];
+        } else if (haveExtents) {
+            removedExtents.push_back(extents[i]);
+        }
+    }
+    table.y = keptRowCount;
+    if (haveExtents) extents.resize(keptRowCount);
+    rebuildIndexes();
+}
+
+// --- Secondary Indexes ---
+std::string SecondaryIndex::keyOf(const char* value1, const char* value2) const {
+    std::string key = value1 ? value1 : "";
+    if (columns.size() > 1) {
+        key += '\0'; // Values never contain NUL, so the pair stays unambiguous
+        key += value2 ? value2 : "";
+    }
+    return key;
+}
+
+std::string SecondaryIndex::keyOfRow(const dataContainer2D& table, int row) const {
+    return keyOf(table.data[row][columns[0]], columns.size() > 1 ? table.data[row][columns[1]] : nullptr);
+}
+
+uint32_t SecondaryIndex::hashKey(const std::string& key) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void SecondaryIndex::build(const dataContainer2D& table, const std::vector<int>& indexColumns) {
+    columns = indexColumns;
+    distinct = 0;
+    buckets.assign(16, Bucket());
+    for (int i = 0; i < table.y; ++i) {
+        if (table.data[i]) add(table, i);
+    }
+}
+
+SecondaryIndex::Bucket& SecondaryIndex::bucketFor(const std::string& key) {
+    if ((distinct + 1) * 2 > buckets.size()) { // Grow on distinct values, not rows
+        std::vector<Bucket> old;
+        old.swap(buckets);
+        buckets.assign(old.size() * 2, Bucket());
+        size_t mask = buckets.size() - 1;
+        for (Bucket& bucket : old) {
+            if (!bucket.used) continue;
+            size_t position = bucket.hash & mask;
+            while (buckets[position].used) position = (position + 1) & mask;
+            buckets[position] = std::move(bucket);
+        }
+    }
+
+    uint32_t hash = hashKey(key);
+    size_t mask = buckets.size() - 1;
+    size_t position = hash & mask;
+    while (buckets[position].used && (buckets[position].hash != hash || buckets[position].key != key)) {
+        position = (position + 1) & mask;
+    }
+    Bucket& bucket = buckets[position];
+    if (!bucket.used) {
+        bucket.used = true;
+        bucket.hash = hash;
+        bucket.key = key;
+        ++distinct;
+    }
+    return bucket;
+}
+
+void SecondaryIndex::add(const dataContainer2D& table, int row) {
+    std::vector<int>& rows = bucketFor(keyOfRow(table, row)).rows;
+    if (rows.empty() || rows.back() < row) rows.push_back(row); // Loads and appends arrive in row order
+    else rows.insert(std::lower_bound(rows.begin(), rows.end(), row), row);
+}
+
+// Buckets are kept even when their list empties, so probe runs never break.
+void SecondaryIndex::remove(int row, const std::string& key) {
+    std::vector<int>& rows = bucketFor(key).rows;
+    auto found = std::lower_bound(rows.begin(), rows.end(), row);
+    if (found != rows.end() && *found == row) rows.erase(found);
+}
+
+const std::vector<int>* SecondaryIndex::find(const char* value1, const char* value2) const {
+    if (buckets.empty() || !value1 || (columns.size() > 1 && !value2)) return nullptr;
+    std::string key = keyOf(value1, value2);
+    uint32_t hash = hashKey(key);
+    size_t mask = buckets.size() - 1;
+    for (size_t position = hash & mask; buckets[position].used; position = (position + 1) & mask) {
+        if (buckets[position].hash == hash && buckets[position].key == key) return &buckets[position].rows;
+    }
+    return nullptr;
+}
+
+// Index over exactly (column1) or (column1, column2); nullptr when none was declared.
+// 'swapped' reports that a composite index matched with its columns reversed.
+const SecondaryIndex* CachedTable::secondaryIndexFor(int column1, int column2, bool* swapped) const {
+    if (swapped) *swapped = false;
+    for (const SecondaryIndex& index : secondaryIndexes) {
+        if (column2 < 0) {
+            if (index.columns.size() == 1 && index.columns[0] == column1) return &index;
+        } else if (index.columns.size() == 2) {
+            if (index.columns[0] == column1 && index.columns[1] == column2) return &index;
+            if (index.columns[0] == column2 && index.columns[1] == column1) {
+                if (swapped) *swapped = true;
+                return &index;
+            }
+        }
+    }
+    return nullptr;
+}
+
+// Builds the declared index unless the table lacks one of its fields.
+void CachedTable::addSecondaryIndex(const std::string& field1, const std::string& field2) {
+    std::vector<int> columns;
+    for (const std::string* field : {&field1, &field2}) {
+        if (field->empty()) continue;
+        int column = -1;
+        for (int i = 0; i < table.x; ++i) {
+            if (table.fields[i] && *field == table.fields[i]) { column = i; break; }
+        }
+        if (column < 0) return;
+        columns.push_back(column);
+    }
+    if (secondaryIndexFor(columns[0], columns.size() > 1 ? columns[1] : -1)) return;
+    secondaryIndexes.emplace_back();
+    secondaryIndexes.back().build(table, columns);
+}
+
+// Rows whose 'column' equals 'key', ascending. Uses a declared index, or the
+// key index when that column has one, otherwise scans.
+void CachedTable::matchingRows(int column, const char* key, std::vector<int>& rows) const {
+    rows.clear();
+    if (const SecondaryIndex* index = secondaryIndexFor(column)) {
+        if (const std::vector<int>* found = index->find(key)) rows = *found;
+        return;
+    }
+    for (const KeyIndex& index : keyIndexes) {
+        if (index.column == column) { index.find(table, key, rows); return; }
+    }
+    for (int i = 0; i < table.y; ++i) {
+        if (table.data[i] && table.data[i][column] && strcmp(table.data[i][column], key) == 0) rows.push_back(i);
+    }
+}
+
+// --- Table Cache ---
+CachedTable::~CachedTable() {
+    deleteDataContainer2D(table);
+}
+
+TableCache& TableCache::instance() {
+    static TableCache cache;
+    return cache;
+}
+
+// A row's text and line break; the rest of its span is filler. An unterminated
+// last row has no line break.
+size_t liveBytesIn(const RowExtent& extent) {
+    return std::min(extent.span, extent.length + 1);
+}
+
+// Reads the current mtime/size of a data file; false if it cannot be stat'ed.
+bool statDataFile(const std::string& filenameWithExtension, fs::file_time_type& modifiedAt, uintmax_t& fileSize) {
+    return DataStore::instance().statFile(filenameWithExtension, modifiedAt, fileSize);
+}
+
+std::shared_ptr<CachedTable> TableCache::acquire(const std::string& filenameWithExtension) {
+    TableWatcher& watcher = TableWatcher::instance();
+    watcher.poll();
+    auto found = tables_.find(filenameWithExtension);
+    if (found != tables_.end() && watcher.watching()) {
+        if (!found->second->stale) return found->second; // Only our own writes touched it
+        tables_.erase(found); // Another writer did: reload below
+        found = tables_.end();
+    }
+
+    fs::file_time_type modifiedAt;
+    uintmax_t fileSize = 0;
+    bool statOk = statDataFile(filenameWithExtension, modifiedAt, fileSize);
+    if (found != tables_.end()) { // Unwatched: the stamps are all there is to go on
+        if (statOk && found->second->modifiedAt == modifiedAt && found->second->fileSize == fileSize) return found->second;
+        tables_.erase(found); // Changed on disk (or gone): reload below
+    }
+
+    auto entry = std::make_shared<CachedTable>();
+    entry->filename = filenameWithExtension;
+    CsvLayout layout;
+    entry->table = getData(filenameWithExtension, &layout);
+    if (entry->table.error) return nullptr;
+    entry->extents.swap(layout.rows);
+    entry->crlf = layout.crlf;
+    size_t liveBytes = layout.dataStart;
+    for (const RowExtent& extent : entry->extents) liveBytes += liveBytesIn(extent);
+    entry->deadBytes = fileSize > liveBytes ? static_cast<size_t>(fileSize) - liveBytes : 0; // Blank lines, filler and row pointers
+    entry->modifiedAt = modifiedAt;
+    entry->fileSize = fileSize;
+    entry->rowCapacity = entry->table.y;
+    auto declared = declaredIndexes_.find(filenameWithExtension);
+    if (declared != declaredIndexes_.end()) {
+        for (const auto& fields : declared->second) entry->addSecondaryIndex(fields.first, fields.second);
+    }
+    if (statOk) tables_[filenameWithExtension] = entry; // Never cache something we cannot revalidate
+    return entry;
+}
+
+std::shared_ptr<CachedTable> TableCache::acquireForWrite(const std::string& filenameWithExtension) {
+    std::shared_ptr<CachedTable> entry = acquire(filenameWithExtension);
+    if (!entry) return entry;
+    auto found = tables_.find(filenameWithExtension);
+    // The map and 'entry' account for two references; anything more is a live view.
+    if (found != tables_.end() && found->second == entry && entry.use_count() > 2) {
+        entry = entry->clone();
+        found->second = entry;
+    }
+    return entry;
+}
+
+void TableCache::noteWrite(const std::string& filenameWithExtension, const dataContainer2D* written, bool roundTrips,
+                           const std::vector<RowExtent>* extents) {
+    auto found = tables_.find(filenameWithExtension);
+    if (found == tables_.end()) return;
+    if (roundTrips && written == &found->second->table &&
+        statDataFile(filenameWithExtension, found->second->modifiedAt, found->second->fileSize)) {
+        if (extents) found->second->extents = *extents;
+        else found->second->extents.clear();
+        found->second->deadBytes = 0;
+        return;
+    }
+    tables_.erase(found);
+}
+
+bool TableCache::beginAppend(const std::string& filenameWithExtension) {
+    auto found = tables_.find(filenameWithExtension);
+    if (found == tables_.end()) return false;
+
+    fs::file_time_type modifiedAt;
+    uintmax_t fileSize = 0;
+    if (!statDataFile(filenameWithExtension, modifiedAt, fileSize) ||
+        modifiedAt != found->second->modifiedAt || fileSize != found->second->fileSize || fileSize == 0) {
+        return false;
+    }
+
+    // A missing trailing newline would glue the new row onto the last line.
+    fs::path filePath;
+    if (resolveDataFilePath(filenameWithExtension, filePath) != 0) return false;
+    std::ifstream file(filePath, std::ios::binary);
+    file.seekg(-1, std::ios::end);
+    return file.good() && file.get() == '\n';
+}
+
+void TableCache::noteAppend(const std::string& filenameWithExtension, bool patchable, int numValues, const char* const* values) {
+    auto found = tables_.find(filenameWithExtension);
+    if (found == tables_.end()) return;
+    CachedTable& entry = *found->second;
+
+    bool roundTrips = patchable && entry.table.x > 1 && numValues == entry.table.x && entry.table.arena;
+
+    uintmax_t appendedAt = entry.fileSize;
+    if (roundTrips && statDataFile(filenameWithExtension, entry.modifiedAt, entry.fileSize)) {
+        if (entry.extentsKnown() && entry.fileSize > appendedAt) {
+            size_t span = static_cast<size_t>(entry.fileSize - appendedAt);
+            entry.extents.push_back(RowExtent{static_cast<size_t>(appendedAt), span - 1, span, static_cast<size_t>(appendedAt)});
+        } else {
+            entry.extents.clear();
+        }
+        entry.appendRow(values);
+        return;
+    }
+    tables_.erase(found);
+}
+
+std::shared_ptr<CachedTable> TableCache::current(const std::string& filenameWithExtension) {
+    TableWatcher& watcher = TableWatcher::instance();
+    watcher.poll();
+    auto found = tables_.find(filenameWithExtension);
+    if (found == tables_.end()) return nullptr;
+    if (watcher.watching()) return found->second->stale ? nullptr : found->second;
+    fs::file_time_type modifiedAt;
+    uintmax_t fileSize = 0;
+    if (!statDataFile(filenameWithExtension, modifiedAt, fileSize) ||
+        modifiedAt != found->second->modifiedAt || fileSize != found->second->fileSize) {
+        return nullptr;
+    }
+    return found->second;
+}
+
+void TableCache::restamp(const std::string& filenameWithExtension) {
+    auto found = tables_.find(filenameWithExtension);
+    if (found == tables_.end()) return;
+    if (!statDataFile(filenameWithExtension, found->second->modifiedAt, found->second->fileSize)) tables_.erase(found);
+}
+
+void TableCache::install(const std::string& filenameWithExtension, const std::shared_ptr<CachedTable>& entry) {
+    tables_[filenameWithExtension] = entry;
+}
+
+void TableCache::invalidate(const std::string& filenameWithExtension) {
+    tables_.erase(filenameWithExtension);
+}
+
+void TableCache::clear() {
+    tables_.clear();
+}
+
+void TableCache::markStale(const std::string& filenameWithExtension) {
+    auto found = tables_.find(filenameWithExtension);
+    if (found != tables_.end()) found->second->stale = true;
+}
+
+void TableCache::markAllStale() {
+    for (auto& entry : tables_) entry.second->stale = true;
+}
+
+void TableCache::declareIndex(const std::string& filenameWithExtension, const std::string& field1, const std::string& field2) {
+    std::vector<std::pair<std::string, std::string>>& declared = declaredIndexes_[filenameWithExtension];
+    for (const auto& fields : declared) {
+        if (fields.first == field1 && fields.second == field2) return;
+    }
+    declared.emplace_back(field1, field2);
+
+    auto found = tables_.find(filenameWithExtension);
+    if (found != tables_.end()) found->second->addSecondaryIndex(field1, field2);
+}
+
+std::shared_ptr<CachedTable> TableCache::findByTable(const dataContainer2D* table) const {
+    for (const auto& entry : tables_) {
+        if (&entry.second->table == table) return entry.second;
+    }
+    return nullptr;
+}
+
+// Declared indexes are built whenever the table is cached and kept current by
+// the toolkit's own updates; Search1FieldValue, Search2FieldValue and
+// filterDataContainer (on a cached table) use them automatically.
+void declareSecondaryIndex(const std::string& filenameWithExtension, const char* fieldName) {
+    if (!fieldName) return;
+    TableCache::instance().declareIndex(filenameWithExtension, fieldName, "");
+}
+
+void declareCompositeIndex(const std::string& filenameWithExtension, const char* field1, const char* field2) {
+    if (!field1 || !field2) return;
+    TableCache::instance().declareIndex(filenameWithExtension, field1, field2);
+}
+
+
+// --- Change Tracking ---
+TableWatcher& TableWatcher::instance() {
+    static TableWatcher watcher;
+    return watcher;
+}
+
+TableWatcher::TableWatcher() : fd_(-1), watch_(-1), epoch_(0) {
+    watch(DataStore::instance().root());
+}
+
+TableWatcher::~TableWatcher() {
+    stop();
+}
+
+void TableWatcher::stop() {
+#ifdef __linux__
+    if (fd_ >= 0) ::close(fd_);
+#endif
+    fd_ = -1;
+    watch_ = -1;
+}
+
+void TableWatcher::watch(const fs::path& dataDir) {
+    stop();
+    ++epoch_;
+    TableCache::instance().markAllStale(); // Anything could have changed while unwatched
+#ifdef __linux__
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) return;
+    // Every way a file's bytes or identity can change: in-place writes, renames
+    // over it (writeData's temp file), deletes and re-creates, touch.
+    uint32_t mask = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE |
+                    IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+    watch_ = inotify_add_watch(fd_, dataDir.c_str(), mask);
+    if (watch_ < 0) stop(); // Not there yet, or out of watches: fall back to stat
+#else
+    (void)dataDir;
+#endif
+}
+
+void TableWatcher::poll() {
+#ifdef __linux__
+    if (fd_ < 0) return;
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t length = ::read(fd_, buffer, sizeof(buffer));
+        if (length <= 0) return; // EAGAIN once drained
+        for (ssize_t at = 0; at < length; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer + at);
+            at += sizeof(struct inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) { // Events were dropped; trust nothing
+                ++epoch_;
+                TableCache::instance().markAllStale();
+            } else if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                stop(); // The directory itself went away; every use stats again
+                ++epoch_;
+                TableCache::instance().markAllStale();
+                return;
+            } else if (event->len > 0) {
+                markChanged(event->name);
+            }
+        }
+    }
+#endif
+}
+
+void TableWatcher::markChanged(const std::string& filenameWithExtension) {
+    ++changes_[filenameWithExtension];
+    if (ownWrites_.count(filenameWithExtension) == 0) TableCache::instance().markStale(filenameWithExtension);
+}
+
+void TableWatcher::beginOwnWrite(const std::string& filenameWithExtension) {
+    poll();
+    ++ownWrites_[filenameWithExtension];
+}
+
+void TableWatcher::endOwnWrite(const std::string& filenameWithExtension) {
+    poll();
+    auto found = ownWrites_.find(filenameWithExtension);
+    if (found != ownWrites_.end() && --found->second <= 0) ownWrites_.erase(found);
+}
+
+uint64_t TableWatcher::generation(const std::string& filenameWithExtension) const {
+    auto found = changes_.find(filenameWithExtension);
+    return epoch_ + (found == changes_.end() ? 0 : found->second);
+}
+
+// True if the file may differ from when 'seen' was last updated by this call
+// (always on the first call), and records its current version in 'seen'. For
+// consumers that keep results derived from a file: while the directory is
+// watched, an unchanged file costs no system call, and any event for it, the
+// toolkit's own writes included, counts as a change. So does a write this
+// process has logged but not yet applied to the file.
+bool fileChangedSince(const std::string& filenameWithExtension, FileVersion& seen) {
+    TableWatcher& watcher = TableWatcher::instance();
+    watcher.poll();
+    uint64_t generation = watcher.generation(filenameWithExtension);
+    uint64_t logged = WriteAheadLog::instance().loggedGroups(filenameWithExtension);
+    bool logChanged = logged != seen.logged;
+    seen.logged = logged;
+    if (seen.known && watcher.watching() && generation == seen.generation && !logChanged) return false;
+
+    fs::file_time_type modifiedAt;
+    uintmax_t fileSize = 0;
+    bool statOk = statDataFile(filenameWithExtension, modifiedAt, fileSize);
+    bool changed = !seen.known || !statOk || watcher.watching() || logChanged || modifiedAt != seen.modifiedAt || fileSize != seen.fileSize;
+    seen.known = statOk;
+    seen.generation = generation;
+    seen.modifiedAt = modifiedAt;
+    seen.fileSize = fileSize;
+    return changed;
+}
+
+// --- Table Views ---
+const char* TableView::field(int col) const {
+    const char* name = source->fields[columns[col]];
+    return name ? name : "";
+}
+
+const char* TableView::cell(int row, int col) const {
+    char** sourceRow = source->data[rows[row]];
+    const char* value = sourceRow ? sourceRow[columns[col]] : nullptr;
+    return value ? value : "";
+}
+
+// Owning, arena-backed copy of just the rows and columns in the view.
+dataContainer2D TableView::materialize() const {
+    dataContainer2D out;
+    if (error || !source) { out.error = 1; return out; }
+
+    out.arena = new CellArena();
+    out.x = x();
+    out.y = y();
+    out.fields = out.x > 0 ? static_cast<char**>(out.arena->allocate(sizeof(char*) * out.x)) : nullptr;
+    for (int j = 0; j < out.x; ++j) out.fields[j] = out.arena->copyString(field(j));
+
+    if (out.y > 0) {
+        out.data = static_cast<char***>(out.arena->allocate(sizeof(char**) * out.y));
+        for (int i = 0; i < out.y; ++i) {
+            out.data[i] = static_cast<char**>(out.arena->allocate(sizeof(char*) * (out.x > 0 ? out.x : 1)));
+            for (int j = 0; j < out.x; ++j) out.data[i][j] = out.arena->copyString(cell(i, j));
+        }
+    }
+    return out;
+}
+
+TableView wholeTableView(const dataContainer2D& data) {
+    TableView view;
+    if (data.error) { view.error = 1; return view; }
+    view.source = &data;
+    view.wholeTable = true;
+    view.rows.resize(data.y > 0 ? data.y : 0);
+    for (int i = 0; i < data.y; ++i) view.rows[i] = i;
+    view.columns.resize(data.x > 0 ? data.x : 0);
+    for (int j = 0; j < data.x; ++j) view.columns[j] = j;
+    return view;
+}
+
+// View over every row of 'data'. Cached tables are kept alive by the view.
+TableView viewOf(const dataContainer2D& data) {
+    TableView view = wholeTableView(data);
+    view.keepAlive = TableCache::instance().findByTable(&data);
+    return view;
+}
+
+// Every row of a data file's cached table, loaded or reloaded as needed. The
+// view keeps the table alive; if the file cannot be read, error is set and
+// source points to an empty table whose error is set too.
+TableView tableView(const std::string& filenameWithExtension) {
+    static const dataContainer2D unreadable = [] { dataContainer2D empty; empty.error = 1; return empty; }();
+    std::shared_ptr<CachedTable> cached = TableCache::instance().acquire(filenameWithExtension);
+    if (!cached) {
+        TableView view;
+        view.error = 1;
+        view.source = &unreadable;
+        return view;
+    }
+    TableView view = wholeTableView(cached->table);
+    view.keepAlive = cached;
+    return view;
+}
+
+// Source column behind a view column named 'field', or -1.
+int viewColumnOf(const TableView& view, const char* field) {
+    for (int j = 0; j < view.x(); ++j) {
+        if (strcmp(view.field(j), field) == 0) return j;
+    }
+    return -1;
+}
+
+std::shared_ptr<CachedTable> CachedTable::clone() const {
+    auto copy = std::make_shared<CachedTable>();
+    copy->filename = filename;
+    copy->modifiedAt = modifiedAt;
+    copy->fileSize = fileSize;
+    copy->table = wholeTableView(table).materialize();
+    copy->rowCapacity = copy->table.y;
+    copy->extents = extents;
+    copy->deadBytes = deadBytes;
+    copy->crlf = crlf;
+    copy->stale = stale;
+    for (const KeyIndex& index : keyIndexes) copy->keyIndexFor(index.column);
+    for (const SecondaryIndex& index : secondaryIndexes) {
+        copy->secondaryIndexes.emplace_back();
+        copy->secondaryIndexes.back().build(copy->table, index.columns);
+    }
+    return copy;
+}
+
+TableView filterDataContainerView(const TableView& in, const char* field, const char* key) {
+    TableView out;
+    if (in.error) { out.error = 1; std::cerr << "Error: Input for filter has error." << std::endl; return out; }
+    if (!field || !key) { out.error = 1; std::cerr << "Error: Null field/key for filter." << std::endl; return out; }
+
+    int wantedColumn = viewColumnOf(in, field);
+    if (wantedColumn == -1) {
+        out.error = 1; std::cerr << "Error: Field '" << field << "' not found for filter." << std::endl; return out;
+    }
+
+    out.keepAlive = in.keepAlive;
+    out.source = in.source;
+    out.columns = in.columns;
+    if (in.wholeTable && in.keepAlive) { // Whole cached table: a declared index can answer directly
+        in.keepAlive->matchingRows(in.columns[wantedColumn], key, out.rows);
+        return out;
+    }
+    for (int i = 0; i < in.y(); ++i) {
+        char** sourceRow = in.source->data[in.rows[i]];
+        const char* value = sourceRow ? sourceRow[in.columns[wantedColumn]] : nullptr;
+        if (value && strcmp(value, key) == 0) out.rows.push_back(in.rows[i]);
+    }
+    return out;
+}
+
+TableView filterDataContainerView(const dataContainer2D& dataIn, const char* field, const char* key) {
+    return filterDataContainerView(viewOf(dataIn), field, key);
+}
+
+TableView shortenDataContainerView(const TableView& in, const char* wantedFields[], int numWantedFields) {
+    TableView out;
+    if (in.error) { out.error = 1; std::cerr << "Error: Input for shorten has error." << std::endl; return out; }
+    if (numWantedFields <= 0 || !wantedFields) {
+        out.error = 1; std::cerr << "Error: No/invalid fields for shorten." << std::endl; return out;
+    }
+
+    for (int i = 0; i < numWantedFields; ++i) {
+        if (!wantedFields[i]) {
+            out.error = 1; std::cerr << "Error: Null field name in wantedFields at index " << i << std::endl; return out;
+        }
+        int column = viewColumnOf(in, wantedFields[i]);
+        if (column == -1) {
+            out.error = 1; std::cerr << "Error: Wanted field '" << wantedFields[i] << "' not found." << std::endl; return out;
+        }
+        out.columns.push_back(in.columns[column]);
+    }
+    out.keepAlive = in.keepAlive;
+    out.source = in.source;
+    out.rows = in.rows;
+    return out;
+}
+
+TableView shortenDataContainerView(const dataContainer2D& dataIn, const char* wantedFields[], int numWantedFields) {
+    return shortenDataContainerView(viewOf(dataIn), wantedFields, numWantedFields);
+}
+
+TableView Search1FieldValueView(const std::string& filenameWithExtension, const char* fieldName, const char* dataToMatch) {
+    TableView result;
+    std::shared_ptr<CachedTable> cached = TableCache::instance().acquire(filenameWithExtension);
+    if (!cached || !fieldName || !dataToMatch) {
+        std::cerr << "Search1FieldValue: Error loading data or invalid arguments.\n";
+        result.error = 1;
+        return result;
+    }
+
+    TableView whole = wholeTableView(cached->table);
+    whole.keepAlive = cached;
+    if (viewColumnOf(whole, fieldName) == -1) {
+        std::cerr << "Search1FieldValue: Field '" << fieldName << "' not found.\n";
+        result.error = 1;
+        return result;
+    }
+    return filterDataContainerView(whole, fieldName, dataToMatch);
+}
+
+TableView Search2FieldValueView(const std::string& file, const char* field1, const char* key1, const char* field2, const char* key2) {
+    TableView result;
+    std::shared_ptr<CachedTable> cached = TableCache::instance().acquire(file);
+    if (!cached) { result.error = 1; return result; }
+    const dataContainer2D& full = cached->table;
+
+    int index1 = -1, index2 = -1;
+    for (int i = 0; i < full.x; ++i) {
+        if (strcmp(full.fields[i], field1) == 0) index1 = i;
+        if (strcmp(full.fields[i], field2) == 0) index2 = i;
+    }
+    if (index1 == -1 || index2 == -1) { result.error = 1; return result; }
+
+    result = wholeTableView(full);
+    result.keepAlive = cached;
+    result.wholeTable = false;
+    result.rows.clear();
+
+    // Prefer a composite index on the pair, then a single-column index on either
+    // field (checking the other per row), then a full scan.
+    bool swapped = false;
+    if (const SecondaryIndex* composite = cached->secondaryIndexFor(index1, index2, &swapped)) {
+        const std::vector<int>* found = swapped ? composite->find(key2, key1) : composite->find(key1, key2);
+        if (found) result.rows = *found;
+    } else {
+        int scanColumn = cached->secondaryIndexFor(index2) && !cached->secondaryIndexFor(index1) ? index2 : index1;
+        int checkColumn = scanColumn == index1 ? index2 : index1;
+        const char* checkKey = scanColumn == index1 ? key2 : key1;
+        cached->matchingRows(scanColumn, scanColumn == index1 ? key1 : key2, result.rows);
+        result.rows.erase(std::remove_if(result.rows.begin(), result.rows.end(), [&](int i) {
+            return strcmp(full.data[i][checkColumn], checkKey) != 0;
+        }), result.rows.end());
+    }
+    return result;
+}
+
+// --- Sorting ---
+// Parses 'text' as a 'type' value into a number that orders the same way the
+// values do (dates as yyyymmdd, times as seconds). False if it is not one.
+bool parseTypedValue(const char* text, ColumnType type, double& value) {
+    if (!text) return false;
+    while (*text == ' ') ++text;
+    size_t length = strlen(text);
+    while (length > 0 && text[length - 1] == ' ') --length;
+    if (length == 0) return false;
+
+    // Reads an unsigned run of 1..maxDigits digits.
+    auto readNumber = [&](size_t& pos, int maxDigits, long& out) {
+        size_t start = pos;
+        out = 0;
+        while (pos < length && std::isdigit(static_cast<unsigned char>(text[pos])) && pos - start < static_cast<size_t>(maxDigits)) {
+            out = out * 10 + (text[pos] - '0');
+            ++pos;
+        }
+        return pos > start;
+    };
+
+    switch (type) {
+        case COLUMN_INT: {
+            size_t pos = (text[0] == '-' || text[0] == '+') ? 1 : 0;
+            if (pos == length) return false;
+            for (size_t i = pos; i < length; ++i) {
+                if (!std::isdigit(static_cast<unsigned char>(text[i]))) return false;
+            }
+            value = std::strtod(std::string(text, length).c_str(), nullptr);
+            return true;
+        }
+        case COLUMN_FLOAT: {
+            if (strspn(text, "+-.0123456789eE") < length) return false; // No hex, inf or nan
+            std::string number(text, length);
+            char* end = nullptr;
+            value = std::strtod(number.c_str(), &end);
+            return end == number.c_str() + number.size() && std::isfinite(value);
+        }
+        case COLUMN_DATE: { // YYYY-MM-DD
+            size_t pos = 0;
+            long year, month, day;
+            if (!readNumber(pos, 4, year) || pos != 4 || pos >= length || text[pos++] != '-') return false;
+            if (!readNumber(pos, 2, month) || pos >= length || text[pos++] != '-') return false;
+            if (!readNumber(pos, 2, day) || pos != length) return false;
+            if (month < 1 || month > 12 || day < 1 || day > 31) return false;
+            value = static_cast<double>(year * 10000 + month * 100 + day);
+            return true;
+        }
+        case COLUMN_TIME: { // H:MM or H:MM:SS
+            size_t pos = 0;
+            long hours, minutes, seconds = 0;
+            if (!readNumber(pos, 2, hours) || pos >= length || text[pos++] != ':') return false;
+            size_t minutesStart = pos;
+            if (!readNumber(pos, 2, minutes) || pos - minutesStart != 2 || minutes > 59) return false;
+            if (pos < length) {
+                if (text[pos++] != ':') return false;
+                size_t secondsStart = pos;
+                if (!readNumber(pos, 2, seconds) || pos - secondsStart != 2 || seconds > 59) return false;
+            }
+            if (pos != length) return false;
+            value = static_cast<double>(hours * 3600 + minutes * 60 + seconds);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// The narrowest type every non-empty cell of a view column parses as; string
+// if there are none or they do not agree.
+ColumnType inferColumnType(const TableView& view, int col) {
+    bool canInt = true, canFloat = true, canDate = true, canTime = true, sawValue = false;
+    double ignored;
+    for (int i = 0; i < view.y() && (canInt || canFloat || canDate || canTime); ++i) {
+        const char* value = view.cell(i, col);
+        if (value[strspn(value, " ")] == '\0') continue;
+        sawValue = true;
+        if (canInt) canInt = parseTypedValue(value, COLUMN_INT, ignored);
+        if (canFloat) canFloat = parseTypedValue(value, COLUMN_FLOAT, ignored);
+        if (canDate) canDate = parseTypedValue(value, COLUMN_DATE, ignored);
+        if (canTime) canTime = parseTypedValue(value, COLUMN_TIME, ignored);
+    }
+    if (!sawValue) return COLUMN_STRING;
+    if (canInt) return COLUMN_INT;
+    if (canFloat) return COLUMN_FLOAT;
+    if (canDate) return COLUMN_DATE;
+    if (canTime) return COLUMN_TIME;
+    return COLUMN_STRING;
+}
+
+// Stable merge sort of the view's row permutation. Typed keys are parsed once up
+// front; cells that are empty or do not parse order before all others (ascending)
+// and among themselves by their text.
+TableView orderViewRows(const TableView& in, const std::vector<int>& keyColumns, const SortKey keys[]) {
+    struct ParsedKey {
+        int column;
+        bool ascending;
+        bool typed;
+        std::vector<double> values;
+        std::vector<char> present;
+    };
+
+    int numKeys = static_cast<int>(keyColumns.size());
+    std::vector<ParsedKey> parsed(numKeys);
+    for (int k = 0; k < numKeys; ++k) {
+        ParsedKey& key = parsed[k];
+        key.column = keyColumns[k];
+        key.ascending = keys[k].ascending;
+        ColumnType type = keys[k].type == COLUMN_AUTO ? inferColumnType(in, key.column) : keys[k].type;
+        key.typed = type != COLUMN_STRING;
+        if (!key.typed) continue;
+        key.values.resize(in.y());
+        key.present.resize(in.y());
+        for (int i = 0; i < in.y(); ++i) key.present[i] = parseTypedValue(in.cell(i, key.column), type, key.values[i]);
+    }
+
+    std::vector<int> order(in.y());
+    for (int i = 0; i < in.y(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        for (const ParsedKey& key : parsed) {
+            int cmp = 0;
+            if (key.typed && key.present[a] && key.present[b]) {
+                cmp = key.values[a] < key.values[b] ? -1 : (key.values[b] < key.values[a] ? 1 : 0);
+            } else if (key.typed && key.present[a] != key.present[b]) {
+                cmp = key.present[a] ? 1 : -1;
+            } else {
+                cmp = strcmp(in.cell(a, key.column), in.cell(b, key.column));
+            }
+            if (cmp != 0) return key.ascending ? cmp < 0 : cmp > 0;
+        }
+        return false;
+    });
+
+    TableView sorted = in;
+    sorted.wholeTable = false;
+    for (int i = 0; i < in.y(); ++i) sorted.rows[i] = in.rows[order[i]];
+    return sorted;
+}
+
+TableView sortDataContainerView(const TableView& in, const SortKey keys[], int numKeys) {
+    TableView sorted;
+    if (in.error || !in.source || in.x() == 0 || in.y() == 0 || !keys || numKeys <= 0) {
+        std::cerr << "Error: Invalid data container.\n";
+        sorted.error = 1;
+        return sorted;
+    }
+    std::vector<int> keyColumns(numKeys);
+    for (int k = 0; k < numKeys; ++k) {
+        keyColumns[k] = keys[k].field ? viewColumnOf(in, keys[k].field) : -1;
+        if (keyColumns[k] == -1) {
+            std::cerr << "Error: Field '" << (keys[k].field ? keys[k].field : "") << "' not found.\n";
+            sorted.error = 1;
+            return sorted;
+        }
+    }
+    return orderViewRows(in, keyColumns, keys);
+}
+
+TableView sortDataContainerView(const dataContainer2D& data, const SortKey keys[], int numKeys) {
+    return sortDataContainerView(viewOf(data), keys, numKeys);
+}
+
+dataContainer2D sortDataContainer(const dataContainer2D& data, const SortKey keys[], int numKeys) {
+    return sortDataContainerView(data, keys, numKeys).materialize();
+}
+
+TableView SortByFieldNameView(const TableView& in, const char* fieldName, bool ascending) {
+    SortKey key(fieldName, ascending);
+    return sortDataContainerView(in, &key, 1);
+}
+
+TableView SortByFieldNameView(const dataContainer2D& data, const char* fieldName, bool ascending) {
+    return SortByFieldNameView(viewOf(data), fieldName, ascending);
+}
+
+TableView sortByTwoFieldsView(const TableView& in, const char* primaryField, const char* secondaryField, bool ascending) {
+    TableView sorted;
+    if (in.error || !in.source || in.x() == 0 || in.y() == 0) {
+        std::cerr << "Error: Invalid data container.\n";
+        sorted.error = 1;
+        return sorted;
+    }
+    int primaryColumn = -1, secondaryColumn = -1;
+    for (int j = 0; j < in.x(); ++j) {
+        if (strcmp(in.field(j), primaryField) == 0) primaryColumn = j;
+        if (strcmp(in.field(j), secondaryField) == 0) secondaryColumn = j;
+    }
+    if (primaryColumn == -1 || secondaryColumn == -1) {
+        std::cerr << "Error: One or both fields not found.\n";
+        sorted.error = 1;
+        return sorted;
+    }
+
+    SortKey keys[2] = { SortKey(primaryField, ascending), SortKey(secondaryField, ascending) };
+    return orderViewRows(in, { primaryColumn, secondaryColumn }, keys);
+}
+
+TableView sortByTwoFieldsView(const dataContainer2D& data, const char* primaryField, const char* secondaryField, bool ascending) {
+    return sortByTwoFieldsView(viewOf(data), primaryField, secondaryField, ascending);
+}
+
+
+// --- Joins ---
+const char* JoinView::field(int col) const {
+    return col < left.x() ? left.field(col) : right.field(col - left.x());
+}
+
+const char* JoinView::cell(int row, int col) const {
+    const char* value = nullptr;
+    if (col < left.x()) {
+        char** sourceRow = left.source->data[leftRows[row]];
+        value = sourceRow ? sourceRow[left.columns[col]] : nullptr;
+    } else {
+        if (rightRows[row] < 0) return "-";
+        char** sourceRow = right.source->data[rightRows[row]];
+        value = sourceRow ? sourceRow[right.columns[col - left.x()]] : nullptr;
+    }
+    return value ? value : "";
+}
+
+// Owning, arena-backed copy of the joined rows; unmatched right cells share one "-".
+dataContainer2D JoinView::materialize() const {
+    dataContainer2D out;
+    if (error || !left.source || !right.source) { out.error = 1; return out; }
+
+    out.arena = new CellArena();
+    out.x = x();
+    out.y = y();
+    out.fields = out.x > 0 ? static_cast<char**>(out.arena->allocate(sizeof(char*) * out.x)) : nullptr;
+    for (int j = 0; j < out.x; ++j) out.fields[j] = out.arena->copyString(field(j));
+
+    if (out.y > 0) {
+        char* unmatched = out.arena->copyString("-");
+        out.data = static_cast<char***>(out.arena->allocate(sizeof(char**) * out.y));
+        for (int i = 0; i < out.y; ++i) {
+            out.data[i] = static_cast<char**>(out.arena->allocate(sizeof(char*) * (out.x > 0 ? out.x : 1)));
+            for (int j = 0; j < out.x; ++j) {
+                out.data[i][j] = (j >= left.x() && rightRows[i] < 0) ? unmatched : out.arena->copyString(cell(i, j));
+            }
+        }
+    }
+    return out;
+}
+
+// Hash of a row's key cells (source row/column ids); false if any is missing,
+// as a missing key matches nothing.
+bool joinKeyHash(const dataContainer2D& table, int row, const std::vector<int>& keyColumns, uint32_t& hash) {
+    char** cells = table.data[row];
+    if (!cells) return false;
+    hash = 2166136261u;
+    for (int column : keyColumns) {
+        if (!cells[column]) return false;
+        hash = (hash ^ hashCell(cells[column])) * 16777619u;
+    }
+    return true;
+}
+
+bool joinKeysEqual(const dataContainer2D& a, int rowA, const std::vector<int>& columnsA,
+                   const dataContainer2D& b, int rowB, const std::vector<int>& columnsB) {
+    for (size_t k = 0; k < columnsA.size(); ++k) {
+        if (strcmp(a.data[rowA][columnsA[k]], b.data[rowB][columnsB[k]]) != 0) return false;
+    }
+    return true;
+}
+
+// Equi-join on one or more key columns. The smaller side is hashed and the other
+// probes it once, so the cost is linear in both sizes plus the result.
+JoinView joinDataContainerView(const TableView& left, const TableView& right, const char* leftKeys[], const char* rightKeys[], int numKeys, JoinType type) {
+    JoinView out;
+    if (left.error || right.error) {
+        out.error = 1; std::cerr << "Error: Input data for join has error." << std::endl; return out;
+    }
+    if (numKeys <= 0 || !leftKeys || !rightKeys) {
+        out.error = 1; std::cerr << "Error: No/invalid key fields for join." << std::endl; return out;
+    }
+
+    std::vector<int> leftKeyColumns, rightKeyColumns, rightKeyViewColumns;
+    for (int k = 0; k < numKeys; ++k) {
+        if (!leftKeys[k] || !rightKeys[k]) {
+            out.error = 1; std::cerr << "Error: Null key field for join at index " << k << std::endl; return out;
+        }
+        int leftColumn = viewColumnOf(left, leftKeys[k]);
+        if (leftColumn == -1) {
+            out.error = 1; std::cerr << "Error: Join key '" << leftKeys[k] << "' not in left data." << std::endl; return out;
+        }
+        int rightColumn = viewColumnOf(right, rightKeys[k]);
+        if (rightColumn == -1) {
+            out.error = 1; std::cerr << "Error: Join key '" << rightKeys[k] << "' not in right data." << std::endl; return out;
+        }
+        leftKeyColumns.push_back(left.columns[leftColumn]);
+        rightKeyColumns.push_back(right.columns[rightColumn]);
+        rightKeyViewColumns.push_back(rightColumn);
+    }
+
+    out.left.keepAlive = left.keepAlive;
+    out.left.source = left.source;
+    out.left.columns = left.columns;
+    out.right.keepAlive = right.keepAlive;
+    out.right.source = right.source;
+    if (type != JOIN_ANTI) {
+        for (int j = 0; j < right.x(); ++j) {
+            if (std::find(rightKeyViewColumns.begin(), rightKeyViewColumns.end(), j) == rightKeyViewColumns.end()) {
+                out.right.columns.push_back(right.columns[j]);
+            }
+        }
+    }
+
+    // Chained hash table over the build side's view rows: heads[bucket] is the
+    // first row, next[row] the one after it, each chain in ascending view order.
+    bool buildLeft = left.y() < right.y();
+    const TableView& build = buildLeft ? left : right;
+    const TableView& probe = buildLeft ? right : left;
+    const std::vector<int>& buildKeyColumns = buildLeft ? leftKeyColumns : rightKeyColumns;
+    const std::vector<int>& probeKeyColumns = buildLeft ? rightKeyColumns : leftKeyColumns;
+
+    size_t capacity = 16;
+    while (capacity < static_cast<size_t>(build.y()) * 2) capacity <<= 1;
+    size_t mask = capacity - 1;
+    std::vector<int> heads(capacity, -1);
+    std::vector<int> next(build.y(), -1);
+    std::vector<uint32_t> hashes(build.y(), 0);
+    for (int i = build.y() - 1; i >= 0; --i) {
+        if (!joinKeyHash(*build.source, build.rows[i], buildKeyColumns, hashes[i])) continue;
+        next[i] = heads[hashes[i] & mask];
+        heads[hashes[i] & mask] = i;
+    }
+
+    if (!buildLeft) { // Probing in left order emits rows in their final order
+        for (int p = 0; p < left.y(); ++p) {
+            int leftRow = left.rows[p];
+            bool matched = false;
+            uint32_t hash;
+            if (joinKeyHash(*left.source, leftRow, leftKeyColumns, hash)) {
+                for (int i = heads[hash & mask]; i != -1; i = next[i]) {
+                    if (hashes[i] != hash || !joinKeysEqual(*right.source, right.rows[i], rightKeyColumns, *left.source, leftRow, leftKeyColumns)) continue;
+                    matched = true;
+                    if (type == JOIN_ANTI) break;
+                    out.leftRows.push_back(leftRow);
+                    out.rightRows.push_back(right.rows[i]);
+                }
+            }
+            if (!matched && type != JOIN_INNER) {
+                out.leftRows.push_back(leftRow);
+                out.rightRows.push_back(-1);
+            }
+        }
+        return out;
+    }
+
+    // Left side hashed: gather matches per left view row while probing in right
+    // order, then emit left rows in order (a counting sort, so still linear).
+    std::vector<int> matchCount(left.y(), 0);
+    std::vector<std::pair<int, int>> matches; // (left view row, right view row)
+    for (int p = 0; p < probe.y(); ++p) {
+        uint32_t hash;
+        if (!joinKeyHash(*probe.source, probe.rows[p], probeKeyColumns, hash)) continue;
+        for (int i = heads[hash & mask]; i != -1; i = next[i]) {
+            if (hashes[i] != hash || !joinKeysEqual(*left.source, left.rows[i], leftKeyColumns, *probe.source, probe.rows[p], probeKeyColumns)) continue;
+            ++matchCount[i];
+            if (type != JOIN_ANTI) matches.emplace_back(i, p);
+        }
+    }
+    std::vector<int> firstMatch(left.y() + 1, 0);
+    for (int i = 0; i < left.y(); ++i) firstMatch[i + 1] = firstMatch[i] + (type == JOIN_ANTI ? 0 : matchCount[i]);
+    std::vector<int> matchedRight(matches.size());
+    std::vector<int> fill(firstMatch.begin(), firstMatch.end() - 1);
+    for (const std::pair<int, int>& match : matches) matchedRight[fill[match.first]++] = match.second;
+
+    for (int i = 0; i < left.y(); ++i) {
+        if (matchCount[i] == 0) {
+            if (type == JOIN_INNER) continue;
+            out.leftRows.push_back(left.rows[i]);
+            out.rightRows.push_back(-1);
+        } else if (type != JOIN_ANTI) {
+            for (int m = firstMatch[i]; m < firstMatch[i + 1]; ++m) {
+                out.leftRows.push_back(left.rows[i]);
+                out.rightRows.push_back(right.rows[matchedRight[m]]);
+            }
+        }
+    }
+    return out;
+}
+
+JoinView joinDataContainerView(const dataContainer2D& left, const dataContainer2D& right, const char* leftKeys[], const char* rightKeys[], int numKeys, JoinType type) {
+    return joinDataContainerView(viewOf(left), viewOf(right), leftKeys, rightKeys, numKeys, type);
+}
+
+JoinView joinDataContainerView(const dataContainer2D& left, const dataContainer2D& right, const char* leftKey, const char* rightKey, JoinType type) {
+    const char* leftKeys[] = {leftKey};
+    const char* rightKeys[] = {rightKey};
+    return joinDataContainerView(viewOf(left), viewOf(right), leftKeys, rightKeys, 1, type);
+}
+
+
+// --- Utilities ---
+void clearTerminal() {
+    std::cout << "\033[2J\033[1;1H"; // Clears screen, moves cursor to top-left (ANSI)
+    std::cout.flush();
+}
+
+char* getString(const char* prompt) {
+    std::string inputString;
+    if(prompt) std::cout << prompt;
+    std::getline(std::cin, inputString);
+
+    if (std::cin.fail() && !std::cin.eof()) {
+        std::cin.clear();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear rest of bad input line
+        std::cerr << "Input error during getString." << std::endl;
+        char* errorRes = new char[1]; errorRes[0] = '\0'; return errorRes;
+    }
+
+    char* result = new char[inputString.length() + 1];
+    strcpy(result, inputString.c_str());
+    return result;
+}
+
+int getInt(const char* prompt) {
+    std::string line;
+    if(prompt) std::cout << prompt;
+    std::getline(std::cin, line);
+
+    if (std::cin.fail() && !std::cin.eof()) {
+        std::cin.clear();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
         std::cerr << "Input error during getInt." << std::endl; return -1;
     }
     if (line.empty()) { std::cerr << "Input error: Empty line for getInt." << std::endl; return -1; }
@@ -452,139 +4339,46 @@ char* duplicateString(const char* cstr) {
 
     // --- Helper to ensure CSV headers exist ---
     void ensureCsvHeader(const std::string& filename, const char* headers[], int numFields) {
-        fs::path dataDir;
-        try { // Simplified path logic for brevity, ensure your openCsvFileForWrite handles this robustly
-            fs::path currentPath = fs::current_path();
-            if (currentPath.has_parent_path()) dataDir = currentPath.parent_path() / "data"; else dataDir = currentPath / "data";
-             if (!fs::exists(dataDir) && currentPath.has_parent_path() && currentPath.parent_path().has_parent_path()){
-                 dataDir = currentPath.parent_path().parent_path() / "data";
-            }
-             if (!fs::exists(dataDir)) dataDir = fs::current_path() / "data"; // Final fallback
-        } catch (...) { dataDir = "data"; }
-
-
-        fs::path filePath = dataDir / filename;
-        std::ifstream fileCheck(filePath.string());
-        bool fileExistsAndNotEmpty = fileCheck.good() && fileCheck.peek() != EOF;
-        fileCheck.close();
+        flushPendingWrites(filename);
+        fs::file_time_type modifiedAt;
+        uintmax_t fileSize = 0;
+        bool fileExistsAndNotEmpty = statDataFile(filename, modifiedAt, fileSize) && fileSize > 0;
 
         if (!fileExistsAndNotEmpty) {
             std::cout << "Info: CSV file '" << filename << "' not found or empty. Writing headers." << std::endl;
             // Use writeNewDataRow to write the header
-            // This function itself will use openCsvFileForWrite which handles directory creation
+            // This function itself will use openCsvFileForAppend which handles directory creation
             writeNewDataRow(filename, numFields, headers);
         }
     }
 
 
+// Every data1 row with the columns of its first match in data2 (keyField2
+// itself dropped); data2 columns read "-" where nothing matched.
 dataContainer2D concatDataContainer(const dataContainer2D& data1, const dataContainer2D& data2, const char* keyField1, const char* keyField2) {
     dataContainer2D returnedValue;
-    if (data1.error || data2.error) {
-        returnedValue.error = 1; std::cerr << "Error: Input data for concat has error." << std::endl; return returnedValue;
-    }
     if (!keyField1 || !keyField2) {
         returnedValue.error = 1; std::cerr << "Error: Null keyField provided for concat." << std::endl; return returnedValue;
     }
-
-    int wantedFieldIndex1 = -1;
-    for (int i = 0; i < data1.x; ++i) {
-        if (data1.fields[i] && strcmp(data1.fields[i], keyField1) == 0) { wantedFieldIndex1 = i; break; }
-    }
-    if (wantedFieldIndex1 == -1) {
-        returnedValue.error = 1; std::cerr << "Error: keyField1 '" << keyField1 << "' not in data1." << std::endl; return returnedValue;
+    JoinView joined = joinDataContainerView(data1, data2, keyField1, keyField2, JOIN_LEFT);
+    if (joined.error) { returnedValue.error = 1; return returnedValue; }
+
+    // A data1 row's matches are adjacent and in data2 order; keep the first
+    size_t kept = 0;
+    for (size_t i = 0; i < joined.leftRows.size(); ++i) {
+        if (kept > 0 && joined.leftRows[kept - 1] == joined.leftRows[i]) continue;
+        joined.leftRows[kept] = joined.leftRows[i];
+        joined.rightRows[kept] = joined.rightRows[i];
+        ++kept;
     }
-
-    int wantedFieldIndex2 = -1;
-    for (int i = 0; i < data2.x; ++i) {
-        if (data2.fields[i] && strcmp(data2.fields[i], keyField2) == 0) { wantedFieldIndex2 = i; break; }
-    }
-    if (wantedFieldIndex2 == -1) {
-        returnedValue.error = 1; std::cerr << "Error: keyField2 '" << keyField2 << "' not in data2." << std::endl; return returnedValue;
-    }
-
-    returnedValue.y = data1.y;
-    returnedValue.x = data1.x + data2.x - 1;
-    if (returnedValue.x <= 0) { // y can be 0 for empty data1
-        returnedValue.error = 1; std::cerr << "Error: Invalid dimensions for concat result." << std::endl; return returnedValue;
-    }
-
-    returnedValue.fields = new char*[returnedValue.x];
-    for (int i = 0; i < data1.x; ++i) returnedValue.fields[i] = duplicateString(data1.fields[i]);
-    int currentFieldIdx = data1.x;
-    for (int k = 0; k < data2.x; ++k) {
-        if (k == wantedFieldIndex2) continue;
-        if (currentFieldIdx < returnedValue.x) returnedValue.fields[currentFieldIdx++] = duplicateString(data2.fields[k]);
-    }
-    
-    if (returnedValue.y > 0) {
-        returnedValue.data = new char**[returnedValue.y];
-        for (int i = 0; i < returnedValue.y; ++i) {
-            returnedValue.data[i] = new char*[returnedValue.x];
-            for (int k = 0; k < data1.x; ++k) returnedValue.data[i][k] = duplicateString(data1.data[i] ? data1.data[i][k] : "");
-            for (int k = data1.x; k < returnedValue.x; ++k) returnedValue.data[i][k] = duplicateString("-");
-
-            const char* keyToMatch = (data1.data[i] && data1.data[i][wantedFieldIndex1]) ? data1.data[i][wantedFieldIndex1] : nullptr;
-            if (!keyToMatch) continue;
-
-            for (int j = 0; j < data2.y; ++j) {
-                if (data2.data[j] && data2.data[j][wantedFieldIndex2] && strcmp(keyToMatch, data2.data[j][wantedFieldIndex2]) == 0) {
-                    int currentDataColIdx = data1.x;
-                    for (int k = 0; k < data2.x; ++k) {
-                        if (k == wantedFieldIndex2) continue;
-                        if (currentDataColIdx < returnedValue.x) { // Check boundary before access
-                            delete[] returnedValue.data[i][currentDataColIdx]; // Delete placeholder
-                            returnedValue.data[i][currentDataColIdx] = duplicateString(data2.data[j][k]);
-                            currentDataColIdx++;
-                        }
-                    }
-                    break; 
-                }
-            }
-        }
-    } else returnedValue.data = nullptr;
-    return returnedValue;
+    joined.leftRows.resize(kept);
+    joined.rightRows.resize(kept);
+    return joined.materialize();
 }
 
 
 dataContainer2D filterDataContainer(const dataContainer2D& dataIn, const char* field, const char* key) {
-    dataContainer2D returnedValue;
-    if (dataIn.error) { returnedValue.error = 1; std::cerr << "Error: Input for filter has error." << std::endl; return returnedValue; }
-    if (!field || !key) { returnedValue.error = 1; std::cerr << "Error: Null field/key for filter." << std::endl; return returnedValue; }
-
-    returnedValue.x = dataIn.x;
-    int wantedFieldIndex = -1;
-    for (int i = 0; i < dataIn.x; ++i) {
-        if (dataIn.fields[i] && strcmp(dataIn.fields[i], field) == 0) { wantedFieldIndex = i; break; }
-    }
-    if (wantedFieldIndex == -1) {
-        returnedValue.error = 1; std::cerr << "Error: Field '" << field << "' not found for filter." << std::endl; return returnedValue;
-    }
-
-    int matchingRowCount = 0;
-    for (int i = 0; i < dataIn.y; ++i) {
-        if (dataIn.data[i] && dataIn.data[i][wantedFieldIndex] && strcmp(dataIn.data[i][wantedFieldIndex], key) == 0) matchingRowCount++;
-    }
-
-    returnedValue.fields = new char*[returnedValue.x];
-    for(int i=0; i < returnedValue.x; ++i) returnedValue.fields[i] = duplicateString(dataIn.fields[i]);
-    
-    if (matchingRowCount == 0) {
-        returnedValue.y = 0; returnedValue.data = nullptr; return returnedValue;
-    }
-
-    returnedValue.data = new char**[matchingRowCount];
-    returnedValue.y = matchingRowCount;
-    int currentRowInReturned = 0;
-    for (int i = 0; i < dataIn.y; ++i) {
-        if (dataIn.data[i] && dataIn.data[i][wantedFieldIndex] && strcmp(dataIn.data[i][wantedFieldIndex], key) == 0) {
-            if (currentRowInReturned < matchingRowCount) {
-                returnedValue.data[currentRowInReturned] = new char*[returnedValue.x];
-                for (int j = 0; j < returnedValue.x; ++j) returnedValue.data[currentRowInReturned][j] = duplicateString(dataIn.data[i][j]);
-                currentRowInReturned++;
-            }
-        }
-    }
-    return returnedValue;
+    return filterDataContainerView(dataIn, field, key).materialize();
 }
 
 dataContainer1D getFieldValues(const dataContainer2D& dataIn, const char* field) {
@@ -615,47 +4409,7 @@ dataContainer1D getFieldValues(const dataContainer2D& dataIn, const char* field)
 }
 
 dataContainer2D shortenDataContainer(const dataContainer2D& dataIn, const char* wantedFields[], int numWantedFields) {
-    dataContainer2D returnedValue;
-    if (dataIn.error) { returnedValue.error = 1; std::cerr << "Error: Input for shorten has error." << std::endl; return returnedValue; }
-    if (numWantedFields <= 0 || !wantedFields) {
-        returnedValue.error = 1; std::cerr << "Error: No/invalid fields for shorten." << std::endl; return returnedValue;
-    }
-
-    returnedValue.x = numWantedFields; returnedValue.y = dataIn.y;
-    int* wantedFieldIndexes = new int[numWantedFields];
-
-    for (int i = 0; i < numWantedFields; ++i) {
-        wantedFieldIndexes[i] = -1;
-        if (!wantedFields[i]) {
-            returnedValue.error = 1; std::cerr << "Error: Null field name in wantedFields at index " << i << std::endl;
-            delete[] wantedFieldIndexes; return returnedValue;
-        }
-        for (int j = 0; j < dataIn.x; ++j) {
-            if (dataIn.fields[j] && strcmp(dataIn.fields[j], wantedFields[i]) == 0) {
-                wantedFieldIndexes[i] = j; break;
-            }
-        }
-        if (wantedFieldIndexes[i] == -1) {
-            returnedValue.error = 1; std::cerr << "Error: Wanted field '" << wantedFields[i] << "' not found." << std::endl;
-            delete[] wantedFieldIndexes; return returnedValue;
-        }
-    }
-
-    returnedValue.fields = new char*[returnedValue.x];
-    for (int i = 0; i < numWantedFields; ++i) returnedValue.fields[i] = duplicateString(wantedFields[i]);
-
-    if (returnedValue.y > 0) {
-        returnedValue.data = new char**[returnedValue.y];
-        for (int i = 0; i < returnedValue.y; ++i) {
-            returnedValue.data[i] = new char*[returnedValue.x];
-            for (int j = 0; j < returnedValue.x; ++j) {
-                returnedValue.data[i][j] = (dataIn.data[i] && dataIn.data[i][wantedFieldIndexes[j]]) ? duplicateString(dataIn.data[i][wantedFieldIndexes[j]]) : duplicateString("");
-            }
-        }
-    } else returnedValue.data = nullptr;
-    
-    delete[] wantedFieldIndexes;
-    return returnedValue;
+    return shortenDataContainerView(dataIn, wantedFields, numWantedFields).materialize();
 }
 
 
@@ -815,136 +4569,689 @@ int displayMenu(const char* header, const char* options[], int noOptions) {
         }
     }
 
-    displaySystemMessage("Invalid input. Please try again.", 2);
-    return displayMenu(header, options, noOptions);
+    displaySystemMessage("Invalid input. Please try again.", 2);
+    return displayMenu(header, options, noOptions);
+}
+
+// Shared by both displayTabulatedData overloads. fieldAt(col) and cellAt(row, col)
+// return nullable strings; rows for which rowPresent(row) is false are skipped.
+template <typename FieldAt, typename RowPresent, typename CellAt>
+void printTabulated(int columns, int rows, FieldAt fieldAt, RowPresent rowPresent, CellAt cellAt) {
+    const int minPaddingPerSide = 2;
+    int* columnWidths = new int[columns];
+    for (int i = 0; i < columns; ++i) columnWidths[i] = fieldAt(i) ? strlen(fieldAt(i)) : 0;
+
+    for (int j = 0; j < rows; ++j) {
+        if (rowPresent(j)) {
+            for (int i = 0; i < columns; ++i) {
+                const char* value = cellAt(j, i);
+                if (value) {
+                    int currentLength = strlen(value);
+                    if (currentLength > columnWidths[i]) columnWidths[i] = currentLength;
+                }
+            }
+        }
+    }
+
+    int totalTableWidth = 1;
+    for (int i = 0; i < columns; ++i) totalTableWidth += columnWidths[i] + (2 * minPaddingPerSide) + 1;
+
+    auto printHorizontalLine = [&](){ for (int i = 0; i < totalTableWidth; ++i) std::cout << "-"; std::cout << std::endl; };
+    auto printRowContent = [&](auto valueAt) {
+        std::cout << "|";
+        for (int i = 0; i < columns; ++i) {
+            const char* value = valueAt(i);
+            std::string cellContent = value ? value : "";
+            int currentCellContentLength = cellContent.length();
+            int totalCellWidth = columnWidths[i] + (2 * minPaddingPerSide);
+            int paddingNeeded = totalCellWidth - currentCellContentLength;
+            int leftPadding = paddingNeeded / 2;
+            int rightPadding = paddingNeeded - leftPadding;
+            for(int p=0; p<leftPadding; ++p) std::cout << " ";
+            std::cout << cellContent;
+            for(int p=0; p<rightPadding; ++p) std::cout << " ";
+            std::cout << "|";
+        }
+        std::cout << std::endl;
+    };
+
+    printHorizontalLine(); printRowContent(fieldAt); printHorizontalLine();
+    for (int j = 0; j < rows; ++j) {
+        if (rowPresent(j)) { printRowContent([&](int i) { return cellAt(j, i); }); printHorizontalLine(); }
+    }
+    delete[] columnWidths;
+}
+
+void displayTabulatedData(const dataContainer2D& data) {
+    if (data.error || data.x == 0 || !data.fields) {
+        std::cout << "No data/fields to display or data container has an error." << std::endl; return;
+    }
+    printTabulated(data.x, data.data ? data.y : 0,
+                   [&](int col) -> const char* { return data.fields[col]; },
+                   [&](int row) { return data.data[row] != nullptr; },
+                   [&](int row, int col) -> const char* { return data.data[row][col]; });
+}
+
+// Prints straight from the source table; nothing is copied.
+void displayTabulatedData(const TableView& view) {
+    if (view.error || !view.source || view.x() == 0) {
+        std::cout << "No data/fields to display or data container has an error." << std::endl; return;
+    }
+    printTabulated(view.x(), view.y(),
+                   [&](int col) -> const char* { return view.field(col); },
+                   [&](int) { return true; },
+                   [&](int row, int col) -> const char* { return view.cell(row, col); });
+}
+
+void displayTabulatedData(const JoinView& view) {
+    if (view.error || !view.left.source || view.x() == 0) {
+        std::cout << "No data/fields to display or data container has an error." << std::endl; return;
+    }
+    printTabulated(view.x(), view.y(),
+                   [&](int col) -> const char* { return view.field(col); },
+                   [&](int) { return true; },
+                   [&](int row, int col) -> const char* { return view.cell(row, col); });
+}
+
+
+// --- Data Read Functions (Query Functions) ---
+dataContainer1D queryKey(const std::string& filenameWithExtension, const char* key) {
+    dataContainer1D returnedValue;
+    if (!key) { returnedValue.error = 1; std::cerr << "Error: Null key for queryKey." << std::endl; return returnedValue; }
+
+    std::shared_ptr<CachedTable> cached = TableCache::instance().acquire(filenameWithExtension);
+    if (!cached) { returnedValue.error = 1; return returnedValue; }
+    const dataContainer2D& fullData = cached->table;
+    if (fullData.y == 0 || fullData.x == 0 || !fullData.data || !fullData.fields) {
+        returnedValue.error = 1; std::cerr << "Warning: No data/fields in file for queryKey." << std::endl;
+        return returnedValue;
+    }
+
+    const int keyColumnIndex = 0;
+    int i = cached->keyIndexFor(keyColumnIndex)->findFirst(fullData, key);
+    if (i >= 0) {
+        returnedValue.x = fullData.x; returnedValue.data = new char*[fullData.x];
+        for (int j = 0; j < fullData.x; ++j) returnedValue.data[j] = duplicateString(fullData.data[i][j]);
+        returnedValue.fields_count = fullData.x; returnedValue.fields = new char*[fullData.x];
+        for (int j = 0; j < fullData.x; ++j) returnedValue.fields[j] = duplicateString(fullData.fields[j]);
+        return returnedValue;
+    }
+    returnedValue.error = 1; /* Key not found */ return returnedValue;
+}
+
+dataContainer1D queryField(const std::string& filenameWithExtension, const char* field) {
+    if (!field) { dataContainer1D errVal; errVal.error = 1; std::cerr << "Error: Null field for queryField." << std::endl; return errVal; }
+    std::shared_ptr<CachedTable> cached = TableCache::instance().acquire(filenameWithExtension);
+    if (!cached) { dataContainer1D rv; rv.error = 1; return rv; }
+    return getFieldValues(cached->table, field);
+}
+
+dataContainer2D queryFieldStrict(const std::string& filenameWithExtension, const char* field, const char* key) {
+    if (!field || !key) { dataContainer2D ev; ev.error = 1; std::cerr << "Error: Null field/key for queryFieldStrict." << std::endl; return ev; }
+    std::shared_ptr<CachedTable> cached = TableCache::instance().acquire(filenameWithExtension);
+    if (!cached) { dataContainer2D rv; rv.error = 1; return rv; }
+    return filterDataContainer(cached->table, field, key);
+}
+
+
+// --- Write-Ahead Log ---
+// Log layout: a header line "L <generation>\n", then groups. A group is one
+// "S <size> <mtime> <nameLength>\n" record plus the file name for each file it
+// changes, then its writes, "W <offset> <nameLength> <byteLength>\n" followed by
+// the file name and the bytes, then "C <count> <checksum>\n". A group without a
+// valid commit line was torn by a crash and is ignored. "A\n" after the groups
+// means an apply started, so the files may already hold some of the writes.
+uint32_t hashBytes(const char* bytes, size_t length, uint32_t hash) {
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(bytes[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+WriteAheadLog& WriteAheadLog::instance() {
+    static WriteAheadLog log;
+    return log;
+}
+
+WriteAheadLog::WriteAheadLog()
+    : fd_(-1), openedBy_(0), lockDepth_(0), generation_(std::numeric_limits<uint64_t>::max()), knownSize_(0), groupsSinceApply_(0),
+      committing_(false), applying_(false), replaying_(false), held_(false) {
+    reopen();
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    // The table cache may already be gone at exit, so it is left alone.
+    if (lockDepth_ == 0) lockFile();
+    applyLocked(false);
+    close();
+}
+
+bool WriteAheadLog::open() {
+    close();
+    if (!resolveWritePath("csvtoolkit.wal", path_)) return false;
+#ifndef _WIN32
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    openedBy_ = static_cast<long>(getpid());
+    return fd_ >= 0;
+#else
+    return true;
+#endif
+}
+
+void WriteAheadLog::close() {
+#ifndef _WIN32
+    if (fd_ >= 0) ::close(fd_); // Releases the flock too
+#endif
+    fd_ = -1;
+}
+
+void WriteAheadLog::reopen() {
+    close();
+    generation_ = std::numeric_limits<uint64_t>::max(); // Whatever the log holds is not ours
+    knownSize_ = 0;
+    pending_.clear();
+    loggedFiles_.clear();
+    ownGroups_.clear();
+    groupsSinceApply_ = 0;
+    open();
+    replaying_ = true;
+    lock();
+    unlock();
+    replaying_ = false;
+}
+
+void WriteAheadLog::lock() {
+    if (lockDepth_++ > 0) return;
+    lockFile();
+    sync();
+}
+
+void WriteAheadLog::lockFile() {
+#ifndef _WIN32
+    if (fd_ < 0 || openedBy_ != static_cast<long>(getpid())) open();
+    if (fd_ >= 0) while (flock(fd_, LOCK_EX) != 0 && errno == EINTR) {}
+#endif
+}
+
+void WriteAheadLog::unlock() {
+    if (lockDepth_ == 0 || --lockDepth_ > 0) return;
+#ifndef _WIN32
+    if (fd_ >= 0) flock(fd_, LOCK_UN);
+#endif
+}
+
+// The log's generation (0 for an empty log or one without a header) and size.
+bool WriteAheadLog::readState(uint64_t& generation, uint64_t& size) {
+    char header[32];
+    size_t headerLength = 0;
+    generation = 0;
+#ifndef _WIN32
+    struct stat info;
+    if (fd_ < 0 || fstat(fd_, &info) != 0) return false;
+    size = static_cast<uint64_t>(info.st_size);
+    ssize_t got = size > 0 ? pread(fd_, header, sizeof(header), 0) : 0;
+    if (got < 0) return false;
+    headerLength = static_cast<size_t>(got);
+#else
+    std::error_code ec;
+    size = fs::exists(path_, ec) ? fs::file_size(path_, ec) : 0;
+    if (ec) return false;
+    std::ifstream log(path_, std::ios::binary);
+    log.read(header, sizeof(header));
+    headerLength = static_cast<size_t>(log.gcount());
+#endif
+    if (headerLength > 2 && header[0] == 'L' && header[1] == ' ') {
+        std::from_chars(header + 2, header + headerLength, generation);
+    }
+    return true;
+}
+
+bool WriteAheadLog::readLog(std::string& contents) {
+    contents.clear();
+#ifndef _WIN32
+    struct stat info;
+    if (fd_ < 0 || fstat(fd_, &info) != 0) return false;
+    contents.resize(static_cast<size_t>(info.st_size));
+    size_t done = 0;
+    while (done < contents.size()) {
+        ssize_t got = pread(fd_, &contents[done], contents.size() - done, static_cast<off_t>(done));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        done += static_cast<size_t>(got);
+    }
+    contents.resize(done);
+    return true;
+#else
+    std::ifstream log(path_, std::ios::binary);
+    if (!log.is_open()) return true; // No log yet
+    contents.assign(std::istreambuf_iterator<char>(log), std::istreambuf_iterator<char>());
+    return true;
+#endif
+}
+
+// Appends to the log and fsyncs it; 'start' is where the bytes begin. An empty
+// log gets its header first.
+bool WriteAheadLog::appendLog(const std::string& bytes, size_t& start) {
+    uint64_t generation = 0, size = 0;
+    if (!readState(generation, size)) return false;
+    std::string out;
+    if (size == 0) {
+        if (generation_ == std::numeric_limits<uint64_t>::max()) generation_ = 0;
+        out = "L " + std::to_string(generation_) + "\n";
+    }
+    start = static_cast<size_t>(size + out.size());
+    out += bytes;
+#ifndef _WIN32
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t wrote = ::write(fd_, out.data() + done, out.size() - done);
+        if (wrote < 0 && errno == EINTR) continue;
+        if (wrote <= 0) return false;
+        done += static_cast<size_t>(wrote);
+    }
+    if (fsync(fd_) != 0) return false;
+#else
+    std::ofstream log(path_, std::ios::out | std::ios::app | std::ios::binary);
+    log << out;
+    log.close();
+    if (log.fail() || !syncPath(path_)) return false;
+#endif
+    knownSize_ = start + bytes.size();
+    return true;
+}
+
+// Empties the log down to a header carrying the new generation.
+bool WriteAheadLog::resetLog(uint64_t generation) {
+    std::string header = "L " + std::to_string(generation) + "\n";
+#ifndef _WIN32
+    if (fd_ < 0 || ftruncate(fd_, 0) != 0) return false;
+    if (::write(fd_, header.data(), header.size()) != static_cast<ssize_t>(header.size()) || fsync(fd_) != 0) return false;
+#else
+    std::ofstream log(path_, std::ios::out | std::ios::trunc | std::ios::binary);
+    log << header;
+    log.close();
+    if (log.fail() || !syncPath(path_)) return false;
+#endif
+    generation_ = generation;
+    knownSize_ = header.size();
+    return true;
+}
+
+// Run on taking the lock: notices what other processes did to the log while it
+// was not held.
+void WriteAheadLog::sync() {
+    uint64_t generation = 0, size = 0;
+    if (!readState(generation, size)) return;
+    if (generation != generation_) {
+        // Another process applied the log, this process's groups included.
+        bool unknown = generation_ == std::numeric_limits<uint64_t>::max();
+        generation_ = generation;
+        knownSize_ = size == 0 ? 0 : std::to_string(generation).size() + 3;
+        if (!unknown) keepQueuedOnly();
+    }
+    if (size != knownSize_) applyLocked(true); // It logged groups of its own
+}
+
+// After an apply only the queued (not yet logged) writes are pending; the files
+// they go to now hold everything logged before them.
+void WriteAheadLog::keepQueuedOnly() {
+    std::unordered_map<std::string, PendingFile> queued;
+    for (const Write& write : buffered_) {
+        auto found = queued.find(write.filename);
+        if (found == queued.end()) {
+            PendingFile file{fs::file_time_type(), 0, 0};
+            statDataFile(write.filename, file.baseModifiedAt, file.baseSize);
+            file.logicalSize = file.baseSize;
+            found = queued.emplace(write.filename, file).first;
+        }
+        found->second.logicalSize = std::max<uintmax_t>(found->second.logicalSize, write.offset + write.bytes.size());
+    }
+    pending_.swap(queued);
+    loggedFiles_.clear();
+    ownGroups_.clear();
+    groupsSinceApply_ = 0;
+}
+
+void WriteAheadLog::record(const std::string& filenameWithExtension, const fs::file_time_type& diskModifiedAt, uintmax_t diskSize,
+                           size_t offset, const std::string& bytes) {
+    auto found = pending_.find(filenameWithExtension);
+    if (found == pending_.end()) {
+        found = pending_.emplace(filenameWithExtension, PendingFile{diskModifiedAt, diskSize, diskSize}).first;
+    }
+    found->second.logicalSize = std::max<uintmax_t>(found->second.logicalSize, offset + bytes.size());
+    buffered_.push_back(Write{filenameWithExtension, offset, bytes, false});
+}
+
+void WriteAheadLog::recordReplace(const std::string& filenameWithExtension, const std::string& tempName, uintmax_t tempSize) {
+    PendingFile file{fs::file_time_type(), 0, tempSize};
+    statDataFile(filenameWithExtension, file.baseModifiedAt, file.baseSize);
+    pending_[filenameWithExtension] = file;
+    buffered_.push_back(Write{filenameWithExtension, 0, tempName, true});
+}
+
+bool WriteAheadLog::hasPending(const std::string& filenameWithExtension) const {
+    return pending_.count(filenameWithExtension) != 0;
+}
+
+uint64_t WriteAheadLog::loggedGroups(const std::string& filenameWithExtension) const {
+    auto found = loggedGroups_.find(filenameWithExtension);
+    return found == loggedGroups_.end() ? 0 : found->second;
+}
+
+void WriteAheadLog::discard(const std::string& filenameWithExtension) {
+    size_t kept = 0;
+    for (size_t i = 0; i < buffered_.size(); ++i) {
+        if (buffered_[i].filename == filenameWithExtension) continue;
+        if (kept != i) buffered_[kept] = std::move(buffered_[i]);
+        ++kept;
+    }
+    buffered_.resize(kept);
+    if (!hasLogged(filenameWithExtension)) pending_.erase(filenameWithExtension);
+}
+
+uintmax_t WriteAheadLog::logicalSize(const std::string& filenameWithExtension, uintmax_t diskSize) const {
+    auto found = pending_.find(filenameWithExtension);
+    return found == pending_.end() ? diskSize : found->second.logicalSize;
 }
 
-void displayTabulatedData(const dataContainer2D& data) {
-    if (data.error || data.x == 0 || !data.fields) {
-        std::cout << "No data/fields to display or data container has an error." << std::endl; return;
-    }
+int WriteAheadLog::commitUnlessHeld() {
+    if (buffered_.empty() || held_) return 0;
+    return commit();
+}
 
-    const int minPaddingPerSide = 2;
-    int* columnWidths = new int[data.x];
-    for (int i = 0; i < data.x; ++i) columnWidths[i] = data.fields[i] ? strlen(data.fields[i]) : 0;
-
-    if (data.y > 0 && data.data) {
-        for (int j = 0; j < data.y; ++j) {
-            if (data.data[j]) {
-                for (int i = 0; i < data.x; ++i) {
-                    if (data.data[j][i]) {
-                        int currentLength = strlen(data.data[j][i]);
-                        if (currentLength > columnWidths[i]) columnWidths[i] = currentLength;
-                    }
-                }
-            }
-        }
+int WriteAheadLog::commit() {
+    if (buffered_.empty() || committing_ || applying_) return 0;
+    Lock lock;
+    committing_ = true;
+    std::vector<Write> writes;
+    writes.swap(buffered_);
+
+    // One stamp per file: its state on disk before any of the unapplied groups.
+    std::vector<std::string> files;
+    for (const Write& write : writes) {
+        if (std::find(files.begin(), files.end(), write.filename) == files.end()) files.push_back(write.filename);
     }
+    std::string group, record;
+    uint32_t checksum = 2166136261u;
+    for (const std::string& filename : files) {
+        const PendingFile& base = pending_[filename];
+        record = "S " + std::to_string(base.baseSize) + " " + std::to_string(static_cast<long long>(base.baseModifiedAt.time_since_epoch().count())) +
+                 " " + std::to_string(filename.size()) + "\n" + filename;
+        checksum = hashBytes(record.data(), record.size(), checksum);
+        group += record;
+    }
+    bool renames = false;
+    for (const Write& write : writes) {
+        renames = renames || write.rename;
+        record = write.rename ? "R " : "W " + std::to_string(write.offset) + " ";
+        record += std::to_string(write.filename.size()) + " " + std::to_string(write.bytes.size()) + "\n";
+        checksum = hashBytes(record.data(), record.size(), checksum);
+        checksum = hashBytes(write.filename.data(), write.filename.size(), checksum);
+        checksum = hashBytes(write.bytes.data(), write.bytes.size(), checksum);
+        group += record;
+        group += write.filename;
+        group += write.bytes;
+    }
+    group += "C " + std::to_string(files.size() + writes.size()) + " " + std::to_string(checksum) + "\n";
 
-    int totalTableWidth = 1;
-    for (int i = 0; i < data.x; ++i) totalTableWidth += columnWidths[i] + (2 * minPaddingPerSide) + 1;
-
-    auto printHorizontalLine = [&](){ for (int i = 0; i < totalTableWidth; ++i) std::cout << "-"; std::cout << std::endl; };
-    auto printRowContent = [&](char* rowData[]) {
-        std::cout << "|";
-        for (int i = 0; i < data.x; ++i) {
-            std::string cellContent = rowData && rowData[i] ? rowData[i] : "";
-            int currentCellContentLength = cellContent.length();
-            int totalCellWidth = columnWidths[i] + (2 * minPaddingPerSide);
-            int paddingNeeded = totalCellWidth - currentCellContentLength;
-            int leftPadding = paddingNeeded / 2;
-            int rightPadding = paddingNeeded - leftPadding;
-            for(int p=0; p<leftPadding; ++p) std::cout << " ";
-            std::cout << cellContent;
-            for(int p=0; p<rightPadding; ++p) std::cout << " ";
-            std::cout << "|";
+    int result = 0;
+    size_t start = 0;
+    if (!appendLog(group, start)) {
+        std::cerr << "Error: Could not write " << path_.string() << "; the change was not saved." << std::endl;
+        for (const std::string& filename : files) {
+            TableCache::instance().invalidate(filename);
+            if (!hasLogged(filename)) pending_.erase(filename);
         }
-        std::cout << std::endl;
-    };
-
-    printHorizontalLine(); printRowContent(data.fields); printHorizontalLine();
-    if (data.y > 0 && data.data) {
-        for (int i = 0; i < data.y; ++i) {
-            if (data.data[i]) { printRowContent(data.data[i]); printHorizontalLine(); }
+        result = 1;
+    } else {
+        ownGroups_.insert(start);
+        if (groupsSinceApply_++ == 0) firstLoggedAt_ = std::chrono::steady_clock::now();
+        for (const std::string& filename : files) {
+            loggedFiles_.insert(filename);
+            ++loggedGroups_[filename];
+        }
+        if (renames || groupsSinceApply_ >= 64 || knownSize_ >= (1u << 20) ||
+            std::chrono::steady_clock::now() - firstLoggedAt_ >= std::chrono::seconds(2)) {
+            result = applyLocked(true);
         }
     }
-    delete[] columnWidths;
+    committing_ = false;
+    return result;
 }
 
+int WriteAheadLog::apply() {
+    Lock lock;
+    return applyLocked(true);
+}
 
-// --- Data Read Functions (Query Functions) ---
-dataContainer1D queryKey(const std::string& filenameWithExtension, const char* key) {
-    dataContainer1D returnedValue;
-    if (!key) { returnedValue.error = 1; std::cerr << "Error: Null key for queryKey." << std::endl; return returnedValue; }
+// Applies every committed group in the log, in order, then empties it. With
+// 'touchCache', the cache entries of files only this process's groups changed
+// are restamped, and those of the other files in the log are dropped.
+int WriteAheadLog::applyLocked(bool touchCache) {
+    if (applying_) return 0;
+    std::string contents;
+    uint64_t generation = 0, size = 0;
+    if (!readState(generation, size) || (size == knownSize_ && generation == generation_ && loggedFiles_.empty())) return 0;
+    if (!readLog(contents)) return 0;
+
+    // 1. Read the committed groups.
+    std::vector<Group> groups;
+    Group group;
+    bool started = false; // An apply was cut short
+    uint32_t checksum = 2166136261u;
+    size_t records = 0;
+    size_t pos = 0;
+    if (contents.compare(0, 2, "L ") == 0) pos = contents.find('\n') + 1;
+    size_t headerEnd = pos;
+    group.start = pos;
+    while (pos < contents.size()) {
+        size_t lineEnd = contents.find('\n', pos);
+        if (lineEnd == std::string::npos) break;
+        std::string line = contents.substr(pos, lineEnd + 1 - pos);
+        std::istringstream fields(line.substr(1));
+        if (line[0] == 'S' || line[0] == 'W' || line[0] == 'R') {
+            size_t offset = 0, nameLength = 0, byteLength = 0;
+            long long modifiedAt = 0;
+            bool parsed = line[0] == 'S' ? static_cast<bool>(fields >> offset >> modifiedAt >> nameLength)
+                        : line[0] == 'W' ? static_cast<bool>(fields >> offset >> nameLength >> byteLength)
+                                         : static_cast<bool>(fields >> nameLength >> byteLength);
+            if (!parsed || lineEnd + 1 + nameLength + byteLength > contents.size()) break;
+            checksum = hashBytes(line.data(), line.size(), checksum);
+            checksum = hashBytes(contents.data() + lineEnd + 1, nameLength + byteLength, checksum);
+            std::string filename = contents.substr(lineEnd + 1, nameLength);
+            if (line[0] == 'S') group.stamps.push_back(Stamp{filename, offset, modifiedAt});
+            else group.writes.push_back(Write{filename, offset, contents.substr(lineEnd + 1 + nameLength, byteLength), line[0] == 'R'});
+            ++records;
+            pos = lineEnd + 1 + nameLength + byteLength;
+        } else if (line[0] == 'C') {
+            size_t count = 0;
+            uint32_t expected = 0;
+            if (!(fields >> count >> expected) || count != records || expected != checksum) break;
+            groups.push_back(std::move(group));
+            pos = lineEnd + 1;
+            group = Group();
+            group.start = pos;
+            checksum = 2166136261u;
+            records = 0;
+        } else if (line == "A\n" && records == 0) {
+            started = true;
+            pos = lineEnd + 1;
+            group.start = pos;
+        } else {
+            break;
+        }
+    }
+    if (groups.empty()) { // Nothing committed, or only a torn group
+        if (contents.size() > headerEnd) {
+            resetLog(generation + 1);
+        } else {
+            generation_ = generation;
+            knownSize_ = size;
+        }
+        keepQueuedOnly();
+        return 0;
+    }
 
-    dataContainer2D fullData = getData(filenameWithExtension);
-    if (fullData.error) {
-        returnedValue.error = 1; deleteDataContainer2D(fullData); return returnedValue;
+    // 2. Decide which writes each file takes: a group's writes to a file apply
+    // only if the file is as the group found it. After an interrupted apply the
+    // file may also have grown by the group's writes, or been renamed over.
+    applying_ = true;
+    size_t markStart = 0;
+    if (!started) appendLog("A\n", markStart);
+    struct FileApply {
+        bool statOk = false;
+        bool foreign = false; // Changed by another process's groups
+        bool failed = false;
+        uintmax_t size = 0;
+        long long modifiedAt = 0;
+        size_t end = 0;
+        std::vector<const Write*> writes;
+    };
+    std::unordered_map<std::string, FileApply> files;
+    std::vector<std::string> order;
+    for (const Group& logged : groups) {
+        for (const Write& write : logged.writes) {
+            auto found = files.find(write.filename);
+            if (found == files.end()) {
+                found = files.emplace(write.filename, FileApply()).first;
+                order.push_back(write.filename);
+                fs::file_time_type modifiedAt;
+                found->second.statOk = statDataFile(write.filename, modifiedAt, found->second.size);
+                found->second.modifiedAt = static_cast<long long>(modifiedAt.time_since_epoch().count());
+            }
+            if (!write.rename) found->second.end = std::max(found->second.end, write.offset + write.bytes.size());
+        }
     }
-    if (fullData.y == 0 || fullData.x == 0 || !fullData.data || !fullData.fields) {
-        returnedValue.error = 1; std::cerr << "Warning: No data/fields in file for queryKey." << std::endl;
-        deleteDataContainer2D(fullData); return returnedValue;
+    std::error_code ec;
+    bool ownLog = generation == generation_;
+    int result = 0;
+    size_t appliedGroups = 0;
+    for (const Group& logged : groups) {
+        bool own = ownLog && ownGroups_.count(logged.start) != 0;
+        std::unordered_set<std::string> refused;
+        for (const Stamp& stamp : logged.stamps) {
+            auto found = files.find(stamp.filename);
+            if (found == files.end()) continue;
+            FileApply& file = found->second;
+            bool matches = file.statOk && file.size == stamp.size && file.modifiedAt == stamp.modifiedAt;
+            bool partlyApplied = started && file.statOk && file.size >= stamp.size && file.size <= std::max<uintmax_t>(file.end, stamp.size);
+            for (const Write& write : logged.writes) {
+                if (write.rename && write.filename == stamp.filename) {
+                    partlyApplied = started && !fs::exists(DataStore::instance().pathOf(write.bytes), ec);
+                }
+            }
+            if (!matches && !partlyApplied) refused.insert(stamp.filename);
+        }
+        for (const Write& write : logged.writes) {
+            FileApply& file = files[write.filename];
+            if (!own) file.foreign = true;
+            if (refused.count(write.filename) == 0) {
+                file.writes.push_back(&write);
+                continue;
+            }
+            file.failed = true;
+            if (write.rename) fs::remove(DataStore::instance().pathOf(write.bytes), ec);
+        }
+        for (const std::string& filename : refused) {
+            std::cerr << "Error: " << filename << " changed on disk before its logged changes were applied; they were dropped." << std::endl;
+            result = 1;
+        }
+        ++appliedGroups;
     }
 
-    const int keyColumnIndex = 0;
-    for (int i = 0; i < fullData.y; ++i) {
-        if (fullData.data[i] && fullData.data[i][keyColumnIndex] && strcmp(fullData.data[i][keyColumnIndex], key) == 0) {
-            returnedValue.x = fullData.x; returnedValue.data = new char*[fullData.x];
-            for (int j = 0; j < fullData.x; ++j) returnedValue.data[j] = duplicateString(fullData.data[i][j]);
-            returnedValue.fields_count = fullData.x; returnedValue.fields = new char*[fullData.x];
-            for (int j = 0; j < fullData.x; ++j) returnedValue.fields[j] = duplicateString(fullData.fields[j]);
-            deleteDataContainer2D(fullData); return returnedValue;
+    // 3. Write each file, coalescing writes that continue where the previous one
+    // ended (appended rows), and fsync it. A rename puts a rewritten file (from a
+    // Transaction) in place; its temp file is already synced, so only the
+    // directory is synced after it.
+    TableWatcher* watcher = touchCache ? &TableWatcher::instance() : nullptr;
+    bool renamed = false;
+    for (const std::string& filename : order) {
+        FileApply& file = files[filename];
+        if (file.writes.empty()) continue;
+        fs::path filePath = DataStore::instance().pathOf(filename);
+        if (watcher) watcher->beginOwnWrite(filename);
+        std::fstream out;
+        std::string run;
+        size_t runOffset = 0;
+        bool written = true, patched = false;
+        for (size_t i = 0; i <= file.writes.size(); ++i) {
+            const Write* write = i < file.writes.size() ? file.writes[i] : nullptr;
+            if (write && !write->rename && !run.empty() && write->offset == runOffset + run.size()) { run += write->bytes; continue; }
+            if (!run.empty()) {
+                if (!out.is_open()) out.open(filePath, std::ios::in | std::ios::out | std::ios::binary);
+                out.seekp(static_cast<std::streamoff>(runOffset));
+                out.write(run.data(), static_cast<std::streamsize>(run.size()));
+                written = written && out.is_open() && !out.fail();
+                patched = true;
+                run.clear();
+            }
+            if (!write) break;
+            if (!write->rename) {
+                run = write->bytes;
+                runOffset = write->offset;
+                continue;
+            }
+            if (out.is_open()) out.close();
+            fs::path tempPath = DataStore::instance().pathOf(write->bytes);
+            if (!fs::exists(tempPath, ec)) continue; // Renamed before an apply was cut short
+            fs::rename(tempPath, filePath, ec);
+            written = written && !ec;
+            renamed = renamed || !ec;
+        }
+        if (out.is_open()) out.close();
+        if (watcher) watcher->endOwnWrite(filename);
+        if (!written || out.fail() || (patched && !syncPath(filePath))) {
+            std::cerr << "Error: Could not write changes to " << filename << std::endl;
+            file.failed = true;
+            result = 1;
         }
     }
-    returnedValue.error = 1; /* Key not found */ deleteDataContainer2D(fullData); return returnedValue;
+    if (renamed) DataStore::instance().syncRoot();
+
+    // 4. Everything that could be applied is in the CSV files now.
+    resetLog(generation + 1);
+    if (replaying_) std::cout << "Info: Replayed " << appliedGroups << " logged group(s) from " << path_.string() << std::endl;
+    if (touchCache) {
+        for (const std::string& filename : order) {
+            const FileApply& file = files[filename];
+            if (file.foreign || file.failed) TableCache::instance().invalidate(filename);
+            else TableCache::instance().restamp(filename);
+        }
+    }
+    keepQueuedOnly();
+    applying_ = false;
+    return result;
 }
 
-dataContainer1D queryField(const std::string& filenameWithExtension, const char* field) {
-    if (!field) { dataContainer1D errVal; errVal.error = 1; std::cerr << "Error: Null field for queryField." << std::endl; return errVal; }
-    dataContainer2D fullData = getData(filenameWithExtension);
-    if (fullData.error) { dataContainer1D rv; rv.error = 1; deleteDataContainer2D(fullData); return rv; }
-    dataContainer1D result = getFieldValues(fullData, field);
-    deleteDataContainer2D(fullData); return result;
+// Commits any queued writes and applies the log now.
+int flushWriteAheadLog() {
+    WriteAheadLog& log = WriteAheadLog::instance();
+    WriteAheadLog::Lock lock;
+    int result = log.commit();
+    if (log.apply() != 0) result = 1;
+    return result;
 }
 
-dataContainer2D queryFieldStrict(const std::string& filenameWithExtension, const char* field, const char* key) {
-    if (!field || !key) { dataContainer2D ev; ev.error = 1; std::cerr << "Error: Null field/key for queryFieldStrict." << std::endl; return ev; }
-    dataContainer2D fullData = getData(filenameWithExtension);
-    if (fullData.error) { dataContainer2D rv; rv.error = 1; deleteDataContainer2D(fullData); return rv; }
-    dataContainer2D result = filterDataContainer(fullData, field, key);
-    deleteDataContainer2D(fullData); return result;
+// Applies the log before a file with logged writes is read from or rewritten
+// on disk. Writes still queued by a Transaction are left queued.
+void flushPendingWrites(const std::string& filenameWithExtension) {
+    WriteAheadLog& log = WriteAheadLog::instance();
+    WriteAheadLog::Lock lock;
+    if (log.hasLogged(filenameWithExtension)) log.apply();
 }
 
-
 // --- Data Write Functions ---
+// Where a data file is written, creating the data directory if there is none yet.
+bool resolveWritePath(const std::string& filenameWithExtension, fs::path& filePath) {
+    if (!DataStore::instance().ensureRoot()) return false;
+    filePath = DataStore::instance().pathOf(filenameWithExtension);
+    return true;
+}
+
 bool openCsvFileForWrite(const std::string& filenameWithExtension, std::ofstream& outFileStream, std::ios_base::openmode mode) {
-    fs::path dataDir;
-    try {
-        fs::path currentPath = fs::current_path();
-        if (currentPath.has_parent_path()) {
-            dataDir = currentPath.parent_path() / "data";
-            if (!fs::exists(dataDir) && currentPath.parent_path().has_parent_path()) {
-                 dataDir = currentPath.parent_path().parent_path() / "data";
-            }
-        } else dataDir = currentPath / "data";
-        
-        if (!fs::exists(dataDir)) {
-            fs::path alternativeDataDir = fs::current_path() / "data";
-            if (fs::exists(alternativeDataDir) && fs::is_directory(alternativeDataDir)) dataDir = alternativeDataDir;
-            else {
-                dataDir = currentPath.has_parent_path() ? currentPath.parent_path() / "data" : currentPath / "data";
-                if(!fs::exists(dataDir)) {
-                    std::cout << "Info: Data directory (" << dataDir.string() << ") not found, attempting to create." << std::endl;
-                    if (!fs::create_directories(dataDir)) {
-                        std::cerr << "Error: Could not create data directory: " << dataDir.string() << std::endl; return false;
-                    }
-                }
-            }
-        }
-    } catch (const fs::filesystem_error& e) {
-        std::cerr << "Filesystem error (write path): " << e.what() << std::endl; return false;
-    }
-    fs::path filePath = dataDir / filenameWithExtension;
+    fs::path filePath;
+    if (!resolveWritePath(filenameWithExtension, filePath)) return false;
     outFileStream.open(filePath, mode);
     if (!outFileStream.is_open()) {
         std::cerr << "Error: Could not open file for writing: " << filePath.string() << std::endl; return false;
@@ -952,472 +5259,634 @@ bool openCsvFileForWrite(const std::string& filenameWithExtension, std::ofstream
     return true;
 }
 
-int writeData(const std::string& filenameWithExtension, const dataContainer2D& containerToWrite) {
-    if (containerToWrite.error) { std::cerr << "Error: Input for writeData has error." << std::endl; return 1; }
-    std::ofstream outFile;
-    if (!openCsvFileForWrite(filenameWithExtension, outFile, std::ios::out | std::ios::trunc)) return 1;
-
-    if (containerToWrite.x > 0 && containerToWrite.fields) {
-        for (int i = 0; i < containerToWrite.x; ++i) {
-            if (containerToWrite.fields[i]) outFile << containerToWrite.fields[i];
-            if (i < containerToWrite.x - 1) outFile << ",";
-        }
-        outFile << "\n";
-    }
-    if (containerToWrite.y > 0 && containerToWrite.data) {
-        for (int i = 0; i < containerToWrite.y; ++i) {
-            if (containerToWrite.data[i]) {
-                for (int j = 0; j < containerToWrite.x; ++j) {
-                    if (containerToWrite.data[i][j]) outFile << containerToWrite.data[i][j];
-                    if (j < containerToWrite.x - 1) outFile << ",";
-                }
-                outFile << "\n";
-            }
-        }
+bool openCsvFileForAppend(const std::string& filenameWithExtension, CsvWriter& writer) {
+    if (writer.openData(filenameWithExtension, true) != 0) {
+        std::cerr << "Error: Could not open file for writing: " << DataStore::instance().pathOf(filenameWithExtension).string() << std::endl;
+        return false;
     }
-    outFile.close(); return 0;
+    return true;
 }
 
-int writeNewDataRow(const std::string& filenameWithExtension, int numInputs, const char* inputs[]) {
-    if (!inputs || numInputs <= 0) { std::cerr << "Error: No inputs for writeNewDataRow." << std::endl; return 1; }
-    for (int i = 0; i < numInputs; ++i) {
-        if (inputs[i] && strchr(inputs[i], ',')) {
-            std::cerr << "Warning (writeNewDataRow): Input '" << inputs[i] << "' contains comma. Output may be malformed without quoting." << std::endl;
-        }
-    }
-    std::ofstream outFile;
-    if (!openCsvFileForWrite(filenameWithExtension, outFile, std::ios::out | std::ios::app)) return 1;
-    for (int i = 0; i < numInputs; ++i) {
-        if (inputs[i]) outFile << inputs[i];
-        if (i < numInputs - 1) outFile << ",";
-    }
-    outFile << "\n"; outFile.close(); return 0;
+// Flushes a file's (or directory's) contents to stable storage.
+bool syncPath(const fs::path& path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool synced = fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+#else
+    (void)path; // No directory fsync on Windows; MoveFileEx replaces the file atomically
+    return true;
+#endif
 }
 
-int updateDataByUniqueKey(const std::string& filenameWithExtension, const char* uniqueKeyToUpdate, int uniqueKeyColumnIndex, int numColsInNewData, const char* newDataRow[]) {
-    if (!uniqueKeyToUpdate || !newDataRow || uniqueKeyColumnIndex < 0) { std::cerr << "Error: Invalid args for updateDataByUniqueKey." << std::endl; return 1;}
+CsvWriter::CsvWriter(size_t bufferBytes) : error(1),
+#ifndef _WIN32
+    fd_(-1),
+#endif
+    bufferBytes_(bufferBytes > 0 ? bufferBytes : 1), written_(0), lineBreak_("\n") {}
 
-    dataContainer2D currentData = getData(filenameWithExtension);
-    if (currentData.error && currentData.y == 0) { std::cerr << "Error: File empty/unreadable for update." << std::endl; deleteDataContainer2D(currentData); return 1; }
-    if (currentData.error) { std::cerr << "Error: File read error for update." << std::endl; deleteDataContainer2D(currentData); return 1;}
-    if (uniqueKeyColumnIndex >= currentData.x) { std::cerr << "Error: Key index out of bounds." << std::endl; deleteDataContainer2D(currentData); return 1; }
-    if (numColsInNewData != currentData.x) { std::cerr << "Error: New data column count mismatch." << std::endl; deleteDataContainer2D(currentData); return 1;}
-
-    bool updated = false;
-    for (int i = 0; i < currentData.y; ++i) {
-        if (currentData.data[i] && currentData.data[i][uniqueKeyColumnIndex] && strcmp(currentData.data[i][uniqueKeyColumnIndex], uniqueKeyToUpdate) == 0) {
-            for (int j = 0; j < currentData.x; ++j) {
-                delete[] currentData.data[i][j];
-                currentData.data[i][j] = duplicateString(newDataRow[j]);
-            }
-            updated = true; // Assuming unique key, but could continue if multiple updates allowed
-        }
-    }
-    if (!updated) { std::cerr << "Info: Key '" << uniqueKeyToUpdate << "' not found for update." << std::endl; deleteDataContainer2D(currentData); return 2; }
-    int writeResult = writeData(filenameWithExtension, currentData);
-    deleteDataContainer2D(currentData); return writeResult;
+CsvWriter::~CsvWriter() {
+    close();
 }
 
-int updateDataBySecondKey(const std::string& filenameWithExtension, const char* primaryKey, int primaryKeyIndex, const char* secondaryKey, int secondaryKeyIndex, int numColsInNewData, const char* newDataRow[]) {
-    if (!primaryKey || !secondaryKey || !newDataRow || primaryKeyIndex < 0 || secondaryKeyIndex < 0) { std::cerr << "Error: Invalid args for updateDataBySecondKey." << std::endl; return 1; }
-
-    dataContainer2D currentData = getData(filenameWithExtension);
-    if (currentData.error && currentData.y == 0) { std::cerr << "Error: File empty/unreadable for update (second key)." << std::endl; deleteDataContainer2D(currentData); return 1;}
-    if (currentData.error) { std::cerr << "Error: File read error for update (second key)." << std::endl; deleteDataContainer2D(currentData); return 1; }
-    if (primaryKeyIndex >= currentData.x || secondaryKeyIndex >= currentData.x) { std::cerr << "Error: Key index out of bounds (second key)." << std::endl; deleteDataContainer2D(currentData); return 1; }
-    if (numColsInNewData != currentData.x) { std::cerr << "Error: New data column count mismatch (second key)." << std::endl; deleteDataContainer2D(currentData); return 1; }
-
-    bool updated = false;
-    for (int i = 0; i < currentData.y; ++i) {
-        if (currentData.data[i] && currentData.data[i][primaryKeyIndex] && strcmp(currentData.data[i][primaryKeyIndex], primaryKey) == 0 &&
-            currentData.data[i][secondaryKeyIndex] && strcmp(currentData.data[i][secondaryKeyIndex], secondaryKey) == 0) {
-            for (int j = 0; j < currentData.x; ++j) {
-                delete[] currentData.data[i][j];
-                currentData.data[i][j] = duplicateString(newDataRow[j]);
-            }
-            updated = true;
-        }
-    }
-    if (!updated) { std::cerr << "Info: Record matching keys not found for update (second key)." << std::endl; deleteDataContainer2D(currentData); return 2;}
-    int writeResult = writeData(filenameWithExtension, currentData);
-    deleteDataContainer2D(currentData); return writeResult;
+int CsvWriter::open(const fs::path& filePath, bool append) {
+    close();
+#ifndef _WIN32
+    fd_ = ::open(filePath.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+    if (fd_ < 0) return 1;
+#else
+    file_.open(filePath, std::ios::out | std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    if (!file_.is_open()) return 1;
+#endif
+    start();
+    return 0;
 }
 
-int deleteByKey(const std::string& filenameWithExtension, const char* keyToDelete, int keyColumnIndex) {
-    if (!keyToDelete || keyColumnIndex < 0) { std::cerr << "Error: Invalid args for deleteByKey." << std::endl; return 1; }
+int CsvWriter::openData(const std::string& filenameWithExtension, bool append) {
+    DataStore& store = DataStore::instance();
+    if (!store.ensureRoot()) return 1;
+#ifndef _WIN32
+    close();
+    fd_ = store.openFile(filenameWithExtension, O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC));
+    if (fd_ < 0) return 1;
+    start();
+    return 0;
+#else
+    return open(store.pathOf(filenameWithExtension), append);
+#endif
+}
 
-    dataContainer2D originalData = getData(filenameWithExtension);
-    if (originalData.error && originalData.y == 0) { std::cerr << "Error: File empty/unreadable for delete." << std::endl; deleteDataContainer2D(originalData); return 1; }
-    if (originalData.error) { std::cerr << "Error: File read error for delete." << std::endl; deleteDataContainer2D(originalData); return 1; }
-    if (keyColumnIndex >= originalData.x) { std::cerr << "Error: Key index out of bounds for delete." << std::endl; deleteDataContainer2D(originalData); return 1; }
+void CsvWriter::start() {
+    buffer_.clear();
+    buffer_.reserve(bufferBytes_);
+    written_ = 0;
+    error = 0;
+}
 
-    dataContainer2D modifiedData;
-    modifiedData.x = originalData.x;
-    if (originalData.x > 0 && originalData.fields) {
-        modifiedData.fields = new char*[modifiedData.x];
-        for (int i = 0; i < modifiedData.x; ++i) modifiedData.fields[i] = duplicateString(originalData.fields[i]);
-    } else modifiedData.fields = nullptr;
+void CsvWriter::writeRow(int numValues, const char* const* values) {
+    appendRow(buffer_, numValues, values);
+    buffer_ += lineBreak_;
+    if (buffer_.size() >= bufferBytes_) flush();
+}
 
+int CsvWriter::flush() {
+    if (error) return 1;
+    const char* bytes = buffer_.data();
+    size_t remaining = buffer_.size();
+#ifndef _WIN32
+    while (remaining > 0) { // One call unless the kernel takes the buffer in parts
+        ssize_t count = ::write(fd_, bytes, remaining);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) { error = 1; break; }
+        bytes += count;
+        remaining -= static_cast<size_t>(count);
+    }
+#else
+    file_.write(bytes, static_cast<std::streamsize>(remaining));
+    file_.flush();
+    if (file_.fail()) error = 1;
+    else remaining = 0;
+#endif
+    written_ += buffer_.size() - remaining;
+    buffer_.clear();
+    return error;
+}
 
-    char*** keptRowsData = (originalData.y > 0) ? new char**[originalData.y] : nullptr;
-    int keptRowCount = 0; bool deletionOccurred = false;
+int CsvWriter::close() {
+    bool opened = false;
+#ifndef _WIN32
+    opened = fd_ >= 0;
+#else
+    opened = file_.is_open();
+#endif
+    if (!opened) return 1;
+    int result = flush();
+#ifndef _WIN32
+    if (::close(fd_) != 0) result = 1;
+    fd_ = -1;
+#else
+    file_.close();
+#endif
+    error = 1;
+    return result;
+}
 
-    for (int i = 0; i < originalData.y; ++i) {
-        if (originalData.data[i] && originalData.data[i][keyColumnIndex] && strcmp(originalData.data[i][keyColumnIndex], keyToDelete) == 0) {
-            for (int j = 0; j < originalData.x; ++j) delete[] originalData.data[i][j];
-            delete[] originalData.data[i]; originalData.data[i] = nullptr;
-            deletionOccurred = true;
-        } else {
-            if (originalData.data[i] && keptRowsData) keptRowsData[keptRowCount++] = originalData.data[i]; // Transfer pointer
-            if (originalData.data[i]) originalData.data[i] = nullptr; // Avoid double free by originalData cleanup
-        }
+void CsvWriter::appendRow(std::string& out, int numValues, const char* const* values) {
+    for (int j = 0; j < numValues; ++j) {
+        if (j > 0) out += ',';
+        appendField(out, values[j], j == 0);
     }
-    
-    modifiedData.y = keptRowCount;
-    if (keptRowCount > 0 && keptRowsData) {
-        modifiedData.data = new char**[keptRowCount];
-        for(int i=0; i < keptRowCount; ++i) modifiedData.data[i] = keptRowsData[i];
-    } else modifiedData.data = nullptr;
-    delete[] keptRowsData;
+}
 
-    if(originalData.fields) delete[] originalData.fields; originalData.fields = nullptr; 
-    if(originalData.data) delete[] originalData.data; originalData.data = nullptr;
+void CsvWriter::appendField(std::string& out, const char* value, bool firstField) {
+    if (!value) return;
+    if (!(firstField && value[0] == '#') && strpbrk(value, ",\"\r\n") == nullptr) { out += value; return; }
 
-    if (!deletionOccurred) {
-        std::cerr << "Info: Key '" << keyToDelete << "' not found for deletion." << std::endl;
-        deleteDataContainer2D(modifiedData); return 2;
+    out += '"';
+    for (const char* c = value; *c; ++c) {
+        if (*c == '"') out += "\"\"";
+        else out += *c;
     }
-    int writeResult = writeData(filenameWithExtension, modifiedData);
-    deleteDataContainer2D(modifiedData); return writeResult;
+    out += '"';
 }
 
-int deleteBySecondKey(const std::string& filenameWithExtension, const char* primaryKey, int primaryKeyIndex, const char* secondaryKey, int secondaryKeyIndex) {
-    if (!primaryKey || !secondaryKey || primaryKeyIndex < 0 || secondaryKeyIndex < 0) { std::cerr << "Error: Invalid args for deleteBySecondKey." << std::endl; return 1;}
+// Whether rows written to a data file should end in "\r\n": its header line
+// does. A file that does not exist yet gets "\n".
+bool dataFileUsesCrlf(const std::string& filenameWithExtension) {
+    std::shared_ptr<CachedTable> cached = TableCache::instance().current(filenameWithExtension);
+    if (cached) return cached->crlf;
+    fs::path filePath;
+    if (resolveDataFilePath(filenameWithExtension, filePath) != 0) return false;
+    std::ifstream file(filePath, std::ios::binary);
+    std::string header;
+    return std::getline(file, header) && !header.empty() && header.back() == '\r';
+}
 
-    dataContainer2D originalData = getData(filenameWithExtension);
-    if (originalData.error && originalData.y == 0) { std::cerr << "Error: File empty/unreadable for delete (second key)." << std::endl; deleteDataContainer2D(originalData); return 1;}
-    if (originalData.error) { std::cerr << "Error: File read error for delete (second key)." << std::endl; deleteDataContainer2D(originalData); return 1;}
-    if (primaryKeyIndex >= originalData.x || secondaryKeyIndex >= originalData.x) { std::cerr << "Error: Key index out of bounds (second key)." << std::endl; deleteDataContainer2D(originalData); return 1;}
-
-    dataContainer2D modifiedData;
-    modifiedData.x = originalData.x;
-    if (originalData.x > 0 && originalData.fields) {
-        modifiedData.fields = new char*[modifiedData.x];
-        for (int i = 0; i < modifiedData.x; ++i) modifiedData.fields[i] = duplicateString(originalData.fields[i]);
-    } else modifiedData.fields = nullptr;
-
-    char*** keptRowsData = (originalData.y > 0) ? new char**[originalData.y] : nullptr;
-    int keptRowCount = 0; bool deletionOccurred = false;
-
-    for (int i = 0; i < originalData.y; ++i) {
-        bool pMatch = originalData.data[i] && originalData.data[i][primaryKeyIndex] && strcmp(originalData.data[i][primaryKeyIndex], primaryKey) == 0;
-        bool sMatch = originalData.data[i] && originalData.data[i][secondaryKeyIndex] && strcmp(originalData.data[i][secondaryKeyIndex], secondaryKey) == 0;
-        if (pMatch && sMatch) {
-            for (int j = 0; j < originalData.x; ++j) delete[] originalData.data[i][j];
-            delete[] originalData.data[i]; originalData.data[i] = nullptr;
-            deletionOccurred = true;
-        } else {
-            if (originalData.data[i] && keptRowsData) keptRowsData[keptRowCount++] = originalData.data[i];
-            if (originalData.data[i]) originalData.data[i] = nullptr;
-        }
+// Writes the whole container to a sibling "<file>.tmp", fsyncs it and renames it
+// over the original, so the file is always either the old or the new version.
+// Inside a Transaction the rename is queued in its log group instead, so it
+// happens together with the transaction's other writes. The file keeps its line
+// breaks ("\n" or "\r\n").
+int writeData(const std::string& filenameWithExtension, const dataContainer2D& containerToWrite) {
+    if (containerToWrite.error) { std::cerr << "Error: Input for writeData has error." << std::endl; return 1; }
+    WriteAheadLog::Lock lock;
+    WriteAheadLog::instance().discard(filenameWithExtension); // Queued writes are to the file being replaced
+    flushPendingWrites(filenameWithExtension);
+    fs::path filePath;
+    if (!resolveWritePath(filenameWithExtension, filePath)) return 1;
+    fs::path tempPath = filePath;
+    tempPath += ".tmp";
+    bool crlf = dataFileUsesCrlf(filenameWithExtension);
+    CsvWriter outFile;
+    outFile.setCrlf(crlf);
+    if (outFile.openData(filenameWithExtension + ".tmp", false) != 0) {
+        std::cerr << "Error: Could not open file for writing: " << tempPath.string() << std::endl; return 1;
     }
 
-    modifiedData.y = keptRowCount;
-    if (keptRowCount > 0 && keptRowsData) {
-        modifiedData.data = new char**[keptRowCount];
-        for(int i=0; i < keptRowCount; ++i) modifiedData.data[i] = keptRowsData[i];
-    } else modifiedData.data = nullptr;
-    delete[] keptRowsData;
+    // Tracks whether re-reading the file would reproduce the container exactly,
+    // which lets the table cache keep it instead of reloading.
+    // Row extents are recorded alongside so the cache can patch rows in place later.
+    bool roundTrips = containerToWrite.x > 1;
+    std::vector<RowExtent> extents;
+    if (containerToWrite.x > 0 && containerToWrite.fields) {
+        outFile.writeRow(containerToWrite.x, containerToWrite.fields);
+    }
+    if (containerToWrite.y > 0 && containerToWrite.data) {
+        for (int i = 0; i < containerToWrite.y; ++i) {
+            if (containerToWrite.data[i]) {
+                size_t rowStart = outFile.offset();
+                outFile.writeRow(containerToWrite.x, containerToWrite.data[i]);
+                size_t rowSpan = outFile.offset() - rowStart;
+                extents.push_back(RowExtent{rowStart, rowSpan - 1, rowSpan, rowStart});
+            }
+        }
+    }
 
-    if(originalData.fields) delete[] originalData.fields; originalData.fields = nullptr;
-    if(originalData.data) delete[] originalData.data; originalData.data = nullptr;
+    std::error_code ec;
+    size_t tempSize = outFile.offset();
+    if (outFile.close() != 0 || !syncPath(tempPath)) {
+        std::cerr << "Error: Could not write " << tempPath.string() << "; " << filenameWithExtension << " left unchanged." << std::endl;
+        fs::remove(tempPath, ec);
+        return 1;
+    }
+    WriteAheadLog& log = WriteAheadLog::instance();
+    if (log.held()) {
+        DataStore::instance().syncRoot(); // The temp file must outlive a crash until the log group is applied
+        log.recordReplace(filenameWithExtension, filenameWithExtension + ".tmp", tempSize);
+        TableCache::instance().noteWrite(filenameWithExtension, &containerToWrite, roundTrips, &extents);
+        return 0;
+    }
+    TableWatcher& watcher = TableWatcher::instance();
+    watcher.beginOwnWrite(filenameWithExtension);
+    fs::rename(tempPath, filePath, ec);
+    watcher.endOwnWrite(filenameWithExtension);
+    if (ec) {
+        std::cerr << "Error: Could not replace " << filePath.string() << ": " << ec.message() << std::endl;
+        fs::remove(tempPath, ec);
+        return 1;
+    }
+    DataStore::instance().syncRoot(); // Make the rename itself durable
+    TableCache::instance().noteWrite(filenameWithExtension, &containerToWrite, roundTrips, &extents);
+    return 0;
+}
 
-    if (!deletionOccurred) {
-        std::cerr << "Info: Record matching keys not found for deletion (second key)." << std::endl;
-        deleteDataContainer2D(modifiedData); return 2;
+// Whether a cached file, with its queued writes applied, ends in a newline. The
+// row stored furthest into the file carries any trailing newline in its span.
+bool cachedFileEndsWithNewline(const std::string& filenameWithExtension, const CachedTable& cached) {
+    const RowExtent* last = nullptr;
+    for (const RowExtent& extent : cached.extents) {
+        if (extent.span != 0 && (!last || extent.offset > last->offset)) last = &extent; // span 0: staged, not in the file yet
     }
-    int writeResult = writeData(filenameWithExtension, modifiedData);
-    deleteDataContainer2D(modifiedData); return writeResult;
+    if (last) return last->span > last->length;
+    if (WriteAheadLog::instance().hasPending(filenameWithExtension)) return true; // Queued writes end in a line break
+
+    fs::path filePath;
+    if (resolveDataFilePath(filenameWithExtension, filePath) != 0) return false;
+    std::ifstream file(filePath, std::ios::binary);
+    file.seekg(-1, std::ios::end);
+    return file.good() && file.get() == '\n';
 }
 
-dataContainer2D SortByFieldName(dataContainer2D data, const char* fieldName, bool ascending) {
-    using namespace CsvToolkit;
+// Appends a row to a cached table and commits its bytes through the write-ahead
+// log. Returns 0 or 1 like writeNewDataRow, or -1 when the row cannot go through
+// the log (table not current or layout unknown); the caller then appends to the
+// file itself.
+int appendThroughLog(const std::string& filenameWithExtension, int numValues, const char* const* values) {
+    if (!TableCache::instance().current(filenameWithExtension)) return -1;
+    std::shared_ptr<CachedTable> cached = TableCache::instance().acquireForWrite(filenameWithExtension);
+    if (!cached || cached->table.x <= 1 || numValues != cached->table.x || !cached->table.arena || !cached->extentsKnown()) return -1;
+    std::string text;
+    CsvWriter::appendRow(text, numValues, values);
+    if (!cachedFileEndsWithNewline(filenameWithExtension, *cached)) return -1;
+
+    text += cached->crlf ? "\r\n" : "\n";
+
+    WriteAheadLog& log = WriteAheadLog::instance();
+    size_t offset = static_cast<size_t>(log.logicalSize(filenameWithExtension, cached->fileSize));
+    log.record(filenameWithExtension, cached->modifiedAt, cached->fileSize, offset, text);
+    cached->extents.push_back(RowExtent{offset, text.size() - 1, text.size(), offset});
+    cached->appendRow(values);
+    return log.commitUnlessHeld();
+}
 
-    dataContainer2D sorted;
-    sorted.error = 1;
+int writeNewDataRow(const std::string& filenameWithExtension, int numInputs, const char* inputs[]) {
+    if (!inputs || numInputs <= 0) { std::cerr << "Error: No inputs for writeNewDataRow." << std::endl; return 1; }
+    WriteAheadLog::Lock lock; // From reading the table to logging the change
+    int logged = appendThroughLog(filenameWithExtension, numInputs, inputs);
+    if (logged != -1) return logged;
+    flushPendingWrites(filenameWithExtension);
+    bool patchCache = TableCache::instance().beginAppend(filenameWithExtension);
+    CsvWriter outFile;
+    outFile.setCrlf(dataFileUsesCrlf(filenameWithExtension));
+    if (!openCsvFileForAppend(filenameWithExtension, outFile)) return 1;
+    TableWatcher::instance().beginOwnWrite(filenameWithExtension);
+    outFile.writeRow(numInputs, inputs);
+    bool written = outFile.close() == 0;
+    TableWatcher::instance().endOwnWrite(filenameWithExtension);
+    TableCache::instance().noteAppend(filenameWithExtension, patchCache && written, numInputs, inputs);
+    return written ? 0 : 1;
+}
 
-    if (data.error || !data.fields || data.x == 0 || data.y == 0) {
-        std::cerr << "Error: Invalid data container.\n";
-        return sorted;
-    }
+// Persists a table that was modified in place inside the cache. If the write
+// fails the entry no longer matches the file, so it is dropped.
+int writeCachedTable(const std::string& filenameWithExtension, const dataContainer2D& table) {
+    int writeResult = writeData(filenameWithExtension, table);
+    if (writeResult != 0) TableCache::instance().invalidate(filenameWithExtension);
+    return writeResult;
+}
 
-    // Find column index
-    int fieldIndex = -1;
-    for (int i = 0; i < data.x; ++i) {
-        if (strcmp(data.fields[i], fieldName) == 0) {
-            fieldIndex = i;
-            break;
-        }
+// Persists changes to a few rows of a cached table without rewriting the file.
+// A changed row is overwritten in place when it fits its extent, and the bytes
+// it no longer needs become one filler comment line ("#" and spaces), so rows
+// keep their order and cells their exact values. A row that does not fit is
+// appended at the end of the file, and its old place becomes a row pointer to
+// it (see orderMovedRows) so it still loads in its place. A removed row's bytes
+// become filler, and so does the pointer to it if it was moved. New rows from a
+// transaction are appended. Rows are written with the file's line break, and
+// the writes go through the write-ahead log. An unknown layout, or a row too
+// short to hold a filler line or row pointer, means a full rewrite instead, as
+// do filler and pointers that add up to over a quarter of the file (to compact it).
+int writeChangedRows(const std::string& filenameWithExtension, CachedTable& cached, const std::vector<int>& changedRows,
+                     const std::vector<RowExtent>& removedExtents) {
+    dataContainer2D& table = cached.table;
+    if (table.x <= 1 || !cached.extentsKnown()) return writeCachedTable(filenameWithExtension, table);
+
+    // Everything that could need a rewrite is checked before anything is logged.
+    const std::string lineBreak = cached.crlf ? "\r\n" : "\n";
+    const size_t fillerBytes = 1 + lineBreak.size(); // Shortest filler line
+    for (const RowExtent& extent : removedExtents) {
+        if (extent.span != 0 && extent.span < fillerBytes) return writeCachedTable(filenameWithExtension, table);
     }
-    if (fieldIndex == -1) {
-        std::cerr << "Error: Field '" << fieldName << "' not found.\n";
-        return sorted;
+    std::vector<std::string> lines(changedRows.size());
+    std::vector<bool> inPlace(changedRows.size(), false);
+    bool appending = false;
+    for (size_t k = 0; k < changedRows.size(); ++k) {
+        CsvWriter::appendRow(lines[k], table.x, table.data[changedRows[k]]);
+        lines[k] += lineBreak;
+        const RowExtent& extent = cached.extents[changedRows[k]];
+        size_t left = extent.span >= lines[k].size() ? extent.span - lines[k].size() : 0;
+        inPlace[k] = extent.span >= lines[k].size() && (left == 0 || left >= fillerBytes);
+        if (inPlace[k]) continue;
+        appending = true; // A new row, or one moved to the end
+        if (extent.span == 0) continue;
+        size_t placeBytes = extent.order == extent.offset ? ROW_POINTER_BYTES + lineBreak.size() : fillerBytes;
+        if (extent.span < placeBytes) return writeCachedTable(filenameWithExtension, table); // No room for the pointer
     }
-
-    // Copy field names
-    sorted.x = data.x;
-    sorted.y = data.y;
-    sorted.fields = new char*[sorted.x];
-    for (int i = 0; i < sorted.x; ++i)
-        sorted.fields[i] = duplicateString(data.fields[i]);
-
-    // Copy data
-    sorted.data = new char**[sorted.y];
-    for (int i = 0; i < sorted.y; ++i) {
-        sorted.data[i] = new char*[sorted.x];
-        for (int j = 0; j < sorted.x; ++j) {
-            sorted.data[i][j] = duplicateString(data.data[i][j]);
+    // Appending after an unterminated last line would join the two
+    if (appending && !cachedFileEndsWithNewline(filenameWithExtension, cached)) return writeCachedTable(filenameWithExtension, table);
+
+    WriteAheadLog& log = WriteAheadLog::instance();
+    size_t fileEnd = static_cast<size_t>(log.logicalSize(filenameWithExtension, cached.fileSize));
+    for (const RowExtent& extent : removedExtents) {
+        if (extent.span == 0) continue; // A transaction's new row, not in the file yet
+        log.record(filenameWithExtension, cached.modifiedAt, cached.fileSize, extent.offset, fillerLine(extent.span, cached.crlf));
+        if (extent.order != extent.offset) {
+            log.record(filenameWithExtension, cached.modifiedAt, cached.fileSize, extent.order, "#" + std::string(ROW_POINTER_BYTES - 1, ' '));
         }
+        cached.deadBytes += liveBytesIn(extent);
     }
+    for (size_t k = 0; k < changedRows.size(); ++k) {
+        RowExtent& extent = cached.extents[changedRows[k]];
+        const std::string& line = lines[k];
+        if (inPlace[k]) {
+            size_t left = extent.span - line.size();
+            log.record(filenameWithExtension, cached.modifiedAt, cached.fileSize, extent.offset,
+                       left == 0 ? line : line + fillerLine(left, cached.crlf));
+            cached.deadBytes = cached.deadBytes + liveBytesIn(extent) - line.size();
+            extent.length = line.size() - 1;
+            continue;
+        }
 
-    // Bubble sort (lexical)
-    for (int i = 0; i < sorted.y - 1; ++i) {
-        for (int j = 0; j < sorted.y - i - 1; ++j) {
-            const char* a = sorted.data[j][fieldIndex];
-            const char* b = sorted.data[j + 1][fieldIndex];
-
-            bool condition = ascending ? (strcmp(a, b) > 0) : (strcmp(a, b) < 0);
-            if (condition) {
-                char** temp = sorted.data[j];
-                sorted.data[j] = sorted.data[j + 1];
-                sorted.data[j + 1] = temp;
-            }
+        log.record(filenameWithExtension, cached.modifiedAt, cached.fileSize, fileEnd, line);
+        size_t order = fileEnd;
+        if (extent.span != 0 && extent.order == extent.offset) { // First move: its place becomes the pointer
+            std::string pointer = rowPointerText(fileEnd);
+            pointer.append(extent.span - pointer.size() - lineBreak.size(), ' ');
+            log.record(filenameWithExtension, cached.modifiedAt, cached.fileSize, extent.offset, pointer + lineBreak);
+            order = extent.offset;
+        } else if (extent.span != 0) { // Moved again: the pointer follows it
+            log.record(filenameWithExtension, cached.modifiedAt, cached.fileSize, extent.offset, fillerLine(extent.span, cached.crlf));
+            log.record(filenameWithExtension, cached.modifiedAt, cached.fileSize, extent.order, rowPointerText(fileEnd));
+            order = extent.order;
         }
+        if (extent.span != 0) cached.deadBytes += liveBytesIn(extent);
+        extent = RowExtent{fileEnd, line.size() - 1, line.size(), order};
+        fileEnd += line.size();
     }
 
-    sorted.error = 0;
-    return sorted;
+    if (cached.deadBytes * 4 > fileEnd) return writeCachedTable(filenameWithExtension, table);
+    return log.commitUnlessHeld();
 }
 
-dataContainer2D sortByTwoFields(dataContainer2D data,const char* primaryField,const char* secondaryField,bool ascending) {
-    using namespace CsvToolkit;
-
-    dataContainer2D sorted;
-    sorted.error = 1;
-
-    if (data.error || !data.fields || data.x == 0 || data.y == 0) {
-        std::cerr << "Error: Invalid data container.\n";
-        return sorted;
+int updateDataByUniqueKey(const std::string& filenameWithExtension, const char* uniqueKeyToUpdate, int uniqueKeyColumnIndex, int numColsInNewData, const char* newDataRow[]) {
+    if (!uniqueKeyToUpdate || !newDataRow || uniqueKeyColumnIndex < 0) { std::cerr << "Error: Invalid args for updateDataByUniqueKey." << std::endl; return 1;}
+    WriteAheadLog::Lock lock;
+
+    std::shared_ptr<CachedTable> cached = TableCache::instance().acquireForWrite(filenameWithExtension);
+    if (!cached) { std::cerr << "Error: File empty/unreadable for update." << std::endl; return 1; }
+    dataContainer2D& currentData = cached->table;
+    if (uniqueKeyColumnIndex >= currentData.x) { std::cerr << "Error: Key index out of bounds." << std::endl; return 1; }
+    if (numColsInNewData != currentData.x) { std::cerr << "Error: New data column count mismatch." << std::endl; return 1;}
+
+    std::vector<int> matchingRows;
+    cached->keyIndexFor(uniqueKeyColumnIndex)->find(currentData, uniqueKeyToUpdate, matchingRows);
+    bool updated = !matchingRows.empty();
+    for (int i : matchingRows) {
+        for (int j = 0; j < currentData.x; ++j) cached->setCell(i, j, newDataRow[j]);
     }
+    if (!updated) { std::cerr << "Info: Key '" << uniqueKeyToUpdate << "' not found for update." << std::endl; return 2; }
+    return writeChangedRows(filenameWithExtension, *cached, matchingRows, {});
+}
 
-    // Find primary and secondary column indices
-    int primaryIdx = -1, secondaryIdx = -1;
-    for (int i = 0; i < data.x; ++i) {
-        if (strcmp(data.fields[i], primaryField) == 0) primaryIdx = i;
-        if (strcmp(data.fields[i], secondaryField) == 0) secondaryIdx = i;
+int updateDataBySecondKey(const std::string& filenameWithExtension, const char* primaryKey, int primaryKeyIndex, const char* secondaryKey, int secondaryKeyIndex, int numColsInNewData, const char* newDataRow[]) {
+    if (!primaryKey || !secondaryKey || !newDataRow || primaryKeyIndex < 0 || secondaryKeyIndex < 0) { std::cerr << "Error: Invalid args for updateDataBySecondKey." << std::endl; return 1; }
+    WriteAheadLog::Lock lock;
+
+    std::shared_ptr<CachedTable> cached = TableCache::instance().acquireForWrite(filenameWithExtension);
+    if (!cached) { std::cerr << "Error: File empty/unreadable for update (second key)." << std::endl; return 1; }
+    dataContainer2D& currentData = cached->table;
+    if (primaryKeyIndex >= currentData.x || secondaryKeyIndex >= currentData.x) { std::cerr << "Error: Key index out of bounds (second key)." << std::endl; return 1; }
+    if (numColsInNewData != currentData.x) { std::cerr << "Error: New data column count mismatch (second key)." << std::endl; return 1; }
+
+    std::vector<int> matchingRows, updatedRows;
+    cached->keyIndexFor(primaryKeyIndex)->find(currentData, primaryKey, matchingRows);
+    for (int i : matchingRows) {
+        if (currentData.data[i][secondaryKeyIndex] && strcmp(currentData.data[i][secondaryKeyIndex], secondaryKey) == 0) {
+            for (int j = 0; j < currentData.x; ++j) cached->setCell(i, j, newDataRow[j]);
+            updatedRows.push_back(i);
+        }
     }
+    if (updatedRows.empty()) { std::cerr << "Info: Record matching keys not found for update (second key)." << std::endl; return 2;}
+    return writeChangedRows(filenameWithExtension, *cached, updatedRows, {});
+}
 
-    if (primaryIdx == -1 || secondaryIdx == -1) {
-        std::cerr << "Error: One or both fields not found.\n";
-        return sorted;
-    }
+int deleteByKey(const std::string& filenameWithExtension, const char* keyToDelete, int keyColumnIndex) {
+    if (!keyToDelete || keyColumnIndex < 0) { std::cerr << "Error: Invalid args for deleteByKey." << std::endl; return 1; }
+    WriteAheadLog::Lock lock;
 
-    // Copy fields
-    sorted.x = data.x;
-    sorted.y = data.y;
-    sorted.fields = new char*[sorted.x];
-    for (int i = 0; i < sorted.x; ++i)
-        sorted.fields[i] = duplicateString(data.fields[i]);
-
-    // Copy data
-    sorted.data = new char**[sorted.y];
-    for (int i = 0; i < sorted.y; ++i) {
-        sorted.data[i] = new char*[sorted.x];
-        for (int j = 0; j < sorted.x; ++j)
-            sorted.data[i][j] = duplicateString(data.data[i][j]);
-    }
-
-    // Bubble sort with primary + secondary criteria
-    for (int i = 0; i < sorted.y - 1; ++i) {
-        for (int j = 0; j < sorted.y - i - 1; ++j) {
-            const char* a1 = sorted.data[j][primaryIdx];
-            const char* b1 = sorted.data[j + 1][primaryIdx];
-            const char* a2 = sorted.data[j][secondaryIdx];
-            const char* b2 = sorted.data[j + 1][secondaryIdx];
-
-            bool swapNeeded = false;
-            int cmpPrimary = strcmp(a1, b1);
-            int cmpSecondary = strcmp(a2, b2);
-
-            if (ascending) {
-                if (cmpPrimary > 0) swapNeeded = true;
-                else if (cmpPrimary == 0 && cmpSecondary > 0) swapNeeded = true;
-            } else {
-                if (cmpPrimary < 0) swapNeeded = true;
-                else if (cmpPrimary == 0 && cmpSecondary < 0) swapNeeded = true;
-            }
+    std::shared_ptr<CachedTable> cached = TableCache::instance().acquireForWrite(filenameWithExtension);
+    if (!cached) { std::cerr << "Error: File empty/unreadable for delete." << std::endl; return 1; }
+    dataContainer2D& originalData = cached->table;
+    if (keyColumnIndex >= originalData.x) { std::cerr << "Error: Key index out of bounds for delete." << std::endl; return 1; }
 
-            if (swapNeeded) {
-                char** temp = sorted.data[j];
-                sorted.data[j] = sorted.data[j + 1];
-                sorted.data[j + 1] = temp;
-            }
-        }
+    std::vector<int> matchingRows;
+    cached->keyIndexFor(keyColumnIndex)->find(originalData, keyToDelete, matchingRows);
+    if (matchingRows.empty()) {
+        std::cerr << "Info: Key '" << keyToDelete << "' not found for deletion." << std::endl;
+        return 2;
     }
 
-    sorted.error = 0;
-    return sorted;
+    std::vector<RowExtent> removedExtents;
+    cached->removeRows(matchingRows, removedExtents);
+    return writeChangedRows(filenameWithExtension, *cached, {}, removedExtents);
 }
 
-int updateFieldByKey(const std::string& filename, const char* key, const char* fieldName, const char* newValue) {
-    dataContainer2D data = getData(filename);
-    if (data.error || data.y == 0) {
-        std::cerr << "Error loading file or no records.\n";
-        return 1;
-    }
+int deleteBySecondKey(const std::string& filenameWithExtension, const char* primaryKey, int primaryKeyIndex, const char* secondaryKey, int secondaryKeyIndex) {
+    if (!primaryKey || !secondaryKey || primaryKeyIndex < 0 || secondaryKeyIndex < 0) { std::cerr << "Error: Invalid args for deleteBySecondKey." << std::endl; return 1;}
+    WriteAheadLog::Lock lock;
 
-    int keyIndex = 0; // assumes the key is the first column
-    int fieldIndex = -1;
+    std::shared_ptr<CachedTable> cached = TableCache::instance().acquireForWrite(filenameWithExtension);
+    if (!cached) { std::cerr << "Error: File empty/unreadable for delete (second key)." << std::endl; return 1; }
+    dataContainer2D& originalData = cached->table;
+    if (primaryKeyIndex >= originalData.x || secondaryKeyIndex >= originalData.x) { std::cerr << "Error: Key index out of bounds (second key)." << std::endl; return 1;}
 
-    // Find the index of the field to update
-    for (int i = 0; i < data.x; ++i) {
-        if (data.fields[i] && strcmp(data.fields[i], fieldName) == 0) {
-            fieldIndex = i;
-            break;
-        }
+    std::vector<int> matchingRows, doomedRows;
+    cached->keyIndexFor(primaryKeyIndex)->find(originalData, primaryKey, matchingRows);
+    for (int i : matchingRows) {
+        if (originalData.data[i][secondaryKeyIndex] && strcmp(originalData.data[i][secondaryKeyIndex], secondaryKey) == 0) doomedRows.push_back(i);
     }
-
-    if (fieldIndex == -1) {
-        std::cerr << "Field '" << fieldName << "' not found.\n";
-        deleteDataContainer2D(data);
+    if (doomedRows.empty()) {
+        std::cerr << "Info: Record matching keys not found for deletion (second key)." << std::endl;
         return 2;
     }
+    std::vector<RowExtent> removedExtents;
+    cached->removeRows(doomedRows, removedExtents);
+    return writeChangedRows(filenameWithExtension, *cached, {}, removedExtents);
+}
 
-    bool found = false;
-    for (int i = 0; i < data.y; ++i) {
-        if (data.data[i][keyIndex] && strcmp(data.data[i][keyIndex], key) == 0) {
-            delete[] data.data[i][fieldIndex]; // delete old value
-            data.data[i][fieldIndex] = duplicateString(newValue);
-            found = true;
-            break;
-        }
-    }
+dataContainer2D SortByFieldName(const dataContainer2D& data, const char* fieldName, bool ascending) {
+    return SortByFieldNameView(data, fieldName, ascending).materialize();
+}
+
+dataContainer2D sortByTwoFields(const dataContainer2D& data, const char* primaryField, const char* secondaryField, bool ascending) {
+    return sortByTwoFieldsView(data, primaryField, secondaryField, ascending).materialize();
+}
+
+int updateFieldByKey(const std::string& filename, const char* key, const char* fieldName, const char* newValue) {
+    int result = updateFieldsByKey(filename, key, 1, &fieldName, &newValue);
+    if (result == 1) std::cerr << "Error loading file or no records.\n";
+    else if (result == 2) std::cerr << "Field '" << fieldName << "' not found.\n";
+    else if (result == 3) std::cerr << "Key '" << key << "' not found.\n";
+    return result;
+}
 
-    if (!found) {
-        std::cerr << "Key '" << key << "' not found.\n";
-        deleteDataContainer2D(data);
-        return 3;
+// Sets several fields of the first row whose first column is 'key', writing
+// only that row back. Returns 0, or 1 (unreadable/empty), 2 (unknown field) or
+// 3 (key not found) without printing, so callers can report in their own words.
+int updateFieldsByKey(const std::string& filename, const char* key, int numFields, const char* fieldNames[], const char* newValues[]) {
+    WriteAheadLog::Lock lock;
+    std::shared_ptr<CachedTable> cached = TableCache::instance().acquireForWrite(filename);
+    if (!cached || cached->table.y == 0) return 1;
+    dataContainer2D& data = cached->table;
+
+    const int keyIndex = 0; // assumes the key is the first column
+    std::vector<int> fieldIndexes(numFields, -1);
+    for (int f = 0; f < numFields; ++f) {
+        for (int i = 0; i < data.x; ++i) {
+            if (data.fields[i] && strcmp(data.fields[i], fieldNames[f]) == 0) { fieldIndexes[f] = i; break; }
+        }
+        if (fieldIndexes[f] == -1) return 2;
     }
 
-    int writeResult = writeData(filename, data);
-    deleteDataContainer2D(data);
-    return writeResult;
+    int row = cached->keyIndexFor(keyIndex)->findFirst(data, key);
+    if (row < 0) return 3;
+    for (int f = 0; f < numFields; ++f) cached->setCell(row, fieldIndexes[f], newValues[f]);
+    return writeChangedRows(filename, *cached, { row }, {});
 }
 int writeRow(const std::string& filenameWithExtension, int numCols, char** rowData) {
         if (!rowData || numCols <= 0) {
             std::cerr << "Error: Invalid arguments for writeRow.\n";
             return 1;
         }
-
-        std::ofstream outFile;
-        if (!openCsvFileForWrite(filenameWithExtension, outFile, std::ios::out | std::ios::app)) {
+        WriteAheadLog::Lock lock;
+
+        int logged = appendThroughLog(filenameWithExtension, numCols, rowData);
+        if (logged != -1) return logged;
+        flushPendingWrites(filenameWithExtension);
+        bool patchCache = TableCache::instance().beginAppend(filenameWithExtension);
+        CsvWriter outFile;
+        outFile.setCrlf(dataFileUsesCrlf(filenameWithExtension));
+        if (!openCsvFileForAppend(filenameWithExtension, outFile)) {
             return 1;
         }
 
-        for (int i = 0; i < numCols; ++i) {
-            if (rowData[i]) outFile << rowData[i];
-            if (i < numCols - 1) outFile << ",";
-        }
-        outFile << "\n";
-        outFile.close();
-        return 0;
+        TableWatcher::instance().beginOwnWrite(filenameWithExtension);
+        outFile.writeRow(numCols, rowData);
+        bool written = outFile.close() == 0;
+        TableWatcher::instance().endOwnWrite(filenameWithExtension);
+        TableCache::instance().noteAppend(filenameWithExtension, patchCache && written, numCols, rowData);
+        return written ? 0 : 1;
     }
 
-dataContainer2D Search1FieldValue(const std::string& filenameWithExtension, const char* fieldName, const char* dataToMatch) {
-    dataContainer2D fullData = getData(filenameWithExtension);
-    dataContainer2D result;
-    result.error = 1;
-
-    if (fullData.error || !fieldName || !dataToMatch) {
-        std::cerr << "Search1FieldValue: Error loading data or invalid arguments.\n";
-        deleteDataContainer2D(fullData);
-        return result;
+// --- Transactions ---
+Transaction::StagedTable* Transaction::stage(const std::string& filenameWithExtension) {
+    for (StagedTable& staged : tables_) {
+        if (staged.filename == filenameWithExtension) return &staged;
     }
+    flushPendingWrites(filenameWithExtension); // Applying them later would re-stamp the base
+    std::shared_ptr<CachedTable> base = TableCache::instance().acquire(filenameWithExtension);
+    if (!base) return nullptr;
+
+    StagedTable staged;
+    staged.filename = filenameWithExtension;
+    staged.base = base; // Holding it makes other writers copy the cache entry, which commit() notices
+    staged.baseModifiedAt = base->modifiedAt;
+    staged.baseSize = base->fileSize;
+    staged.working = base->clone();
+    tables_.push_back(std::move(staged));
+    return &tables_.back();
+}
 
-    // Find the index of the requested field
-    int fieldIndex = -1;
-    for (int i = 0; i < fullData.x; ++i) {
-        if (strcmp(fullData.fields[i], fieldName) == 0) {
-            fieldIndex = i;
-            break;
+int Transaction::updateFieldsByKey(const std::string& filename, const char* key, int numFields, const char* fieldNames[], const char* newValues[]) {
+    StagedTable* staged = stage(filename);
+    if (!staged || staged->working->table.y == 0) return 1;
+    CachedTable& working = *staged->working;
+    dataContainer2D& data = working.table;
+
+    const int keyIndex = 0; // assumes the key is the first column
+    std::vector<int> fieldIndexes(numFields, -1);
+    for (int f = 0; f < numFields; ++f) {
+        for (int i = 0; i < data.x; ++i) {
+            if (data.fields[i] && strcmp(data.fields[i], fieldNames[f]) == 0) { fieldIndexes[f] = i; break; }
         }
+        if (fieldIndexes[f] == -1) return 2;
     }
 
-    if (fieldIndex == -1) {
-        std::cerr << "Search1FieldValue: Field '" << fieldName << "' not found.\n";
-        deleteDataContainer2D(fullData);
-        return result;
-    }
+    int row = working.keyIndexFor(keyIndex)->findFirst(data, key);
+    if (row < 0) return 3;
+    for (int f = 0; f < numFields; ++f) working.setCell(row, fieldIndexes[f], newValues[f]);
+    staged->changedRows.push_back(data.data[row]);
+    return 0;
+}
 
-    // Prepare result container
-    result.x = fullData.x;
-    result.fields = new char*[result.x];
-    for (int i = 0; i < result.x; ++i)
-        result.fields[i] = duplicateString(fullData.fields[i]);
+int Transaction::appendRow(const std::string& filenameWithExtension, int numValues, const char* const* values) {
+    StagedTable* staged = stage(filenameWithExtension);
+    if (!staged) return 1;
+    CachedTable& working = *staged->working;
+    if (numValues != working.table.x) return 2;
 
-    result.data = new char**[fullData.y];
-    result.y = 0;
+    if (working.extentsKnown()) working.extents.push_back(RowExtent{0, 0, 0, 0}); // Placed at the end of the file on commit
+    working.appendRow(values);
+    staged->changedRows.push_back(working.table.data[working.table.y - 1]);
+    return 0;
+}
 
-    for (int i = 0; i < fullData.y; ++i) {
-        if (strcmp(fullData.data[i][fieldIndex], dataToMatch) == 0) {
-            result.data[result.y] = new char*[result.x];
-            for (int j = 0; j < result.x; ++j)
-                result.data[result.y][j] = duplicateString(fullData.data[i][j]);
-            result.y++;
-        }
+int Transaction::deleteByKey(const std::string& filenameWithExtension, const char* key, int keyColumnIndex) {
+    StagedTable* staged = stage(filenameWithExtension);
+    if (!staged || !key || keyColumnIndex < 0 || keyColumnIndex >= staged->working->table.x) return 1;
+    CachedTable& working = *staged->working;
+
+    std::vector<int> matchingRows;
+    working.keyIndexFor(keyColumnIndex)->find(working.table, key, matchingRows);
+    if (matchingRows.empty()) return 2;
+    for (int i : matchingRows) {
+        std::vector<char**>& changed = staged->changedRows;
+        changed.erase(std::remove(changed.begin(), changed.end(), working.table.data[i]), changed.end());
     }
-
-    result.error = 0;
-    deleteDataContainer2D(fullData);
-    return result;
+    working.removeRows(matchingRows, staged->removedExtents);
+    return 0;
 }
 
-dataContainer2D Search2FieldValue(const std::string& file, const char* field1, const char* key1, const char* field2, const char* key2) {
-    dataContainer2D full = getData(file);
-    if (full.error) { dataContainer2D empty; empty.error = 1; return empty; }
-
-    int index1 = -1, index2 = -1;
-    for (int i = 0; i < full.x; ++i) {
-        if (strcmp(full.fields[i], field1) == 0) index1 = i;
-        if (strcmp(full.fields[i], field2) == 0) index2 = i;
-    }
-    if (index1 == -1 || index2 == -1) {
-        deleteDataContainer2D(full);
-        dataContainer2D empty; empty.error = 1; return empty;
+int Transaction::commit() {
+    WriteAheadLog::Lock lock; // Applies other processes' groups, so their changes show up as conflicts
+    TableCache& cache = TableCache::instance();
+    for (const StagedTable& staged : tables_) {
+        std::shared_ptr<CachedTable> current = cache.current(staged.filename);
+        if (current != staged.base || current->modifiedAt != staged.baseModifiedAt || current->fileSize != staged.baseSize) {
+            std::cerr << "Error: " << staged.filename << " changed during the transaction; nothing was written." << std::endl;
+            rollback();
+            return 1;
+        }
     }
 
-    dataContainer2D result;
-    result.x = full.x;
-    result.y = 0;
-    result.fields = new char*[full.x];
-    for (int i = 0; i < full.x; ++i)
-        result.fields[i] = duplicateString(full.fields[i]);
-
-    result.data = new char**[full.y];
-
-    for (int i = 0; i < full.y; ++i) {
-        if (strcmp(full.data[i][index1], key1) == 0 && strcmp(full.data[i][index2], key2) == 0) {
-            result.data[result.y] = new char*[result.x];
-            for (int j = 0; j < result.x; ++j)
-                result.data[result.y][j] = duplicateString(full.data[i][j]);
-            result.y++;
+    WriteAheadLog& log = WriteAheadLog::instance();
+    log.commit(); // Earlier writes go in their own group
+    log.holdCommits(true);
+    int result = 0;
+    for (StagedTable& staged : tables_) {
+        CachedTable& working = *staged.working;
+        std::vector<int> changedRows;
+        if (!staged.changedRows.empty()) {
+            std::vector<char**> changed(staged.changedRows);
+            std::sort(changed.begin(), changed.end());
+            for (int i = 0; i < working.table.y; ++i) {
+                if (std::binary_search(changed.begin(), changed.end(), working.table.data[i])) changedRows.push_back(i);
+            }
         }
+        cache.install(staged.filename, staged.working);
+        if (writeChangedRows(staged.filename, working, changedRows, staged.removedExtents) != 0) result = 1;
     }
-
-    deleteDataContainer2D(full);
+    log.holdCommits(false);
+    if (log.commit() != 0) result = 1;
+    if (log.apply() != 0) result = 1;
+    tables_.clear();
     return result;
 }
 
+void Transaction::rollback() {
+    tables_.clear();
+}
+
+dataContainer2D Search1FieldValue(const std::string& filenameWithExtension, const char* fieldName, const char* dataToMatch) {
+    return Search1FieldValueView(filenameWithExtension, fieldName, dataToMatch).materialize();
+}
+
+dataContainer2D Search2FieldValue(const std::string& file, const char* field1, const char* key1, const char* field2, const char* key2) {
+    return Search2FieldValueView(file, field1, key1, field2, key2).materialize();
+}
+
 } // namespace CsvToolkit
 
 #endif // CSV_TOOLKIT_HPP
\ No newline at end of file
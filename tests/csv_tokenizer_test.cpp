@@ -0,0 +1,432 @@
+// Differential test: the structural-index tokenizer (indexCsvStructure +
+// tokenizeIndexedLine, and parseCsvChunk on whole buffers) against the scalar
+// reference parseCsvRowScalar, for every scan kernel this machine supports.
+// parseCsvRowScalar is in turn checked against a verbatim copy of the original
+// parseCsvRow, on the lines where the two are meant to agree.
+// Whole files are also loaded serially, in parallel chunks and through
+// CsvReader, and CsvWriter output is read back.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -Wall tests/csv_tokenizer_test.cpp -o csv_tokenizer_test -pthread && ./csv_tokenizer_test
+
+#include "../src/File_exe.hpp"
+
+#include <random>
+
+using namespace CsvToolkit;
+
+namespace {
+
+int failures = 0;
+
+const char* kernelName(CsvScanKernel kernel) {
+    switch (kernel) {
+        case CSV_SCAN_AVX2: return "AVX2";
+        case CSV_SCAN_SSE2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+std::string printable(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '\n') out += "\\n";
+        else if (c == '\r') out += "\\r";
+        else out += c;
+    }
+    return out;
+}
+
+std::vector<std::string> referenceRow(const std::string& line, int expectedFields) {
+    int count = 0;
+    char** tokens = parseCsvRowScalar(line, ',', expectedFields, count);
+    std::vector<std::string> row;
+    for (int i = 0; i < count; ++i) row.push_back(tokens[i]);
+    for (int i = 0; i < expectedFields; ++i) delete[] tokens[i];
+    delete[] tokens;
+    return row;
+}
+
+// The original parseCsvRow, copied verbatim (apart from its name) from the
+// revision before the structural index went in. It is the oracle for the scalar
+// reference. Intended divergences, which checkLine does not hold against it:
+//  1. Inside a quoted field a doubled quote is one literal '"' (RFC 4180); here
+//     each quote toggles, so "" disappears. Lines containing "" are skipped.
+//  2. When the last expected field is the rest of the line and that rest is one
+//     quoted field, the quotes are removed; here it is kept raw, quotes and all.
+//     baselineRow strips them before comparing.
+char** baselineParseCsvRow(const std::string& line, char delimiter, int expectedFields, int& actualTokenCount) {
+    if (expectedFields < 1) {
+        actualTokenCount = 0;
+        return nullptr;
+    }
+
+    char** tokens = new char*[expectedFields];
+    for (int i = 0; i < expectedFields; ++i) {
+        tokens[i] = nullptr;
+    }
+
+    std::string currentTokenBuffer;
+    bool insideQuotes = false;
+    int tokenIndex = 0;
+
+    for (size_t i = 0; i < line.length(); ++i) {
+        char c = line[i];
+
+        if (c == '"') {
+            insideQuotes = !insideQuotes;
+        } else if (c == delimiter && !insideQuotes) {
+            if (tokenIndex < expectedFields) {
+                tokens[tokenIndex] = new char[currentTokenBuffer.length() + 1];
+                strcpy(tokens[tokenIndex], currentTokenBuffer.c_str());
+                tokenIndex++;
+            }
+            currentTokenBuffer.clear();
+
+            if (tokenIndex == expectedFields - 1 && tokenIndex < expectedFields ) {
+                std::string restOfLine = line.substr(i + 1);
+                tokens[tokenIndex] = new char[restOfLine.length() + 1];
+                strcpy(tokens[tokenIndex], restOfLine.c_str());
+                tokenIndex++;
+                actualTokenCount = tokenIndex;
+                return tokens;
+            }
+        } else {
+            currentTokenBuffer += c;
+        }
+    }
+
+    if (tokenIndex < expectedFields && !currentTokenBuffer.empty()) {
+        tokens[tokenIndex] = new char[currentTokenBuffer.length() + 1];
+        strcpy(tokens[tokenIndex], currentTokenBuffer.c_str());
+        tokenIndex++;
+    } else if (tokenIndex < expectedFields && currentTokenBuffer.empty() && line.length() > 0 && line.back() == delimiter && !insideQuotes) {
+        tokens[tokenIndex] = new char[1];
+        tokens[tokenIndex][0] = '\0';
+        tokenIndex++;
+    } else if (tokenIndex < expectedFields && currentTokenBuffer.empty() && line.empty()){
+         tokens[tokenIndex] = new char[1];
+         tokens[tokenIndex][0] = '\0';
+         tokenIndex++;
+    }
+
+    actualTokenCount = tokenIndex;
+    return tokens;
+}
+
+// The oracle's tokens with divergence 2 applied: a quoted rest-of-line field is
+// unquoted. Only the rest-of-line field can still hold a quote here.
+std::vector<std::string> baselineRow(const std::string& line, int expectedFields) {
+    int count = 0;
+    char** tokens = baselineParseCsvRow(line, ',', expectedFields, count);
+    std::vector<std::string> row;
+    for (int i = 0; i < count; ++i) {
+        std::string token = tokens[i];
+        if (i == expectedFields - 1 && isQuotedField(token.data(), token.length())) token = token.substr(1, token.length() - 2);
+        row.push_back(token);
+    }
+    for (int i = 0; i < expectedFields; ++i) delete[] tokens[i];
+    delete[] tokens;
+    return row;
+}
+
+std::vector<std::string> indexedRow(const std::string& line, int expectedFields, CsvScanKernel kernel) {
+    std::vector<size_t> structural;
+    indexCsvStructure(line.data(), line.length(), ',', structural, kernel);
+    std::vector<CellView> views(static_cast<size_t>(expectedFields));
+    int count = tokenizeIndexedLine(line.data(), 0, line.length(), structural.data(), structural.size(), ',', expectedFields, views.data());
+    std::vector<std::string> row;
+    CellArena arena;
+    for (int i = 0; i < count; ++i) row.push_back(materializeCell(line.data(), views[i], arena));
+    return row;
+}
+
+void checkLine(const std::string& line, int expectedFields) {
+    std::vector<std::string> expected = referenceRow(line, expectedFields);
+    if (line.find("\"\"") == std::string::npos && baselineRow(line, expectedFields) != expected) {
+        std::cerr << "FAIL scalar reference differs from the original parseCsvRow for \"" << printable(line) << "\", "
+                  << expectedFields << " fields\n";
+        ++failures;
+    }
+    for (int k = CSV_SCAN_SCALAR; k <= bestCsvScanKernel(); ++k) {
+        CsvScanKernel kernel = static_cast<CsvScanKernel>(k);
+        std::vector<size_t> scalarPositions, kernelPositions;
+        indexCsvStructure(line.data(), line.length(), ',', scalarPositions, CSV_SCAN_SCALAR);
+        indexCsvStructure(line.data(), line.length(), ',', kernelPositions, kernel);
+        if (kernelPositions != scalarPositions) {
+            std::cerr << "FAIL [" << kernelName(kernel) << "] structural positions differ for \"" << printable(line) << "\"\n";
+            ++failures;
+        }
+        if (indexedRow(line, expectedFields, kernel) != expected) {
+            std::cerr << "FAIL [" << kernelName(kernel) << "] tokens differ for \"" << printable(line) << "\", "
+                      << expectedFields << " fields\n";
+            ++failures;
+        }
+    }
+}
+
+// True if a quoted field whose text starts at 'from' has its closing quote.
+bool quoteCloses(const std::string& text, size_t from) {
+    for (size_t i = from; i < text.length(); ++i) {
+        if (text[i] != '"') continue;
+        if (i + 1 < text.length() && text[i + 1] == '"') ++i;
+        else return true;
+    }
+    return false;
+}
+
+// Byte-at-a-time row splitter: rows end at '\n' outside quoted fields. A quote
+// opens a field only at the field's start, and only if it is closed later on.
+std::vector<std::string> referenceRows(const std::string& text) {
+    std::vector<std::string> rows;
+    size_t rowStart = 0;
+    bool quoted = false;
+    for (size_t i = 0; i < text.length(); ++i) {
+        char c = text[i];
+        if (quoted) {
+            if (c != '"') continue;
+            if (i + 1 < text.length() && text[i + 1] == '"') ++i;
+            else quoted = false;
+        } else if (c == '"') {
+            quoted = (i == rowStart || text[i - 1] == ',') && quoteCloses(text, i + 1);
+        } else if (c == '\n') {
+            rows.push_back(text.substr(rowStart, i - rowStart));
+            rowStart = i + 1;
+        }
+    }
+    if (rowStart < text.length()) rows.push_back(text.substr(rowStart));
+    return rows;
+}
+
+// Whole-buffer reference: split into rows, skip empty ones and comments (rows
+// starting with '#'), drop one trailing '\r', tokenize, and pad short rows with
+// empty cells.
+std::vector<std::vector<std::string>> referenceTable(const std::string& text, int fieldCount) {
+    std::vector<std::vector<std::string>> rows;
+    for (std::string line : referenceRows(text)) {
+        if (line.empty() || line[0] == '#') continue;
+        if (line.back() == '\r') line.pop_back();
+        std::vector<std::string> row = referenceRow(line, fieldCount);
+        row.resize(static_cast<size_t>(fieldCount));
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+void checkBuffer(const std::string& text, int fieldCount) {
+    CsvChunk chunk;
+    chunk.begin = 0;
+    chunk.end = text.length();
+    parseCsvChunk(text.data(), fieldCount, chunk);
+
+    std::vector<std::vector<std::string>> actual;
+    CellArena arena;
+    for (size_t r = 0; r < chunk.rows.size(); ++r) {
+        std::vector<std::string> row;
+        for (int j = 0; j < fieldCount; ++j) row.push_back(materializeCell(text.data(), chunk.cells[r * fieldCount + j], arena));
+        actual.push_back(row);
+    }
+    if (actual != referenceTable(text, fieldCount)) {
+        std::cerr << "FAIL [" << kernelName(bestCsvScanKernel()) << "] buffer differs: \"" << printable(text) << "\"\n";
+        ++failures;
+    }
+}
+
+// The same text as a file: loaded with one thread and with several (so it is cut
+// into many ranges), and streamed through CsvReader with a tiny buffer. Rows must
+// come back as 'ordered' has them, which differs from 'body' when rows were moved.
+void checkFile(const fs::path& dir, const std::string& body, const std::string& ordered) {
+    const int fieldCount = 3;
+    {
+        std::ofstream out(dir / "t.csv", std::ios::binary | std::ios::trunc);
+        out << "h1,h2,h3\n" << body;
+    }
+    std::vector<std::vector<std::string>> expected = referenceTable(ordered, fieldCount);
+    std::ostringstream warnings; // Unclosed-quote warnings are expected here
+    std::streambuf* cerrBuffer = std::cerr.rdbuf(warnings.rdbuf());
+
+    std::vector<std::vector<std::string>> loaded[2];
+    for (int t = 0; t < 2; ++t) {
+        CsvViewTable table;
+        if (loadCsvViews("t.csv", table, t == 0 ? 1 : 5) != 0) continue;
+        for (int r = 0; r < table.y; ++r) {
+            std::vector<std::string> row;
+            for (int j = 0; j < table.x; ++j) row.push_back(table.cellString(r, j));
+            loaded[t].push_back(row);
+        }
+    }
+
+    CsvReader reader(16);
+    std::vector<std::vector<std::string>> streamed;
+    if (reader.open("t.csv") == 0) {
+        while (reader.next()) {
+            std::vector<std::string> row;
+            for (int j = 0; j < reader.x(); ++j) row.push_back(reader.cell(j));
+            streamed.push_back(row);
+        }
+    }
+    std::cerr.rdbuf(cerrBuffer);
+
+    for (int t = 0; t < 2; ++t) {
+        if (loaded[t] == expected) continue;
+        std::cerr << "FAIL loadCsvViews with " << (t == 0 ? 1 : 5) << " thread(s) differs: \"" << printable(body) << "\"\n";
+        ++failures;
+    }
+    if (streamed != expected) {
+        std::cerr << "FAIL CsvReader differs: \"" << printable(body) << "\"\n";
+        ++failures;
+    }
+}
+
+void checkFile(const fs::path& dir, const std::string& body) {
+    checkFile(dir, body, body);
+}
+
+// 'rows' (each with its line break) in table order, with those listed in 'moved'
+// appended at the end of the file in that order. Each leaves a row pointer where
+// it belongs, the way writeChangedRows moves a row that outgrew its place.
+void checkMovedRows(const fs::path& dir, const std::vector<std::string>& rows, const std::vector<size_t>& moved) {
+    const size_t headerBytes = 9; // "h1,h2,h3\n"
+    std::string body, ordered;
+    std::vector<size_t> pointerAt(rows.size(), 0);
+    for (size_t r = 0; r < rows.size(); ++r) {
+        ordered += rows[r];
+        if (std::find(moved.begin(), moved.end(), r) == moved.end()) { body += rows[r]; continue; }
+        pointerAt[r] = body.size();
+        body += rowPointerText(0) + "   \n"; // Target filled in below
+    }
+    for (size_t r : moved) {
+        std::string pointer = rowPointerText(headerBytes + body.size());
+        body.replace(pointerAt[r], pointer.size(), pointer);
+        body += rows[r];
+    }
+    checkFile(dir, body, ordered);
+}
+
+// Rows written by CsvWriter read back as the same cells.
+void checkRoundTrip(const std::vector<std::vector<std::string>>& rows, int fieldCount) {
+    std::string text;
+    for (const std::vector<std::string>& row : rows) {
+        std::vector<const char*> values;
+        for (const std::string& cell : row) values.push_back(cell.c_str());
+        CsvWriter::appendRow(text, fieldCount, values.data());
+        text += '\n';
+    }
+    CsvChunk chunk;
+    chunk.begin = 0;
+    chunk.end = text.length();
+    parseCsvChunk(text.data(), fieldCount, chunk);
+
+    std::vector<std::vector<std::string>> actual;
+    CellArena arena;
+    for (size_t r = 0; r < chunk.rows.size(); ++r) {
+        std::vector<std::string> row;
+        for (int j = 0; j < fieldCount; ++j) row.push_back(materializeCell(text.data(), chunk.cells[r * fieldCount + j], arena));
+        actual.push_back(row);
+    }
+    if (actual != rows) {
+        std::cerr << "FAIL CsvWriter output does not read back: \"" << printable(text) << "\"\n";
+        ++failures;
+    }
+}
+
+std::string randomText(std::mt19937& rng, const char* alphabet, size_t maxLength) {
+    size_t alphabetSize = strlen(alphabet);
+    size_t length = rng() % (maxLength + 1);
+    std::string text;
+    for (size_t i = 0; i < length; ++i) text += alphabet[rng() % alphabetSize];
+    return text;
+}
+
+} // namespace
+
+int main() {
+    const char* lines[] = {
+        "",
+        ",",
+        ",,",
+        "a,b,c",
+        "a,b,",
+        "\"quoted, with comma\",b,c",
+        "\"say \"\"hi\"\"\",b",
+        "\"\"\"\"",
+        "a,\"\",c",
+        "a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p,q,r,s,t,u,v,w,x,y,z",
+        "T001,Team,Uni,MY,2025-01-01,09:00,0,Registered,,Pending,rest,of,the,line",
+        "T001,Team,\"last, field\"",
+        "T001,Team,\"last \"\"quoted\"\" field\"",
+        "T001,Team,\"not\" one field",
+        "\"unclosed,quote,runs,to,the,end,of,the,line,past,thirty,two,bytes",
+        "0123456789012345678901234567890,\"crosses a 32-byte block\",x",
+    };
+    for (const char* line : lines) {
+        for (int fields = 1; fields <= 6; ++fields) checkLine(line, fields);
+    }
+
+    const char* buffers[] = {
+        "a,b,c\r\nd,e,f\r\n",
+        "a,b,c\r\n\r\nd,e\r\n",
+        "\r\n\r\na,\"b,c\"\r\n",
+        "a,\"x\"\"y\",c\nd,\"e\r\",f\r\n",
+        "only\n",
+        "a,b,c,d,e,f\n1,2\n",
+        "a,b,Pending   \nc,d,\"x \"    \n",
+        "a,\"two\nlines\",c\nd,e,f\n",
+        "a,\"crlf\r\ninside\",c\r\nd,e,f\r\n",
+        "\"\nleading\",b\n\"\"\"\n\"\"\",c\n",
+        "a,b,\"last\n\nfield\"\nc,d\n",
+        "a,\"never closed\nb,c\nd,e\n",
+        "a,5\" screen\nb,\"c\nd\"\n",
+        "a,b,c\n#       \nd,e,f\n#\n",
+        "a,b,c\r\n#  \r\n#\r\nd,e,f\r\n",
+        "\"#quoted\",b\n#c,\"d\ne\"\nf,#g\n",
+    };
+    for (const char* buffer : buffers) {
+        for (int fields = 1; fields <= 4; ++fields) checkBuffer(buffer, fields);
+    }
+
+    // Random lines long enough to cross the 16- and 32-byte block edges.
+    std::mt19937 rng(20250601u);
+    for (int i = 0; i < 20000; ++i) {
+        checkLine(randomText(rng, "ab,,\"\" \r\n", 80), 1 + static_cast<int>(rng() % 8));
+        checkBuffer(randomText(rng, "ab,,\"\" #\r\n", 120), 1 + static_cast<int>(rng() % 6));
+    }
+    // Lines without a doubled quote, so most of them reach the original parser too.
+    for (int i = 0; i < 20000; ++i) {
+        std::string line = randomText(rng, "ab,,\" ", 60);
+        for (size_t q = line.find("\"\""); q != std::string::npos; q = line.find("\"\"")) line.erase(q, 1);
+        checkLine(line, 1 + static_cast<int>(rng() % 8));
+    }
+
+    for (int i = 0; i < 2000; ++i) {
+        int fieldCount = 2 + static_cast<int>(rng() % 4);
+        std::vector<std::vector<std::string>> rows(1 + rng() % 6);
+        for (std::vector<std::string>& row : rows) {
+            for (int j = 0; j < fieldCount; ++j) row.push_back(randomText(rng, "ab,\" #\r\n", 6));
+        }
+        checkRoundTrip(rows, fieldCount);
+    }
+
+    fs::path dir = fs::temp_directory_path() / "csv_tokenizer_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    DataStore::instance().setRoot(dir);
+    for (const char* buffer : buffers) checkFile(dir, buffer);
+    for (int i = 0; i < 2000; ++i) checkFile(dir, randomText(rng, "ab,,,\"\" #\r\n\n", 200));
+    checkMovedRows(dir, { "a,b,c\n", "d,\"e\nf\",g\n", "h,i,j\n" }, { 1 });
+    checkMovedRows(dir, { "a,b,c\n", "d,e,f\n", "g,h,i\n", "j,k,l\n" }, { 2, 0 });
+    checkMovedRows(dir, { "a,b,c\r\n", "d,e,f\r\n", "g,h,i\r\n" }, { 0, 1, 2 });
+    // Pointers the loaders must ignore: into the middle of a row, back to an
+    // earlier row, and to a comment.
+    checkFile(dir, "a,b,c\n" + rowPointerText(10) + "\nd,e,f\n", "a,b,c\nd,e,f\n");
+    checkFile(dir, "a,b,c\n" + rowPointerText(9) + "\nd,e,f\n", "a,b,c\nd,e,f\n");
+    checkFile(dir, "a,b,c\n" + rowPointerText(30) + "\n#\nd,e,f\n", "a,b,c\nd,e,f\n");
+    fs::remove_all(dir);
+
+    if (failures > 0) {
+        std::cerr << failures << " tokenizer mismatches\n";
+        return 1;
+    }
+    std::cout << "csv_tokenizer_test: all cases match (kernels up to " << kernelName(bestCsvScanKernel()) << ")\n";
+    return 0;
+}